@@ -0,0 +1,249 @@
+#include "pch.h"
+#include "action_call_task.h"
+#include "action_call_task_s11n_block.h"
+#include "action_list.h"
+#include "service_manager.h"
+#include "combo_helpers.h"
+#include "guid_helpers.h"
+
+ActionCallTask::ActionCallTask() : m_actionListGUID(pfc::guid_null)
+{
+}
+
+GUID ActionCallTask::GetPrototypeGUID() const
+{
+	// {5716d65b-4991-460a-9017-13692f9f78e8} mod guid
+	static const GUID result =
+	{ 0x5716d65b, 0x4991, 0x460a, { 0x90, 0x17, 0x13, 0x69, 0x2f, 0x9f, 0x78, 0xe8 } };
+
+	return result;
+}
+
+int ActionCallTask::GetPriority() const
+{
+	return 60;
+}
+
+std::wstring ActionCallTask::GetName() const
+{
+	return L"Call task";
+}
+
+IAction* ActionCallTask::Clone() const
+{
+	return new ActionCallTask(*this);
+}
+
+std::wstring ActionCallTask::GetDescription() const
+{
+	return L"Call task \"" + GetActionListName() + L"\"";
+}
+
+bool ActionCallTask::HasConfigDialog() const
+{
+	return true;
+}
+
+bool ActionCallTask::ShowConfigDialog(CWindow parent)
+{
+	// Without the edited tasks the applied ones are listed, calls back to the owner can't be detected.
+	return ShowConfigDialog(parent, ServiceManager::Instance().GetModel().GetActionLists(), pfc::guid_null);
+}
+
+bool ActionCallTask::ShowConfigDialog(CWindow parent, const std::vector<ActionList*>& actionLists, const GUID& ownerGUID)
+{
+	ActionCallTaskEditor dlg(*this, actionLists, ownerGUID);
+	return dlg.DoModal(parent) == IDOK;
+}
+
+ActionExecSessionPtr ActionCallTask::CreateExecSession() const
+{
+	return ActionExecSessionPtr(new ExecSession(*this));
+}
+
+void ActionCallTask::LoadFromS11nBlock(const ActionS11nBlock& block)
+{
+	if (!block.callTask.Exists())
+		return;
+
+	const ActionCallTaskS11nBlock& b = block.callTask.GetValue();
+	b.actionListGUID.GetValueIfExists(m_actionListGUID);
+
+	if (b.actionListName.Exists())
+		m_actionListName = pfc::stringcvt::string_wide_from_utf8(b.actionListName.GetValue()).get_ptr();
+}
+
+void ActionCallTask::SaveToS11nBlock(ActionS11nBlock& block) const
+{
+	ActionCallTaskS11nBlock b;
+
+	b.actionListGUID.SetValue(m_actionListGUID);
+	b.actionListName.SetValue(pfc::stringcvt::string_utf8_from_wide(m_actionListName.c_str()).toString());
+
+	block.callTask.SetValue(b);
+}
+
+const GUID& ActionCallTask::GetActionListGUID() const
+{
+	return m_actionListGUID;
+}
+
+std::wstring ActionCallTask::GetActionListName() const
+{
+	// The stored name is the one at the time of editing, the task might have been renamed since.
+	if (ActionList* pActionList = ServiceManager::Instance().GetModel().GetActionListByGUID(m_actionListGUID))
+		return pActionList->GetName();
+
+	return m_actionListName;
+}
+
+void ActionCallTask::SetActionList(const GUID& guid, const std::wstring& name)
+{
+	m_actionListGUID = guid;
+	m_actionListName = name;
+}
+
+bool ActionCallTask::CallsActionList(const std::vector<ActionList*>& actionLists, const GUID& fromGUID,
+	const GUID& targetGUID)
+{
+	GUIDHelpers::Index<ActionList>::Type index;
+
+	for (std::size_t i = 0; i < actionLists.size(); ++i)
+		index[actionLists[i]->GetGUID()] = actionLists[i];
+
+	// Depth first over the call actions, each task is visited once, so existing loops don't hang it.
+	std::unordered_set<GUID, GUIDHelpers::Hash> visited;
+	std::vector<GUID> pending(1, fromGUID);
+
+	while (!pending.empty())
+	{
+		const GUID guid = pending.back();
+		pending.pop_back();
+
+		if (guid == targetGUID)
+			return true;
+
+		if (!visited.insert(guid).second)
+			continue;
+
+		auto it = index.find(guid);
+
+		if (it == index.end())
+			continue;
+
+		std::vector<IAction*> actions = it->second->GetActions();
+
+		for (std::size_t i = 0; i < actions.size(); ++i)
+		{
+			if (const ActionCallTask* pCall = dynamic_cast<const ActionCallTask*>(actions[i]))
+				pending.push_back(pCall->GetActionListGUID());
+		}
+	}
+
+	return false;
+}
+
+namespace
+{
+	const bool registered = ServiceManager::Instance().GetActionPrototypesManager().RegisterPrototype(
+		new ActionCallTask);
+}
+
+//------------------------------------------------------------------------------
+// ActionCallTask::ExecSession
+//------------------------------------------------------------------------------
+
+ActionCallTask::ExecSession::ExecSession(const ActionCallTask& action) : m_action(action)
+{
+}
+
+void ActionCallTask::ExecSession::Run(const AsyncCall::CallbackPtr& completionCall)
+{
+	// The called task runs once this action has completed.
+	if (!m_alesFuncs->CallActionList(m_action.GetActionListGUID()))
+	{
+		console::formatter() << COMPONENT_NAME ": can't call task \"" <<
+			pfc::stringcvt::string_utf8_from_wide(m_action.GetActionListName().c_str()) <<
+			"\", it doesn't exist or is already running in this call chain";
+	}
+
+	AsyncCall::AsyncRunInMainThread(completionCall);
+}
+
+const IAction* ActionCallTask::ExecSession::GetParentAction() const
+{
+	return &m_action;
+}
+
+void ActionCallTask::ExecSession::Init(IActionListExecSessionFuncs& alesFuncs)
+{
+	m_alesFuncs = &alesFuncs;
+}
+
+bool ActionCallTask::ExecSession::GetCurrentStateDescription(std::wstring& /*descr*/) const
+{
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// ActionCallTaskEditor
+//------------------------------------------------------------------------------
+
+ActionCallTaskEditor::ActionCallTaskEditor(ActionCallTask& action, const std::vector<ActionList*>& actionLists,
+	const GUID& ownerGUID) :
+	m_action(action), m_actionLists(actionLists), m_ownerGUID(ownerGUID)
+{
+}
+
+BOOL ActionCallTaskEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
+{
+	std::vector<std::pair<std::wstring, int>> comboItems;
+	int selected = -1;
+
+	for (std::size_t i = 0; i < m_actionLists.size(); ++i)
+	{
+		// A task calling itself is not offered, longer loops are reported on OK.
+		if (m_actionLists[i]->GetGUID() == m_ownerGUID)
+			continue;
+
+		if (m_actionLists[i]->GetGUID() == m_action.GetActionListGUID())
+			selected = static_cast<int>(i);
+
+		comboItems.push_back(std::make_pair(m_actionLists[i]->GetName(), static_cast<int>(i)));
+	}
+
+	m_actionListsCombo = GetDlgItem(IDC_COMBO_CALL_TASK);
+	ComboHelpers::InitCombo(m_actionListsCombo, comboItems, selected);
+
+	CenterWindow(GetParent());
+
+	// dark mode
+	m_dark.AddDialogWithControls(m_hWnd);
+
+	return TRUE;
+}
+
+void ActionCallTaskEditor::OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	if (nID == IDOK)
+	{
+		if (m_actionListsCombo.GetCurSel() == CB_ERR)
+		{
+			m_popupTooltipMsg.Show(L"Select a task.", m_actionListsCombo);
+			return;
+		}
+
+		const ActionList* pActionList = m_actionLists[ComboHelpers::GetSelectedItem<int>(m_actionListsCombo)];
+
+		if (m_ownerGUID != pfc::guid_null &&
+			ActionCallTask::CallsActionList(m_actionLists, pActionList->GetGUID(), m_ownerGUID))
+		{
+			m_popupTooltipMsg.Show(L"The task calls this one, the calls would never end.", m_actionListsCombo);
+			return;
+		}
+
+		m_action.SetActionList(pActionList->GetGUID(), pActionList->GetName());
+	}
+
+	EndDialog(nID);
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "resource.h"
+#include "action.h"
+#include "popup_tooltip_message.h"
+
+class ActionList;
+
+//------------------------------------------------------------------------------
+// ActionCallTask
+//------------------------------------------------------------------------------
+
+// Runs another task by reference, then continues with the next action.
+// The called task is shared, not copied into the calling one.
+class ActionCallTask : public IAction
+{
+public:
+	class ExecSession : public IActionExecSession
+	{
+	public:
+		explicit ExecSession(const ActionCallTask& action);
+
+		virtual void Init(IActionListExecSessionFuncs& alesFuncs);
+		virtual void Run(const AsyncCall::CallbackPtr& completionCall);
+		virtual const IAction* GetParentAction() const;
+		virtual bool GetCurrentStateDescription(std::wstring& descr) const;
+
+	private:
+		const ActionCallTask& m_action;
+		IActionListExecSessionFuncs* m_alesFuncs = nullptr;
+	};
+
+	ActionCallTask();
+
+	const GUID& GetActionListGUID() const;
+	std::wstring GetActionListName() const;
+	void SetActionList(const GUID& guid, const std::wstring& name);
+
+	// The editor lists actionLists, ownerGUID is the task the action belongs to.
+	bool ShowConfigDialog(CWindow parent, const std::vector<ActionList*>& actionLists, const GUID& ownerGUID);
+
+	// Returns true if running the task fromGUID runs the task targetGUID through call actions.
+	static bool CallsActionList(const std::vector<ActionList*>& actionLists, const GUID& fromGUID,
+		const GUID& targetGUID);
+
+public: // IAction
+	virtual GUID GetPrototypeGUID() const;
+	virtual int GetPriority() const;
+	virtual std::wstring GetName() const;
+	virtual IAction* Clone() const;
+
+	virtual std::wstring GetDescription() const;
+	virtual bool HasConfigDialog() const;
+	virtual bool ShowConfigDialog(CWindow parent);
+	virtual ActionExecSessionPtr CreateExecSession() const;
+
+	virtual void LoadFromS11nBlock(const ActionS11nBlock& block);
+	virtual void SaveToS11nBlock(ActionS11nBlock& block) const;
+
+private:
+	GUID m_actionListGUID;
+	std::wstring m_actionListName;
+};
+
+//------------------------------------------------------------------------------
+// ActionCallTaskEditor
+//------------------------------------------------------------------------------
+
+class ActionCallTaskEditor : public CDialogImpl<ActionCallTaskEditor>
+{
+public:
+	enum { IDD = IDD_ACTION_CALL_TASK_CONFIG };
+
+	ActionCallTaskEditor(ActionCallTask& action, const std::vector<ActionList*>& actionLists, const GUID& ownerGUID);
+
+private:
+	BEGIN_MSG_MAP_EX(ActionCallTaskEditor)
+		MSG_WM_INITDIALOG(OnInitDialog)
+		COMMAND_ID_HANDLER_EX(IDOK,     OnCloseCmd)
+		COMMAND_ID_HANDLER_EX(IDCANCEL, OnCloseCmd)
+	END_MSG_MAP()
+
+	BOOL OnInitDialog(CWindow wndFocus, LPARAM lInitParam);
+	void OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl);
+
+private:
+	ActionCallTask& m_action;
+	const std::vector<ActionList*>& m_actionLists;
+	GUID m_ownerGUID;
+
+	CComboBox m_actionListsCombo;
+
+	PopupTooltipMessage m_popupTooltipMsg;
+	fb2k::CDarkModeHooks m_dark;
+};
\ No newline at end of file
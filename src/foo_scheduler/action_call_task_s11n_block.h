@@ -0,0 +1,15 @@
+#pragma once
+
+#include "s11n_blocks.h"
+
+struct ActionCallTaskS11nBlock : public S11nBlocks::Block<ActionCallTaskS11nBlock>
+{
+	S11nBlocks::Field<GUID, 1> actionListGUID;
+	S11nBlocks::Field<pfc::string8, 2> actionListName; // Shown if the task isn't found.
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(actionListGUID)(actionListName);
+	}
+};
\ No newline at end of file
@@ -1,7 +1,6 @@
 #include "pch.h"
 #include "action_change_playlist.h"
 #include "action_change_playlist_s11n_block.h"
-#include "action_save_playback_state.h"
 #include "service_manager.h"
 #include "scope_exit_function.h"
 
@@ -156,8 +155,7 @@ void ActionChangePlaylist::ExecSession::Run(const AsyncCall::CallbackPtr& comple
 		break;
 	case ActionChangePlaylist::ctSavedState:
 		{
-			const boost::any playlistAny = m_alesFuncs->GetValue(ActionSavePlaybackState::GetPlaylistKey());
-			const t_size* playlist = boost::any_cast<t_size>(&playlistAny);
+			const t_size* playlist = boost::get<t_size>(&m_alesFuncs->GetValue(SessionValues::keySavedPlaylist));
 
 			if (!playlist)
 				return;
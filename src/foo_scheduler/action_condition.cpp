@@ -0,0 +1,217 @@
+#include "pch.h"
+#include "action_condition.h"
+#include "action_condition_s11n_block.h"
+#include "service_manager.h"
+#include "scope_exit_function.h"
+
+ActionCondition::ActionCondition() : m_thenCount(1), m_elseCount(0)
+{
+}
+
+GUID ActionCondition::GetPrototypeGUID() const
+{
+	// {9508063d-95dc-4ca7-8cc3-7b93acd54852} mod guid
+	static const GUID result = 
+	{ 0x9508063d, 0x95dc, 0x4ca7, { 0x8c, 0xc3, 0x7b, 0x93, 0xac, 0xd5, 0x48, 0x52 } };
+
+	return result;
+}
+
+int ActionCondition::GetPriority() const
+{
+	return 55;
+}
+
+std::wstring ActionCondition::GetName() const
+{
+	return L"If condition";
+}
+
+IAction* ActionCondition::Clone() const
+{
+	return new ActionCondition(*this);
+}
+
+std::wstring ActionCondition::GetDescription() const
+{
+	std::wstring result = boost::str(boost::wformat(L"If %1%: run the next %2% action(s)") %
+		(m_condition.IsEmpty() ? std::wstring(L"true") : m_condition.GetText()) % m_thenCount);
+
+	if (m_elseCount > 0)
+		result += boost::str(boost::wformat(L", otherwise the %1% after them") % m_elseCount);
+
+	return result;
+}
+
+bool ActionCondition::HasConfigDialog() const
+{
+	return true;
+}
+
+bool ActionCondition::ShowConfigDialog(CWindow parent)
+{
+	ActionConditionEditor dlg(*this);
+	return dlg.DoModal(parent) == IDOK;
+}
+
+ActionExecSessionPtr ActionCondition::CreateExecSession() const
+{
+	return ActionExecSessionPtr(new ExecSession(*this));
+}
+
+void ActionCondition::LoadFromS11nBlock(const ActionS11nBlock& block)
+{
+	if (!block.condition.Exists())
+		return;
+
+	const ActionConditionS11nBlock& b = block.condition.GetValue();
+
+	if (b.condition.Exists())
+	{
+		std::wstring error;
+		m_condition.Compile(pfc::stringcvt::string_wide_from_utf8(b.condition.GetValue()).get_ptr(), error);
+	}
+
+	b.thenCount.GetValueIfExists(m_thenCount);
+	b.elseCount.GetValueIfExists(m_elseCount);
+}
+
+void ActionCondition::SaveToS11nBlock(ActionS11nBlock& block) const
+{
+	ActionConditionS11nBlock b;
+
+	b.condition.SetValue(pfc::stringcvt::string_utf8_from_wide(m_condition.GetText().c_str()).toString());
+	b.thenCount.SetValue(m_thenCount);
+	b.elseCount.SetValue(m_elseCount);
+
+	block.condition.SetValue(b);
+}
+
+const Condition& ActionCondition::GetCondition() const
+{
+	return m_condition;
+}
+
+void ActionCondition::SetCondition(const Condition& condition)
+{
+	m_condition = condition;
+}
+
+int ActionCondition::GetThenCount() const
+{
+	return m_thenCount;
+}
+
+void ActionCondition::SetThenCount(int count)
+{
+	m_thenCount = count;
+}
+
+int ActionCondition::GetElseCount() const
+{
+	return m_elseCount;
+}
+
+void ActionCondition::SetElseCount(int count)
+{
+	m_elseCount = count;
+}
+
+namespace
+{
+	const bool registered = ServiceManager::Instance().GetActionPrototypesManager().RegisterPrototype(
+		new ActionCondition);
+}
+
+//------------------------------------------------------------------------------
+// ActionCondition::ExecSession
+//------------------------------------------------------------------------------
+
+ActionCondition::ExecSession::ExecSession(const ActionCondition& action) : m_action(action)
+{
+}
+
+void ActionCondition::ExecSession::Run(const AsyncCall::CallbackPtr& completionCall)
+{
+	ScopeExitFunction scopeExit(boost::bind(&AsyncCall::AsyncRunInMainThread, completionCall));
+
+	if (m_action.GetCondition().Evaluate())
+		m_alesFuncs->SkipActions(m_action.GetThenCount(), m_action.GetElseCount());
+	else
+		m_alesFuncs->SkipActions(0, m_action.GetThenCount());
+}
+
+const IAction* ActionCondition::ExecSession::GetParentAction() const
+{
+	return &m_action;
+}
+
+void ActionCondition::ExecSession::Init(IActionListExecSessionFuncs& alesFuncs)
+{
+	m_alesFuncs = &alesFuncs;
+}
+
+bool ActionCondition::ExecSession::GetCurrentStateDescription(std::wstring& /*descr*/) const
+{
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// ActionConditionEditor
+//------------------------------------------------------------------------------
+
+ActionConditionEditor::ActionConditionEditor(ActionCondition& action) : m_action(action)
+{
+}
+
+BOOL ActionConditionEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
+{
+	SetDlgItemText(IDC_EDIT_CONDITION, m_action.GetCondition().GetText().c_str());
+	SetDlgItemInt(IDC_EDIT_THEN_COUNT, m_action.GetThenCount(), FALSE);
+	SetDlgItemInt(IDC_EDIT_ELSE_COUNT, m_action.GetElseCount(), FALSE);
+
+	CenterWindow(GetParent());
+
+	// dark mode
+	m_dark.AddDialogWithControls(m_hWnd);
+
+	return TRUE;
+}
+
+void ActionConditionEditor::OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	if (nID == IDOK)
+	{
+		CString text;
+		GetDlgItemText(IDC_EDIT_CONDITION, text);
+
+		Condition condition;
+		std::wstring error;
+
+		if (!condition.Compile(text.GetString(), error))
+		{
+			m_popupTooltipMsg.Show(error.c_str(), GetDlgItem(IDC_EDIT_CONDITION));
+			return;
+		}
+
+		const int thenCount = GetDlgItemInt(IDC_EDIT_THEN_COUNT, NULL, FALSE);
+		if (thenCount < 0 || thenCount > ActionCondition::s_maxCount)
+		{
+			m_popupTooltipMsg.Show(L"Invalid value.", GetDlgItem(IDC_EDIT_THEN_COUNT));
+			return;
+		}
+
+		const int elseCount = GetDlgItemInt(IDC_EDIT_ELSE_COUNT, NULL, FALSE);
+		if (elseCount < 0 || elseCount > ActionCondition::s_maxCount)
+		{
+			m_popupTooltipMsg.Show(L"Invalid value.", GetDlgItem(IDC_EDIT_ELSE_COUNT));
+			return;
+		}
+
+		m_action.SetCondition(condition);
+		m_action.SetThenCount(thenCount);
+		m_action.SetElseCount(elseCount);
+	}
+
+	EndDialog(nID);
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "resource.h"
+#include "action.h"
+#include "condition.h"
+#include "popup_tooltip_message.h"
+
+//------------------------------------------------------------------------------
+// ActionCondition
+//------------------------------------------------------------------------------
+
+// If the condition is true, the next "then" actions run and the following "else" actions are skipped.
+// Otherwise the "then" actions are skipped and the "else" actions run.
+class ActionCondition : public IAction
+{
+public:
+	class ExecSession : public IActionExecSession
+	{
+	public:
+		explicit ExecSession(const ActionCondition& action);
+
+		virtual void Init(IActionListExecSessionFuncs& alesFuncs);
+		virtual void Run(const AsyncCall::CallbackPtr& completionCall);
+		virtual const IAction* GetParentAction() const;
+		virtual bool GetCurrentStateDescription(std::wstring& descr) const;
+
+	private:
+		const ActionCondition& m_action;
+		IActionListExecSessionFuncs* m_alesFuncs = nullptr;
+	};
+
+	ActionCondition();
+
+	const Condition& GetCondition() const;
+	void SetCondition(const Condition& condition);
+
+	int GetThenCount() const;
+	void SetThenCount(int count);
+
+	int GetElseCount() const;
+	void SetElseCount(int count);
+
+	static const int s_maxCount = 1000;
+
+public: // IAction
+	virtual GUID GetPrototypeGUID() const;
+	virtual int GetPriority() const;
+	virtual std::wstring GetName() const;
+	virtual IAction* Clone() const;
+
+	virtual std::wstring GetDescription() const;
+	virtual bool HasConfigDialog() const;
+	virtual bool ShowConfigDialog(CWindow parent);
+	virtual ActionExecSessionPtr CreateExecSession() const;
+
+	virtual void LoadFromS11nBlock(const ActionS11nBlock& block);
+	virtual void SaveToS11nBlock(ActionS11nBlock& block) const;
+
+private:
+	Condition m_condition;
+	int m_thenCount;
+	int m_elseCount;
+};
+
+//------------------------------------------------------------------------------
+// ActionConditionEditor
+//------------------------------------------------------------------------------
+
+class ActionConditionEditor : public CDialogImpl<ActionConditionEditor>
+{
+public:
+	enum { IDD = IDD_ACTION_CONDITION_CONFIG };
+
+	explicit ActionConditionEditor(ActionCondition& action);
+
+private:
+	BEGIN_MSG_MAP_EX(ActionConditionEditor)
+		MSG_WM_INITDIALOG(OnInitDialog)
+		COMMAND_ID_HANDLER_EX(IDOK,     OnCloseCmd)
+		COMMAND_ID_HANDLER_EX(IDCANCEL, OnCloseCmd)
+	END_MSG_MAP()
+
+	BOOL OnInitDialog(CWindow wndFocus, LPARAM lInitParam);
+	void OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl);
+
+private:
+	ActionCondition& m_action;
+
+	PopupTooltipMessage m_popupTooltipMsg;
+	fb2k::CDarkModeHooks m_dark;
+};
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "s11n_blocks.h"
+
+struct ActionConditionS11nBlock : public S11nBlocks::Block<ActionConditionS11nBlock>
+{
+	S11nBlocks::Field<pfc::string8, 1> condition;
+	S11nBlocks::Field<int, 2> thenCount;
+	S11nBlocks::Field<int, 3> elseCount;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(condition)(thenCount)(elseCount);
+	}
+};
\ No newline at end of file
@@ -137,7 +137,7 @@ void ActionDelay::ExecSession::Run(const AsyncCall::CallbackPtr& completionCall)
 	m_secondsLeft = static_cast<int>(duration.total_seconds());
 
 	m_timerID = ServiceManager::Instance().GetTimersManager().CreateTimer(
-		boost::posix_time::second_clock::local_time() + boost::posix_time::seconds(1), boost::posix_time::seconds(1), false);
+		boost::posix_time::seconds(1), boost::posix_time::seconds(1), false);
 
 	AsyncCall::CallbackPtr pTimerCallback = 
 		AsyncCall::MakeCallback<ActionDelay::ExecSession>(shared_from_this(),
@@ -148,6 +148,15 @@ void ActionDelay::ExecSession::Run(const AsyncCall::CallbackPtr& completionCall)
 	ServiceManager::Instance().GetTimersManager().StartTimer(m_timerID, pTimerCallback);
 }
 
+void ActionDelay::ExecSession::Cancel()
+{
+	if (m_timerID == TimersManager::invalidTimerID)
+		return;
+
+	ServiceManager::Instance().GetTimersManager().CloseTimer(m_timerID);
+	m_timerID = TimersManager::invalidTimerID;
+}
+
 const IAction* ActionDelay::ExecSession::GetParentAction() const
 {
 	return &m_action;
@@ -155,6 +164,10 @@ const IAction* ActionDelay::ExecSession::GetParentAction() const
 
 void ActionDelay::ExecSession::OnTimer()
 {
+	// The timer has been closed after this call was queued.
+	if (m_timerID == TimersManager::invalidTimerID)
+		return;
+
 	--m_secondsLeft;
 
     m_alesFuncs->UpdateDescription();
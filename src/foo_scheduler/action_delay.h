@@ -22,6 +22,7 @@ public:
 
 		virtual void Init(IActionListExecSessionFuncs& alesFuncs);
 		virtual void Run(const AsyncCall::CallbackPtr& completionCall);
+		virtual void Cancel();
 		virtual const IAction* GetParentAction() const;
 		virtual bool GetCurrentStateDescription(std::wstring& descr) const;
 
@@ -1,6 +1,31 @@
 #pragma once
 
 #include "async_call.h"
+#include "session_values.h"
+
+//------------------------------------------------------------------------------
+// CancellationToken
+//------------------------------------------------------------------------------
+
+// Shared by all copies, may be checked from any thread.
+class CancellationToken
+{
+public:
+	CancellationToken() : m_pCancelled(new std::atomic<bool>(false)) {}
+
+	void Cancel() const
+	{
+		m_pCancelled->store(true);
+	}
+
+	bool IsCancelled() const
+	{
+		return m_pCancelled->load();
+	}
+
+private:
+	boost::shared_ptr<std::atomic<bool>> m_pCancelled;
+};
 
 //------------------------------------------------------------------------------
 // IActionListExecSessionDelegate
@@ -11,11 +36,21 @@ class ActionListExecSession;
 class IActionListExecSessionFuncs
 {
 public:
-    virtual boost::any GetValue(const std::string &key) const = 0;
-    virtual void SetValue(const std::string &key, const boost::any &value) = 0;
+    virtual const SessionValues::Value& GetValue(SessionValues::Key key) const = 0;
+    virtual void SetValue(SessionValues::Key key, const SessionValues::Value& value) = 0;
     virtual void UpdateDescription() = 0;
+
+	// Skips count actions, starting offset actions after the current one, in this run of the list.
+	virtual void SkipActions(int offset, int count) = 0;
 	virtual ActionListExecSession& GetActionListExecSession() = 0;
 
+	// Runs the action list after the current action, then continues with the next action of the current list.
+	// Returns false if the action list doesn't exist or is already being run in this session.
+	virtual bool CallActionList(const GUID& actionListGUID) = 0;
+
+	// Cancelled when the session is stopped, actions must not call their completion call after that.
+	virtual const CancellationToken& GetCancellationToken() const = 0;
+
 protected:
     ~IActionListExecSessionFuncs() {}
 };
@@ -35,6 +70,9 @@ struct IActionExecSession
 	// completionCall is called after an action has been completed.
 	virtual void Run(const AsyncCall::CallbackPtr& completionCall) = 0;
 
+	// Stops the action without waiting, the session may be destroyed later.
+	virtual void Cancel() {}
+
 	// Returns an action that has created this session.
 	virtual const IAction* GetParentAction() const = 0;
 
@@ -1,12 +1,18 @@
 #include "pch.h"
 #include "action_launch_app.h"
 #include "service_manager.h"
+#include "version.h"
 
 //------------------------------------------------------------------------------
 // ActionLaunchApp
 //------------------------------------------------------------------------------
 
-ActionLaunchApp::ActionLaunchApp()
+namespace
+{
+	const int maxTimeout = 24 * 60 * 60;
+}
+
+ActionLaunchApp::ActionLaunchApp() : m_waitForExit(false), m_timeout(0), m_captureOutput(false)
 {
 
 }
@@ -21,6 +27,36 @@ void ActionLaunchApp::SetCommandLine(const std::wstring& val)
 	m_commandLine = val;
 }
 
+bool ActionLaunchApp::GetWaitForExit() const
+{
+	return m_waitForExit;
+}
+
+void ActionLaunchApp::SetWaitForExit(bool val)
+{
+	m_waitForExit = val;
+}
+
+int ActionLaunchApp::GetTimeout() const
+{
+	return m_timeout;
+}
+
+void ActionLaunchApp::SetTimeout(int val)
+{
+	m_timeout = val;
+}
+
+bool ActionLaunchApp::GetCaptureOutput() const
+{
+	return m_captureOutput;
+}
+
+void ActionLaunchApp::SetCaptureOutput(bool val)
+{
+	m_captureOutput = val;
+}
+
 GUID ActionLaunchApp::GetPrototypeGUID() const
 {
 	// {cb3bb06a-cfef-4abb-8456-24b5f5d784dd} 
@@ -47,7 +83,18 @@ IAction* ActionLaunchApp::Clone() const
 
 std::wstring ActionLaunchApp::GetDescription() const
 {
-	return boost::str(boost::wformat(L"Launch \"%1%\"") % m_commandLine);
+	std::wstring result = boost::str(boost::wformat(L"Launch \"%1%\"") % m_commandLine);
+
+	if (m_waitForExit)
+	{
+		result += m_timeout > 0 ?
+			boost::str(boost::wformat(L" and wait up to %1% s") % m_timeout) : L" and wait";
+
+		if (m_captureOutput)
+			result += L", capture output";
+	}
+
+	return result;
 }
 
 bool ActionLaunchApp::HasConfigDialog() const
@@ -75,6 +122,12 @@ void ActionLaunchApp::LoadFromS11nBlock(const ActionS11nBlock& block)
 
 	if (b.commandLine.Exists())
 		m_commandLine = pfc::stringcvt::string_wide_from_utf8(b.commandLine.GetValue()).get_ptr();
+
+	b.waitForExit.GetValueIfExists(m_waitForExit);
+	b.captureOutput.GetValueIfExists(m_captureOutput);
+
+	if (b.timeout.Exists())
+		m_timeout = std::min(std::max(b.timeout.GetValue(), 0), maxTimeout);
 }
 
 void ActionLaunchApp::SaveToS11nBlock(ActionS11nBlock& block) const
@@ -82,6 +135,14 @@ void ActionLaunchApp::SaveToS11nBlock(ActionS11nBlock& block) const
 	ActionLaunchAppS11nBlock b;
 
 	b.commandLine.SetValue(pfc::stringcvt::string_utf8_from_wide(m_commandLine.c_str()).toString());
+
+	if (m_waitForExit)
+	{
+		b.waitForExit.SetValue(m_waitForExit);
+		b.timeout.SetValue(m_timeout);
+		b.captureOutput.SetValue(m_captureOutput);
+	}
+
 	block.launchApp.SetValue(b);
 }
 
@@ -95,17 +156,88 @@ namespace
 // ActionLaunchApp::ExecSession
 //------------------------------------------------------------------------------
 
-ActionLaunchApp::ExecSession::ExecSession(const ActionLaunchApp& action) : m_action(action)
+ActionLaunchApp::ExecSession::ExecSession(const ActionLaunchApp& action) :
+	m_action(action), m_alesFuncs(0), m_waiting(false)
 {
 
 }
 
 void ActionLaunchApp::ExecSession::Run(const AsyncCall::CallbackPtr& completionCall)
 {
-	std::wstring cmdLine = L"shell32.dll,ShellExec_RunDLL " + m_action.GetCommandLine();
-	ShellExecute(core_api::get_main_window(), L"open", L"RunDLL32.exe", cmdLine.c_str(), NULL, SW_SHOWDEFAULT);
+	if (!m_action.GetWaitForExit())
+	{
+		std::wstring cmdLine = L"shell32.dll,ShellExec_RunDLL " + m_action.GetCommandLine();
+		ShellExecute(core_api::get_main_window(), L"open", L"RunDLL32.exe", cmdLine.c_str(), NULL, SW_SHOWDEFAULT);
+
+		AsyncCall::AsyncRunInMainThread(completionCall);
+		return;
+	}
+
+	m_alesFuncs->SetValue(SessionValues::keyLaunchExitCode, boost::blank());
+	m_alesFuncs->SetValue(SessionValues::keyLaunchOutput, boost::blank());
+
+	m_completionCall = completionCall;
+	m_launcher.reset(new ProcessLauncher);
+
+	// The launcher calls back on its worker thread, the result is passed to the main thread.
+	// The callback is dropped if the session has been stopped meanwhile.
+	boost::weak_ptr<ExecSession> pThis = shared_from_this();
+
+	std::wstring error;
+	const bool started = m_launcher->Start(m_action.GetCommandLine(), m_action.GetTimeout() * 1000,
+		m_action.GetCaptureOutput(),
+		[pThis] (const ProcessLauncher::Result& result) {
+			AsyncCall::AsyncRunInMainThread(AsyncCall::MakeCallback<ExecSession>(pThis,
+				boost::bind(&ExecSession::OnProcessCompleted, _1, result)));
+		},
+		error);
+
+	if (!started)
+	{
+		console::formatter() << COMPONENT_NAME ": can't launch \"" <<
+			pfc::stringcvt::string_utf8_from_wide(m_action.GetCommandLine().c_str()) << "\": " <<
+			pfc::stringcvt::string_utf8_from_wide(error.c_str());
+
+		m_launcher.reset();
+		AsyncCall::AsyncRunInMainThread(completionCall);
+		return;
+	}
+
+	m_waiting = true;
+	m_alesFuncs->UpdateDescription();
+}
+
+void ActionLaunchApp::ExecSession::OnProcessCompleted(const ProcessLauncher::Result& result)
+{
+	m_waiting = false;
+
+	if (!result.error.empty())
+	{
+		console::formatter() << COMPONENT_NAME ": waiting for \"" <<
+			pfc::stringcvt::string_utf8_from_wide(m_action.GetCommandLine().c_str()) << "\" failed: " <<
+			pfc::stringcvt::string_utf8_from_wide(result.error.c_str());
+	}
+	else if (!result.timedOut)
+		m_alesFuncs->SetValue(SessionValues::keyLaunchExitCode, static_cast<t_size>(result.exitCode));
+
+	if (m_action.GetCaptureOutput())
+	{
+		// Console applications write in the OEM code page.
+		std::wstring output;
 
-	AsyncCall::AsyncRunInMainThread(completionCall);
+		if (!result.output.empty())
+		{
+			const int size = MultiByteToWideChar(CP_OEMCP, 0, result.output.data(), static_cast<int>(result.output.size()), NULL, 0);
+			output.resize(size);
+
+			if (size > 0)
+				MultiByteToWideChar(CP_OEMCP, 0, result.output.data(), static_cast<int>(result.output.size()), &output[0], size);
+		}
+
+		m_alesFuncs->SetValue(SessionValues::keyLaunchOutput, output);
+	}
+
+	AsyncCall::AsyncRunInMainThread(m_completionCall);
 }
 
 const IAction* ActionLaunchApp::ExecSession::GetParentAction() const
@@ -113,13 +245,18 @@ const IAction* ActionLaunchApp::ExecSession::GetParentAction() const
 	return &m_action;
 }
 
-void ActionLaunchApp::ExecSession::Init(IActionListExecSessionFuncs&)
+void ActionLaunchApp::ExecSession::Init(IActionListExecSessionFuncs& alesFuncs)
 {
+	m_alesFuncs = &alesFuncs;
 }
 
-bool ActionLaunchApp::ExecSession::GetCurrentStateDescription(std::wstring& /*descr*/) const
+bool ActionLaunchApp::ExecSession::GetCurrentStateDescription(std::wstring& descr) const
 {
-	return false;
+	if (!m_waiting)
+		return false;
+
+	descr = L"Waiting for the application to exit";
+	return true;
 }
 
 //------------------------------------------------------------------------------
@@ -135,6 +272,12 @@ BOOL ActionLaunchAppEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
 {
 	SetDlgItemText(IDC_EDIT_CMD_LINE, m_action.GetCommandLine().c_str());
 
+	CheckDlgButton(IDC_CHECK_WAIT_FOR_EXIT, m_action.GetWaitForExit() ? BST_CHECKED : BST_UNCHECKED);
+	SetDlgItemInt(IDC_EDIT_LAUNCH_TIMEOUT, m_action.GetTimeout(), FALSE);
+	CheckDlgButton(IDC_CHECK_CAPTURE_OUTPUT, m_action.GetCaptureOutput() ? BST_CHECKED : BST_UNCHECKED);
+
+	UpdateWaitControls();
+
 	CenterWindow(GetParent());
 
 	// dark mode
@@ -150,7 +293,21 @@ void ActionLaunchAppEditor::OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl
 		CString s;
 		GetDlgItemText(IDC_EDIT_CMD_LINE, s);
 
+		const bool waitForExit = IsDlgButtonChecked(IDC_CHECK_WAIT_FOR_EXIT) == BST_CHECKED;
+
+		BOOL translated = FALSE;
+		const UINT timeout = GetDlgItemInt(IDC_EDIT_LAUNCH_TIMEOUT, &translated, FALSE);
+
+		if (waitForExit && (!translated || timeout > static_cast<UINT>(maxTimeout)))
+		{
+			m_popupTooltipMsg.Show(L"Enter the timeout in seconds, up to 24 hours.", GetDlgItem(IDC_EDIT_LAUNCH_TIMEOUT));
+			return;
+		}
+
 		m_action.SetCommandLine(s.GetString());
+		m_action.SetWaitForExit(waitForExit);
+		m_action.SetTimeout(waitForExit ? timeout : 0);
+		m_action.SetCaptureOutput(waitForExit && IsDlgButtonChecked(IDC_CHECK_CAPTURE_OUTPUT) == BST_CHECKED);
 	}
 
 	EndDialog(nID);
@@ -169,4 +326,17 @@ void ActionLaunchAppEditor::OnOpenFile(UINT uNotifyCode, int nID, CWindow wndCtl
 	{
 		SetDlgItemText(IDC_EDIT_CMD_LINE, dlg.m_ofn.lpstrFile);
 	}
+}
+
+void ActionLaunchAppEditor::OnWaitForExit(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	UpdateWaitControls();
+}
+
+void ActionLaunchAppEditor::UpdateWaitControls()
+{
+	const bool waitForExit = IsDlgButtonChecked(IDC_CHECK_WAIT_FOR_EXIT) == BST_CHECKED;
+
+	GetDlgItem(IDC_EDIT_LAUNCH_TIMEOUT).EnableWindow(waitForExit);
+	GetDlgItem(IDC_CHECK_CAPTURE_OUTPUT).EnableWindow(waitForExit);
 }
\ No newline at end of file
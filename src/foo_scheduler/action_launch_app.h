@@ -2,6 +2,8 @@
 
 #include "resource.h"
 #include "action.h"
+#include "popup_tooltip_message.h"
+#include "process_launcher.h"
 
 //------------------------------------------------------------------------------
 // ActionLaunchApp
@@ -10,7 +12,8 @@
 class ActionLaunchApp : public IAction
 {
 public:
-	class ExecSession : public IActionExecSession
+	class ExecSession : public IActionExecSession,
+		public boost::enable_shared_from_this<ExecSession>
 	{
 	public:
 		explicit ExecSession(const ActionLaunchApp& action);
@@ -20,8 +23,15 @@ public:
 		virtual const IAction* GetParentAction() const;
 		virtual bool GetCurrentStateDescription(std::wstring& descr) const;
 
+	private:
+		void OnProcessCompleted(const ProcessLauncher::Result& result);
+
 	private:
 		const ActionLaunchApp& m_action;
+		IActionListExecSessionFuncs* m_alesFuncs;
+		AsyncCall::CallbackPtr m_completionCall;
+		boost::scoped_ptr<ProcessLauncher> m_launcher;
+		bool m_waiting;
 	};
 
 	ActionLaunchApp();
@@ -29,6 +39,18 @@ public:
 	std::wstring GetCommandLine() const;
 	void SetCommandLine(const std::wstring& val);
 
+	// Starts the application directly and completes when it exits, instead of
+	// opening the command line through the shell.
+	bool GetWaitForExit() const;
+	void SetWaitForExit(bool val);
+
+	// Seconds, 0 waits without a limit.
+	int GetTimeout() const;
+	void SetTimeout(int val);
+
+	bool GetCaptureOutput() const;
+	void SetCaptureOutput(bool val);
+
 public: // IAction
 	virtual GUID GetPrototypeGUID() const;
 	virtual int GetPriority() const;
@@ -45,6 +67,9 @@ public: // IAction
 
 private:
 	std::wstring m_commandLine;
+	bool m_waitForExit;
+	int m_timeout;
+	bool m_captureOutput;
 };
 
 class ActionLaunchAppEditor : public CDialogImpl<ActionLaunchAppEditor>
@@ -59,6 +84,7 @@ private:
 		MSG_WM_INITDIALOG(OnInitDialog)
 
 		COMMAND_ID_HANDLER_EX(IDC_BTN_OPEN_FILE, OnOpenFile)
+		COMMAND_ID_HANDLER_EX(IDC_CHECK_WAIT_FOR_EXIT, OnWaitForExit)
 
 		COMMAND_ID_HANDLER_EX(IDOK,     OnCloseCmd)
 		COMMAND_ID_HANDLER_EX(IDCANCEL, OnCloseCmd)
@@ -67,8 +93,12 @@ private:
 	BOOL OnInitDialog(CWindow wndFocus, LPARAM lInitParam);
 	void OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl);
 	void OnOpenFile(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnWaitForExit(UINT uNotifyCode, int nID, CWindow wndCtl);
+
+	void UpdateWaitControls();
 
 private:
 	ActionLaunchApp& m_action;
+	PopupTooltipMessage m_popupTooltipMsg;
 	fb2k::CDarkModeHooks m_dark;
 };
\ No newline at end of file
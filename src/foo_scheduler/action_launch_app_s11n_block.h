@@ -5,10 +5,13 @@
 struct ActionLaunchAppS11nBlock : public S11nBlocks::Block<ActionLaunchAppS11nBlock>
 {
 	S11nBlocks::Field<pfc::string8, 1> commandLine;
+	S11nBlocks::Field<bool, 2> waitForExit;
+	S11nBlocks::Field<int, 3> timeout;
+	S11nBlocks::Field<bool, 4> captureOutput;
 
 	template<class Archive>
 	void RegisterFields(Archive& ar)
 	{
-		ar.RegisterFields(commandLine);
+		ar.RegisterFields(commandLine)(waitForExit)(timeout)(captureOutput);
 	}
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "action_list.h"
 #include "service_manager.h"
 #include "pref_page_model.h"
+#include "combo_helpers.h"
 
 //------------------------------------------------------------------------------
 // ActionList
@@ -15,9 +16,15 @@ ActionList::ActionList()
 ActionList::ActionList(const ActionList& rhs) :
 	m_actionListGUID(rhs.m_actionListGUID),
 	m_name(rhs.m_name),
-	m_actions(rhs.m_actions),
-	m_restartAfterCompletion(rhs.m_restartAfterCompletion)
+	m_restartAfterCompletion(rhs.m_restartAfterCompletion),
+	m_concurrencyPolicy(rhs.m_concurrencyPolicy),
+	m_maxQueueDepth(rhs.m_maxQueueDepth),
+	m_priority(rhs.m_priority)
 {
+	// Copies are made for editing and execution, both need the actions.
+	rhs.LoadPendingActions();
+	m_actions = rhs.m_actions;
+	m_unloadedActions = rhs.m_unloadedActions;
 }
 
 void ActionList::CreateGUID()
@@ -33,11 +40,22 @@ bool ActionList::ShowConfigDialog(CWindow parent, PrefPageModel* pPrefPageModel)
 
 std::vector<IAction*> ActionList::GetActions()
 {
+	LoadPendingActions();
+
 	std::vector<IAction*> result(m_actions.size());
 	std::transform(m_actions.begin(), m_actions.end(), result.begin(), &boost::lambda::_1);
 	return result;
 }
 
+std::vector<const IAction*> ActionList::GetActions() const
+{
+	LoadPendingActions();
+
+	std::vector<const IAction*> result(m_actions.size());
+	std::transform(m_actions.begin(), m_actions.end(), result.begin(), &boost::lambda::_1);
+	return result;
+}
+
 std::wstring ActionList::GetName() const
 {
 	return m_name;
@@ -48,6 +66,15 @@ std::wstring ActionList::GetDescription() const
 	auto result = GetName();
 	if (m_restartAfterCompletion)
 		result += L" [restart after completion]";
+
+	if (m_concurrencyPolicy == ConcurrencyPolicy::queue)
+		result += boost::str(boost::wformat(L" [queue up to %1%]") % m_maxQueueDepth);
+	else if (m_concurrencyPolicy != ConcurrencyPolicy::parallel)
+		result += L" [" + ConcurrencyPolicy::Label(m_concurrencyPolicy) + L"]";
+
+	if (m_priority != TaskPriority::normal)
+		result += L" [" + TaskPriority::Label(m_priority) + L" priority]";
+
 	return result;
 }
 
@@ -56,6 +83,21 @@ bool ActionList::GetRestartAfterCompletion() const
 	return m_restartAfterCompletion;
 }
 
+ConcurrencyPolicy::Type ActionList::GetConcurrencyPolicy() const
+{
+	return m_concurrencyPolicy;
+}
+
+int ActionList::GetMaxQueueDepth() const
+{
+	return m_maxQueueDepth;
+}
+
+TaskPriority::Type ActionList::GetPriority() const
+{
+	return m_priority;
+}
+
 void ActionList::SetName(const std::wstring& name)
 {
 	m_name = name;
@@ -66,8 +108,24 @@ void ActionList::SetRestartAfterCompletion(bool restart)
 	m_restartAfterCompletion = restart;
 }
 
+void ActionList::SetConcurrencyPolicy(ConcurrencyPolicy::Type policy)
+{
+	m_concurrencyPolicy = policy;
+}
+
+void ActionList::SetMaxQueueDepth(int depth)
+{
+	m_maxQueueDepth = depth;
+}
+
+void ActionList::SetPriority(TaskPriority::Type priority)
+{
+	m_priority = priority;
+}
+
 void ActionList::AddAction(std::unique_ptr<IAction> pAction)
 {
+	LoadPendingActions();
 	m_actions.push_back(std::move(pAction));
 }
 
@@ -89,6 +147,13 @@ ActionList::ActionsContainer::auto_type ActionList::RemoveAction(IAction* pActio
 	auto it = std::find_if(m_actions.begin(), m_actions.end(), &boost::lambda::_1 == pAction);
 	_ASSERTE(it != m_actions.end());
 
+	// Unloaded actions after it keep preceding the same actions.
+	const std::size_t pos = std::distance(m_actions.begin(), it);
+
+	for (std::size_t i = 0; i < m_unloadedActions.size(); ++i)
+		if (m_unloadedActions[i].position > pos)
+			--m_unloadedActions[i].position;
+
 	return m_actions.release(it);
 }
 
@@ -141,25 +206,30 @@ void ActionList::LoadFromS11nBlock(const ActionListS11nBlock& block)
 	if (block.actions.Exists())
 	{
 		for (int i = 0; i < block.actions.GetSize(); ++i)
-		{
-			const ActionS11nBlock& actionBlock = block.actions.GetAt(i);
-
-			// actionGUID is a required field, unnecessary to check if it exists.
-			IAction* pPrototype = ServiceManager::Instance().GetActionPrototypesManager().
-				GetPrototypeByGUID(actionBlock.actionGUID.GetValue());
+			m_pendingActions.push_back(block.actions.GetAt(i));
+	}
 
-			if (!pPrototype)
-				continue;
+	if (block.restartAfterCompletion.Exists())
+		m_restartAfterCompletion = block.restartAfterCompletion.GetValue();
 
-			std::unique_ptr<IAction> pAction(pPrototype->Clone());
-			pAction->LoadFromS11nBlock(actionBlock);
+	if (block.concurrencyPolicy.Exists())
+	{
+		const int policy = block.concurrencyPolicy.GetValue();
 
-			m_actions.push_back(std::move(pAction));
-		}
+		if (policy >= 0 && policy < ConcurrencyPolicy::numTypes)
+			m_concurrencyPolicy = static_cast<ConcurrencyPolicy::Type>(policy);
 	}
 
-	if (block.restartAfterCompletion.Exists())
-		m_restartAfterCompletion = block.restartAfterCompletion.GetValue();
+	if (block.maxQueueDepth.Exists())
+		m_maxQueueDepth = std::min(std::max(block.maxQueueDepth.GetValue(), 1), s_maxQueueDepth);
+
+	if (block.priority.Exists())
+	{
+		const int priority = block.priority.GetValue();
+
+		if (priority >= 0 && priority < TaskPriority::numTypes)
+			m_priority = static_cast<TaskPriority::Type>(priority);
+	}
 }
 
 void ActionList::SaveToS11nBlock(ActionListS11nBlock& block) const
@@ -167,16 +237,100 @@ void ActionList::SaveToS11nBlock(ActionListS11nBlock& block) const
 	block.guid.SetValue(m_actionListGUID);
 	block.name.SetValue(pfc::stringcvt::string_utf8_from_wide(m_name.c_str()).toString());
 
+	// Not yet loaded actions are written back as they were read, unless the encoding has changed.
+	if (std::find_if(m_pendingActions.begin(), m_pendingActions.end(),
+		!boost::bind(&S11nBlocks::SerializedBlock::IsInCurrentEncoding, _1)) != m_pendingActions.end())
+	{
+		LoadPendingActions();
+	}
+
+	for (std::size_t i = 0; i < m_pendingActions.size(); ++i)
+		block.actions.Add(m_pendingActions[i]);
+
+	std::size_t nextUnloaded = 0;
+
 	for (std::size_t i = 0; i < m_actions.size(); ++i)
 	{
+		while (nextUnloaded < m_unloadedActions.size() && m_unloadedActions[nextUnloaded].position <= i)
+			SaveUnloadedAction(m_unloadedActions[nextUnloaded++], block);
+
 		ActionS11nBlock actionBlock;
 		actionBlock.actionGUID.SetValue(m_actions[i].GetPrototypeGUID());
 
 		m_actions[i].SaveToS11nBlock(actionBlock);
-		block.actions.Add(actionBlock);
+		block.actions.Add(S11nBlocks::SerializedBlock::FromBlock(actionBlock));
 	}
 
+	while (nextUnloaded < m_unloadedActions.size())
+		SaveUnloadedAction(m_unloadedActions[nextUnloaded++], block);
+
 	block.restartAfterCompletion.SetValue(m_restartAfterCompletion);
+	block.concurrencyPolicy.SetValue(m_concurrencyPolicy);
+	block.maxQueueDepth.SetValue(m_maxQueueDepth);
+	block.priority.SetValue(m_priority);
+}
+
+void ActionList::SaveUnloadedAction(const UnloadedAction& unloadedAction, ActionListS11nBlock& block) const
+{
+	if (unloadedAction.block.IsInCurrentEncoding())
+	{
+		block.actions.Add(unloadedAction.block);
+		return;
+	}
+
+	// The block holds its own tables, so an action of an unknown type is encoded again with its known fields.
+	// A damaged one can't be.
+	ActionS11nBlock actionBlock;
+
+	try
+	{
+		unloadedAction.block.ParseBlock(actionBlock);
+	}
+	catch (S11nBlocks::Exception&)
+	{
+		console::formatter() << COMPONENT_NAME ": dropped a damaged action of task \"" <<
+			pfc::stringcvt::string_utf8_from_wide(m_name.c_str()) << "\"";
+		return;
+	}
+
+	block.actions.Add(S11nBlocks::SerializedBlock::FromBlock(actionBlock));
+}
+
+void ActionList::LoadPendingActions() const
+{
+	for (std::size_t i = 0; i < m_pendingActions.size(); ++i)
+	{
+		ActionS11nBlock actionBlock;
+
+		try
+		{
+			m_pendingActions[i].ParseBlock(actionBlock);
+		}
+		catch (S11nBlocks::Exception&)
+		{
+			UnloadedAction unloadedAction = { m_actions.size(), m_pendingActions[i] };
+			m_unloadedActions.push_back(unloadedAction);
+			continue;
+		}
+
+		// actionGUID is a required field, unnecessary to check if it exists.
+		IAction* pPrototype = ServiceManager::Instance().GetActionPrototypesManager().
+			GetPrototypeByGUID(actionBlock.actionGUID.GetValue());
+
+		if (!pPrototype)
+		{
+			UnloadedAction unloadedAction = { m_actions.size(), m_pendingActions[i] };
+			m_unloadedActions.push_back(unloadedAction);
+			continue;
+		}
+
+		std::unique_ptr<IAction> pAction(pPrototype->Clone());
+		pAction->LoadFromS11nBlock(actionBlock);
+
+		m_actions.push_back(std::move(pAction));
+	}
+
+	m_pendingActions.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -195,6 +349,31 @@ BOOL ActionListEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
 
 	CheckDlgButton(IDC_CHECK_RESTART_AFTER_COMPLETION, m_pActionList->GetRestartAfterCompletion());
 
+	std::vector<std::pair<std::wstring, int>> comboItems;
+
+	for (int i = 0; i < ConcurrencyPolicy::numTypes; ++i)
+	{
+		comboItems.push_back(std::make_pair(
+			ConcurrencyPolicy::Label(static_cast<ConcurrencyPolicy::Type>(i)), i));
+	}
+
+	m_concurrencyPolicyCombo = GetDlgItem(IDC_COMBO_CONCURRENCY_POLICY);
+	ComboHelpers::InitCombo(m_concurrencyPolicyCombo, comboItems, m_pActionList->GetConcurrencyPolicy());
+
+	comboItems.clear();
+
+	for (int i = 0; i < TaskPriority::numTypes; ++i)
+		comboItems.push_back(std::make_pair(TaskPriority::Label(static_cast<TaskPriority::Type>(i)), i));
+
+	m_priorityCombo = GetDlgItem(IDC_COMBO_TASK_PRIORITY);
+	ComboHelpers::InitCombo(m_priorityCombo, comboItems, m_pActionList->GetPriority());
+
+	CUpDownCtrl spin = ::GetDlgItem(m_hWnd, IDC_SPIN_MAX_QUEUE_DEPTH);
+	spin.SetRange(1, ActionList::s_maxQueueDepth);
+	spin.SetPos(m_pActionList->GetMaxQueueDepth());
+
+	UpdateMaxQueueDepthState();
+
 	m_actionListName.SetWindowText(m_pActionList->GetName().c_str());
 	m_actionListName.SetSel(0, -1);
 
@@ -229,13 +408,50 @@ void ActionListEditor::OnClose(UINT uNotifyCode, int nID, CWindow wndCtl)
 			return;
 		}
 
+		const ConcurrencyPolicy::Type policy =
+			ComboHelpers::GetSelectedItem<ConcurrencyPolicy::Type>(m_concurrencyPolicyCombo);
+
+		int maxQueueDepth = m_pActionList->GetMaxQueueDepth();
+
+		if (policy == ConcurrencyPolicy::queue)
+		{
+			BOOL translated = FALSE;
+			maxQueueDepth = static_cast<int>(GetDlgItemInt(IDC_EDIT_MAX_QUEUE_DEPTH, &translated, FALSE));
+
+			if (!translated || maxQueueDepth < 1 || maxQueueDepth > ActionList::s_maxQueueDepth)
+			{
+				const std::wstring message = boost::str(boost::wformat(L"Enter a queue depth from 1 to %1%.") %
+					ActionList::s_maxQueueDepth);
+
+				m_popupTooltipMsg.Show(message.c_str(), GetDlgItem(IDC_EDIT_MAX_QUEUE_DEPTH));
+				return;
+			}
+		}
+
 		m_pActionList->SetName(static_cast<LPCWSTR>(text));
 		m_pActionList->SetRestartAfterCompletion(IsDlgButtonChecked(IDC_CHECK_RESTART_AFTER_COMPLETION) == TRUE);
+		m_pActionList->SetConcurrencyPolicy(policy);
+		m_pActionList->SetMaxQueueDepth(maxQueueDepth);
+		m_pActionList->SetPriority(ComboHelpers::GetSelectedItem<TaskPriority::Type>(m_priorityCombo));
 	}
 
 	EndDialog(nID);
 }
 
+void ActionListEditor::OnConcurrencyPolicyChange(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	UpdateMaxQueueDepthState();
+}
+
+void ActionListEditor::UpdateMaxQueueDepthState()
+{
+	const bool queue = ComboHelpers::GetSelectedItem<ConcurrencyPolicy::Type>(m_concurrencyPolicyCombo) ==
+		ConcurrencyPolicy::queue;
+
+	GetDlgItem(IDC_EDIT_MAX_QUEUE_DEPTH).EnableWindow(queue);
+	GetDlgItem(IDC_SPIN_MAX_QUEUE_DEPTH).EnableWindow(queue);
+}
+
 bool ActionListEditor::CheckActionListName(const std::wstring& actionListName) const
 {
 	std::vector<ActionList*> alists = m_pPrefPageModel->GetActionLists();
@@ -4,6 +4,8 @@
 #include "action.h"
 #include "popup_tooltip_message.h"
 #include "action_list_s11n_block.h"
+#include "concurrency_policy.h"
+#include "task_priority.h"
 
 class PrefPageModel;
 
@@ -28,10 +30,19 @@ public:
 	std::wstring GetName() const;
 	std::wstring GetDescription() const;
 	bool GetRestartAfterCompletion() const;
+	ConcurrencyPolicy::Type GetConcurrencyPolicy() const;
+
+	// Number of runs waiting with the queue policy.
+	int GetMaxQueueDepth() const;
+
+	TaskPriority::Type GetPriority() const;
+
+	static const int s_maxQueueDepth = 100;
 
 	bool ShowConfigDialog(CWindow parent, PrefPageModel* pPrefPageModel);
 
 	std::vector<IAction*> GetActions();
+	std::vector<const IAction*> GetActions() const;
 
 	void AddAction(std::unique_ptr<IAction> pAction);
 	ActionsContainer::auto_type RemoveAction(IAction* pAction);
@@ -50,15 +61,39 @@ private:
 	friend class ActionListEditor;
 	void SetName(const std::wstring& name);
 	void SetRestartAfterCompletion(bool restart);
+	void SetConcurrencyPolicy(ConcurrencyPolicy::Type policy);
+	void SetMaxQueueDepth(int depth);
+	void SetPriority(TaskPriority::Type priority);
 
 	void MoveAction(const IAction* pAction, bool up);
 
+	// Creates the actions kept serialized since LoadFromS11nBlock.
+	void LoadPendingActions() const;
+
 private:
 	GUID m_actionListGUID;
 	std::wstring m_name;
 	bool m_restartAfterCompletion = false;
-
-	ActionsContainer m_actions;
+	ConcurrencyPolicy::Type m_concurrencyPolicy = ConcurrencyPolicy::parallel;
+	int m_maxQueueDepth = 1;
+	TaskPriority::Type m_priority = TaskPriority::normal;
+
+	// Actions are created on first use, so loading the configuration only creates the action list headers.
+	mutable ActionsContainer m_actions;
+	mutable std::vector<S11nBlocks::SerializedBlock> m_pendingActions;
+
+	// Action that couldn't be created, damaged or of an unknown type, e.g. saved by a newer version.
+	// It's kept as read and written back at its place among the other actions.
+	struct UnloadedAction
+	{
+		std::size_t position; // Index in m_actions of the action it precedes.
+		S11nBlocks::SerializedBlock block;
+	};
+
+	void SaveUnloadedAction(const UnloadedAction& unloadedAction, ActionListS11nBlock& block) const;
+
+	// Ordered by position.
+	mutable std::vector<UnloadedAction> m_unloadedActions;
 };
 
 // For boost::ptr_vector.
@@ -83,10 +118,13 @@ private:
 		MSG_WM_INITDIALOG(OnInitDialog)
 		COMMAND_ID_HANDLER_EX(IDOK, OnClose)
 		COMMAND_ID_HANDLER_EX(IDCANCEL, OnClose)
+		COMMAND_HANDLER_EX(IDC_COMBO_CONCURRENCY_POLICY, CBN_SELCHANGE, OnConcurrencyPolicyChange)
 	END_MSG_MAP()
 
 	BOOL OnInitDialog(CWindow wndFocus, LPARAM lInitParam);
 	void OnClose(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnConcurrencyPolicyChange(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void UpdateMaxQueueDepthState();
 
 private:
 	bool CheckActionListName(const std::wstring& actionListName) const;
@@ -96,6 +134,8 @@ private:
 	PrefPageModel* m_pPrefPageModel;
 
 	CEdit m_actionListName;
+	CComboBox m_concurrencyPolicyCombo;
+	CComboBox m_priorityCombo;
 
 	PopupTooltipMessage m_popupTooltipMsg;
 	fb2k::CDarkModeHooks m_dark;
@@ -3,13 +3,18 @@
 #include "async_call.h"
 #include "service_manager.h"
 #include "action_list.h"
+#include "metrics.h"
+#include "tracer.h"
 
-ActionListExecSession::ActionListExecSession(ActionList* pActionList, const std::wstring& eventDescription) :
-	m_pActionList(pActionList->Clone()), m_eventDescription(eventDescription), m_currentActionIndex(-1)
+ActionListExecSession::ActionListExecSession(
+	const boost::shared_ptr<const ActionList>& pActionList, const std::wstring& eventDescription) :
+	m_pActionList(pActionList), m_eventDescription(eventDescription),
+	m_startTime(0), m_actionStartTime(0)
 {
-	// pActionList is cloned as the following situation may occur:
+	// pActionList is a snapshot shared with other sessions, as the following situation may occur:
 	// an action list is running and this session references it. User removes or modifies the action list and
-	// after applying new settings this session will be broken.
+	// after applying new settings this session would be broken.
+	m_callStack.push_back(Frame(m_pActionList));
 }
 
 ActionListExecSession::~ActionListExecSession()
@@ -19,48 +24,120 @@ ActionListExecSession::~ActionListExecSession()
 
 void ActionListExecSession::StartExecution()
 {
+	m_startTime = Metrics::NowMicroseconds();
+
 	AsyncCall::CallbackPtr callback = AsyncCall::MakeCallback<ActionListExecSession>(
 		shared_from_this(), boost::mem_fn(&ActionListExecSession::RunNextAction));
 
-	AsyncCall::AsyncRunInMainThread(callback);
+	ServiceManager::Instance().GetMainThreadExecutor().Post(m_pActionList->GetPriority(), callback);
+}
+
+void ActionListExecSession::Cancel()
+{
+	m_cancellationToken.Cancel();
+
+	if (m_pActionExecSession)
+		m_pActionExecSession->Cancel();
 }
 
 void ActionListExecSession::RunNextAction()
 {
-	++m_currentActionIndex;
+	// A completion call might have been queued before the session was stopped.
+	if (m_cancellationToken.IsCancelled())
+		return;
+
+	Tracer::ScopedSpan span("task", "Run next action");
+
+	const __int64 now = Metrics::NowMicroseconds();
+
+	// Actions and runs of the list are traced on a row of this session.
+	const unsigned __int64 traceTrack = reinterpret_cast<unsigned __int64>(this);
+
+	// The previous action has completed.
+	if (m_pActionExecSession)
+	{
+		Metrics::Record(Metrics::histActionDuration, now - m_actionStartTime);
+
+		if (Tracer::IsEnabled())
+		{
+			Tracer::RecordSpan("action", pfc::stringcvt::string_utf8_from_wide(
+				m_pActionExecSession->GetParentAction()->GetName().c_str()), m_actionStartTime, now, traceTrack);
+		}
+	}
 
-	std::vector<IAction*> actions = m_pActionList->GetActions();
+	std::vector<const IAction*> actions;
 
-	// If no more actions to execute finish this session.
-	if (m_currentActionIndex >= static_cast<int>(actions.size()))
+	for (;;)
 	{
+		Frame& frame = m_callStack.back();
+		actions = frame.pActionList->GetActions();
+
+		++frame.currentActionIndex;
+
+		while (frame.currentActionIndex < static_cast<int>(frame.skippedActions.size()) &&
+			frame.skippedActions[frame.currentActionIndex])
+		{
+			++frame.currentActionIndex;
+		}
+
+		if (frame.currentActionIndex < static_cast<int>(actions.size()))
+			break;
+
+		// The previous action session references an action of the list.
 		m_pActionExecSession.reset();
 
-		if (m_pActionList->GetRestartAfterCompletion() && !actions.empty())
+		// A called list has completed, continue with the caller.
+		if (m_callStack.size() > 1)
 		{
-			// Restart action list after completion if there are any actions inside it.
-			m_currentActionIndex = 0;
+			m_callStack.pop_back();
+			continue;
 		}
-		else
+
+		// No more actions to execute, the run of the list has completed.
+		Metrics::Record(Metrics::histActionListDuration, now - m_startTime);
+		Metrics::Increment(Metrics::counterActionListsCompleted);
+
+		if (Tracer::IsEnabled())
+		{
+			Tracer::RecordSpan("task", pfc::stringcvt::string_utf8_from_wide(
+				m_pActionList->GetName().c_str()), m_startTime, now, traceTrack);
+		}
+
+		m_startTime = now;
+
+		// Restart action list after completion if there are any actions inside it.
+		if (!m_pActionList->GetRestartAfterCompletion() || actions.empty())
 		{
 			// The last reference to this instance holds AsyncCall::MainThreadAsyncMethodCall::operator ().
 			ServiceManager::Instance().GetRootController().RemoveExecSession(this);
 			return;
 		}
+
+		frame.currentActionIndex = -1;
+		frame.skippedActions.clear();
 	}
 
-	m_pActionExecSession = actions[m_currentActionIndex]->CreateExecSession();
+	m_pActionExecSession = actions[m_callStack.back().currentActionIndex]->CreateExecSession();
 	_ASSERTE(m_pActionExecSession);
 
 	m_pActionExecSession->Init(*this);
 
+	Metrics::Increment(Metrics::counterActionsRun);
+	m_actionStartTime = now;
+
 	// Async call takes boost::weak_ptr, which is automatically constructed from boost::shared_ptr.
-	AsyncCall::CallbackPtr runNextActionCallback = AsyncCall::MakeCallback<ActionListExecSession>(
-		shared_from_this(), boost::mem_fn(&ActionListExecSession::RunNextAction));
+	// The next action waits in MainThreadExecutor after the completion call, so tasks are switched
+	// only between actions.
+	AsyncCall::CallbackPtr runNextActionCallback = ServiceManager::Instance().GetMainThreadExecutor().MakePostingCallback(
+		m_pActionList->GetPriority(), AsyncCall::MakeCallback<ActionListExecSession>(
+			shared_from_this(), boost::mem_fn(&ActionListExecSession::RunNextAction)));
 
 	// An action must initiate ActionListExecSession::RunNextAction, not an action list itself,
 	// cause there are some continuous actions like Delay or Volume with fade out.
-	m_pActionExecSession->Run(runNextActionCallback);
+	{
+		Tracer::ScopedSpan runSpan("action", "Run");
+		m_pActionExecSession->Run(runNextActionCallback);
+	}
 
 	// Notify everyone that a new action is going to be executed.
 	UpdateDescription();
@@ -71,6 +148,12 @@ std::wstring ActionListExecSession::GetDescription() const
 	_ASSERTE(m_pActionList);
 	std::wstring result = m_pActionList->GetDescription();
 
+	for (std::size_t i = 1; i < m_callStack.size(); ++i)
+	{
+		result += L" / ";
+		result += m_callStack[i].pActionList->GetName();
+	}
+
 	if (m_pActionExecSession)
 	{
 		result += L" / ";
@@ -88,6 +171,11 @@ std::wstring ActionListExecSession::GetDescription() const
 	return result;
 }
 
+const GUID& ActionListExecSession::GetActionListGUID() const
+{
+	return m_pActionList->GetGUID();
+}
+
 void ActionListExecSession::UpdateDescription()
 {
 	ServiceManager::Instance().GetRootController().UpdateExecSession(shared_from_this());
@@ -98,24 +186,54 @@ ActionListExecSession& ActionListExecSession::GetActionListExecSession()
 	return *this;
 }
 
-boost::any ActionListExecSession::GetValue(const std::string &key) const
+const CancellationToken& ActionListExecSession::GetCancellationToken() const
+{
+	return m_cancellationToken;
+}
+
+void ActionListExecSession::SkipActions(int offset, int count)
+{
+	_ASSERTE(offset >= 0 && count >= 0);
+
+	Frame& frame = m_callStack.back();
+
+	const int first = frame.currentActionIndex + 1 + offset;
+	const int last = std::min(first + count, static_cast<int>(frame.pActionList->GetActions().size()));
+
+	if (first >= last)
+		return;
+
+	if (static_cast<int>(frame.skippedActions.size()) < last)
+		frame.skippedActions.resize(last);
+
+	std::fill(frame.skippedActions.begin() + first, frame.skippedActions.begin() + last, 1);
+}
+
+bool ActionListExecSession::CallActionList(const GUID& actionListGUID)
+{
+	// A list calling itself, directly or through other lists, would never complete.
+	for (std::size_t i = 0; i < m_callStack.size(); ++i)
+	{
+		if (m_callStack[i].pActionList->GetGUID() == actionListGUID)
+			return false;
+	}
+
+	boost::shared_ptr<const ActionList> pActionList =
+		ServiceManager::Instance().GetModel().GetActionListSnapshot(actionListGUID);
+
+	if (!pActionList)
+		return false;
+
+	m_callStack.push_back(Frame(pActionList));
+	return true;
+}
+
+const SessionValues::Value& ActionListExecSession::GetValue(SessionValues::Key key) const
 {
-    auto it = m_keyValueStore.find(key);
-    if (it != m_keyValueStore.cend())
-    {
-        return it->second;
-    }
-    return boost::any();
+    return m_keyValueStore.Get(key);
 }
 
-void ActionListExecSession::SetValue(const std::string &key, const boost::any &value)
+void ActionListExecSession::SetValue(SessionValues::Key key, const SessionValues::Value& value)
 {
-    if (value.empty())
-    {
-        m_keyValueStore.erase(key);
-    }
-    else
-    {
-        m_keyValueStore[key] = value;
-    }
+    m_keyValueStore.Set(key, value);
 }
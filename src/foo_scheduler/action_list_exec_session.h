@@ -9,29 +9,55 @@ class ActionListExecSession
     , public IActionListExecSessionFuncs
 {
 public:
-	ActionListExecSession(ActionList* pActionList, const std::wstring& eventDescription);
+	// pActionList must not be changed while the session exists, see Model::GetActionListSnapshot.
+	ActionListExecSession(const boost::shared_ptr<const ActionList>& pActionList, const std::wstring& eventDescription);
 	~ActionListExecSession();
 
 	void StartExecution();
+
+	// Stops running actions, doesn't block. The session is removed by the caller.
+	void Cancel();
 	
 	std::wstring GetDescription() const;
+	const GUID& GetActionListGUID() const;
 
 private: // ActionListKeyValueStore
-    boost::any GetValue(const std::string &key) const override;
-    void SetValue(const std::string &key, const boost::any &value) override;
+    const SessionValues::Value& GetValue(SessionValues::Key key) const override;
+    void SetValue(SessionValues::Key key, const SessionValues::Value& value) override;
     void UpdateDescription() override;
+	void SkipActions(int offset, int count) override;
 	ActionListExecSession& GetActionListExecSession() override;
+	bool CallActionList(const GUID& actionListGUID) override;
+	const CancellationToken& GetCancellationToken() const override;
 
 private:
 	void RunNextAction();
 
 private:
-	boost::scoped_ptr<ActionList> m_pActionList;
+	boost::shared_ptr<const ActionList> m_pActionList;
 	std::wstring m_eventDescription;
-	int m_currentActionIndex;
+
+	// An action list being run: the first frame is m_pActionList, the next ones are the lists called from it.
+	struct Frame
+	{
+		explicit Frame(const boost::shared_ptr<const ActionList>& pList) : pActionList(pList), currentActionIndex(-1) {}
+
+		boost::shared_ptr<const ActionList> pActionList;
+		int currentActionIndex;
+
+		// Non-zero for actions skipped in the current run, indexed by the action index.
+		std::vector<char> skippedActions;
+	};
+
+	std::vector<Frame> m_callStack;
 
 	ActionExecSessionPtr m_pActionExecSession;
-    std::map<std::string, boost::any> m_keyValueStore;
+	CancellationToken m_cancellationToken;
+
+	// Metrics::NowMicroseconds() at start of the current run of the list and of the current action.
+	__int64 m_startTime;
+	__int64 m_actionStartTime;
+    SessionValues::Store m_keyValueStore;
 };
 
 typedef boost::shared_ptr<ActionListExecSession> ActionListExecSessionPtr;
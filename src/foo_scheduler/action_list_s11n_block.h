@@ -7,12 +7,16 @@ struct ActionListS11nBlock : public S11nBlocks::Block<ActionListS11nBlock>
 {
 	S11nBlocks::Field<GUID, 1> guid;
 	S11nBlocks::Field<pfc::string8, 2> name;
-	S11nBlocks::RepeatedField<ActionS11nBlock, 3> actions;
+	S11nBlocks::RepeatedField<S11nBlocks::SerializedBlock, 3> actions; // ActionS11nBlock
 	S11nBlocks::Field<bool, 4> restartAfterCompletion;
+	S11nBlocks::Field<int, 5> concurrencyPolicy; // ConcurrencyPolicy::Type
+	S11nBlocks::Field<int, 6> maxQueueDepth;
+	S11nBlocks::Field<int, 7> priority; // TaskPriority::Type
 
 	template<class Archive>
 	void RegisterFields(Archive& ar)
 	{
-		ar.RegisterFields(guid)(name)(actions)(restartAfterCompletion);
+		ar.RegisterFields(guid)(name)(actions)(restartAfterCompletion)(concurrencyPolicy)(maxQueueDepth)
+			(priority);
 	}
 };
\ No newline at end of file
@@ -18,6 +18,9 @@
 #include "action_wait_n_tracks_played_s11n_block.h"
 #include "action_save_playback_state_s11n_block.h"
 #include "action_stop_action_lists_s11n_block.h"
+#include "action_shared_variable_s11n_block.h"
+#include "action_condition_s11n_block.h"
+#include "action_call_task_s11n_block.h"
 
 struct ActionS11nBlock : public S11nBlocks::Block<ActionS11nBlock>
 {
@@ -39,12 +42,16 @@ struct ActionS11nBlock : public S11nBlocks::Block<ActionS11nBlock>
 	S11nBlocks::Field<ActionWaitNTracksPlayedS11nBlock, 15> waitNTracksPlayed;
     S11nBlocks::Field<ActionSavePlaybackStateS11nBlock, 16> savePlaybackState;
 	S11nBlocks::Field<ActionStopActionListsS11nBlock, 17> stopActionLists;
+	S11nBlocks::Field<ActionSharedVariableS11nBlock, 18> sharedVariable;
+	S11nBlocks::Field<ActionConditionS11nBlock, 19> condition;
+	S11nBlocks::Field<ActionCallTaskS11nBlock, 20> callTask;
 
 	template<class Archive>
 	void RegisterFields(Archive& ar)
 	{
 		ar.RegisterFields(actionGUID)(startPlayback)(stopPlayback)(pausePlayback)
 			(exitFoobar)(shutdown)(changePlaylist)(setPlaybackOrder)(delay)(setVolume)(launchApp)
-			(toggleMute)(nextTrack)(prevTrack)(waitNTracksPlayed)(savePlaybackState)(stopActionLists);
+			(toggleMute)(nextTrack)(prevTrack)(waitNTracksPlayed)(savePlaybackState)(stopActionLists)
+			(sharedVariable)(condition)(callTask);
 	}
 };
\ No newline at end of file
@@ -3,21 +3,6 @@
 #include "service_manager.h"
 #include "scope_exit_function.h"
 
-const char* ActionSavePlaybackState::GetPlaylistKey()
-{
-    return "saved_playback_state/playlist";
-}
-
-const char* ActionSavePlaybackState::GetTrackKey()
-{
-    return "saved_playback_state/track";
-}
-
-const char * ActionSavePlaybackState::GetPositionKey()
-{
-	return "saved_playback_state/position";
-}
-
 //------------------------------------------------------------------------------
 // ActionSavePlaybackState
 //------------------------------------------------------------------------------
@@ -94,8 +79,9 @@ void ActionSavePlaybackState::ExecSession::Run(const AsyncCall::CallbackPtr& com
     ScopeExitFunction scopeExit(boost::bind(&AsyncCall::AsyncRunInMainThread, completionCall));
 
     // Erase previous state from action list exec session.
-    m_alesFuncs->SetValue(GetPlaylistKey(), boost::any());
-    m_alesFuncs->SetValue(GetTrackKey(), boost::any());
+    m_alesFuncs->SetValue(SessionValues::keySavedPlaylist, boost::blank());
+    m_alesFuncs->SetValue(SessionValues::keySavedTrack, boost::blank());
+    m_alesFuncs->SetValue(SessionValues::keySavedPosition, boost::blank());
 
     static_api_ptr_t<playlist_manager> pm;
     t_size playlist = -1;
@@ -103,9 +89,9 @@ void ActionSavePlaybackState::ExecSession::Run(const AsyncCall::CallbackPtr& com
     if (!pm->get_playing_item_location(&playlist, &track))
         return;
 
-    m_alesFuncs->SetValue(GetPlaylistKey(), playlist);
-    m_alesFuncs->SetValue(GetTrackKey(), track);
-	m_alesFuncs->SetValue(GetPositionKey(), static_api_ptr_t<playback_control>()->playback_get_position());
+    m_alesFuncs->SetValue(SessionValues::keySavedPlaylist, playlist);
+    m_alesFuncs->SetValue(SessionValues::keySavedTrack, track);
+	m_alesFuncs->SetValue(SessionValues::keySavedPosition, static_api_ptr_t<playback_control>()->playback_get_position());
 }
 
 const IAction* ActionSavePlaybackState::ExecSession::GetParentAction() const
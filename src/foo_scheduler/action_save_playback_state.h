@@ -20,10 +20,6 @@ public:
         IActionListExecSessionFuncs* m_alesFuncs = nullptr;
     };
 
-    static const char* GetPlaylistKey();
-    static const char* GetTrackKey();
-	static const char* GetPositionKey();
-
 public: // IAction
     virtual GUID GetPrototypeGUID() const;
     virtual int GetPriority() const;
@@ -8,7 +8,8 @@
 //------------------------------------------------------------------------------
 
 ActionSetVolume::ActionSetVolume() :
-	m_volume(0.0), m_useFade(false), m_fadeDuration(1), m_fadeDurationUnits(DurationUnits::seconds)
+	m_volume(0.0), m_useFade(false), m_fadeDuration(1), m_fadeDurationUnits(DurationUnits::seconds),
+	m_fadeCurve(FadeCurve::linearPower), m_fadeResolution(s_defaultFadeResolution)
 {
 
 }
@@ -53,6 +54,26 @@ void ActionSetVolume::SetFadeDurationUnits(DurationUnits::Type val)
 	m_fadeDurationUnits = val;
 }
 
+FadeCurve::Type ActionSetVolume::GetFadeCurve() const
+{
+	return m_fadeCurve;
+}
+
+void ActionSetVolume::SetFadeCurve(FadeCurve::Type val)
+{
+	m_fadeCurve = val;
+}
+
+int ActionSetVolume::GetFadeResolution() const
+{
+	return m_fadeResolution;
+}
+
+void ActionSetVolume::SetFadeResolution(int val)
+{
+	m_fadeResolution = val;
+}
+
 GUID ActionSetVolume::GetPrototypeGUID() const
 {
 	// {91dda9a1-b9b3-44c2-87a5-4abf4786c017} 
@@ -86,6 +107,12 @@ std::wstring ActionSetVolume::GetDescription() const
 		boost::wformat fmt(L"Set volume to %1$.2f dB with fade during %2% %3%");
 		fmt % m_volume % m_fadeDuration % DurationUnits::Label(m_fadeDurationUnits);
 		result = fmt.str();
+
+		if (m_fadeCurve != FadeCurve::linearPower || m_fadeResolution != s_defaultFadeResolution)
+		{
+			result += boost::str(boost::wformat(L" (%1%, %2% ms step)") %
+				FadeCurve::Label(m_fadeCurve) % m_fadeResolution);
+		}
 	}
 	else
 	{
@@ -126,6 +153,12 @@ void ActionSetVolume::LoadFromS11nBlock(const ActionS11nBlock& block)
 
 	if (b.fadeDurationUnits.Exists())
 		m_fadeDurationUnits = static_cast<DurationUnits::Type>(b.fadeDurationUnits.GetValue());
+
+	if (b.fadeCurve.Exists() && b.fadeCurve.GetValue() < FadeCurve::numTypes)
+		m_fadeCurve = static_cast<FadeCurve::Type>(b.fadeCurve.GetValue());
+
+	if (b.fadeResolution.GetValueIfExists(m_fadeResolution))
+		m_fadeResolution = std::max(m_fadeResolution, static_cast<int>(s_minFadeResolution));
 }
 
 void ActionSetVolume::SaveToS11nBlock(ActionS11nBlock& block) const
@@ -139,6 +172,8 @@ void ActionSetVolume::SaveToS11nBlock(ActionS11nBlock& block) const
 	{
 		b.fadeDuration.SetValue(m_fadeDuration);
 		b.fadeDurationUnits.SetValue(m_fadeDurationUnits);
+		b.fadeCurve.SetValue(m_fadeCurve);
+		b.fadeResolution.SetValue(m_fadeResolution);
 	}
 
 	block.setVolume.SetValue(b);
@@ -155,7 +190,8 @@ namespace
 //------------------------------------------------------------------------------
 
 ActionSetVolume::ExecSession::ExecSession(const ActionSetVolume& action) :
-	m_action(action), m_power(0.0f), m_powerStep(0.0f), m_timerID(TimersManager::invalidTimerID), m_secondsLeft(0)
+	m_action(action), m_startDb(0.0f), m_endDb(0.0f), m_numSteps(0), m_step(0), m_stepsPerDescriptionUpdate(1),
+	m_timerID(TimersManager::invalidTimerID)
 {
 }
 
@@ -175,6 +211,15 @@ void ActionSetVolume::ExecSession::Run(const AsyncCall::CallbackPtr& completionC
 		RunWithoutFade();
 }
 
+void ActionSetVolume::ExecSession::Cancel()
+{
+	if (m_timerID == TimersManager::invalidTimerID)
+		return;
+
+	ServiceManager::Instance().GetTimersManager().CloseTimer(m_timerID);
+	m_timerID = TimersManager::invalidTimerID;
+}
+
 const IAction* ActionSetVolume::ExecSession::GetParentAction() const
 {
 	return &m_action;
@@ -182,18 +227,27 @@ const IAction* ActionSetVolume::ExecSession::GetParentAction() const
 
 void ActionSetVolume::ExecSession::OnTimer()
 {
-	static_api_ptr_t<playback_control> pc;
+	// The timer has been closed after this call was queued.
+	if (m_timerID == TimersManager::invalidTimerID)
+		return;
 
-	m_power += m_powerStep;
+	static_api_ptr_t<playback_control> pc;
 
-	pc->set_volume(20.0f * std::log10f(m_power));
+	++m_step;
 
-	--m_secondsLeft;
+	if (m_step < m_numSteps)
+	{
+		const float x = static_cast<float>(m_step) / static_cast<float>(m_numSteps);
+		pc->set_volume(FadeCurve::Evaluate(m_action.GetFadeCurve(), m_startDb, m_endDb, x));
 
-    m_alesFuncs->UpdateDescription();
+		if (m_step % m_stepsPerDescriptionUpdate == 0)
+			m_alesFuncs->UpdateDescription();
 
-	if (m_secondsLeft > 0)
 		return;
+	}
+
+	pc->set_volume(m_endDb);
+	m_alesFuncs->UpdateDescription();
 
 	ServiceManager::Instance().GetTimersManager().CloseTimer(m_timerID);
 	m_timerID = TimersManager::invalidTimerID;
@@ -208,7 +262,9 @@ void ActionSetVolume::ExecSession::Init(IActionListExecSessionFuncs& alesFuncs)
 
 bool ActionSetVolume::ExecSession::GetCurrentStateDescription(std::wstring& descr) const
 {
-	boost::posix_time::time_duration td = boost::posix_time::seconds(m_secondsLeft);
+	const std::size_t stepsLeft = m_numSteps - m_step;
+	boost::posix_time::time_duration td = boost::posix_time::seconds(
+		static_cast<long>(stepsLeft * m_action.GetFadeResolution() / 1000));
 	descr = boost::posix_time::to_simple_wstring(td) + L" left";
 
 	return true;
@@ -234,16 +290,20 @@ void ActionSetVolume::ExecSession::RunWithFade()
 	}
 
 	static_api_ptr_t<playback_control> pc;
-	m_secondsLeft = static_cast<int>(fadeDuration.total_seconds());
 
-	float startPower = std::powf(10.0f, pc->get_volume() / 20.0f);
-	float endPower = std::powf(10.0f, m_action.GetVolume() / 20.0f);
+	const int resolution = m_action.GetFadeResolution();
+	m_numSteps = std::max<std::size_t>(1,
+		static_cast<std::size_t>(fadeDuration.total_milliseconds() / resolution));
 
-	m_power = startPower;
-	m_powerStep = (endPower - startPower) / static_cast<float>(fadeDuration.total_seconds());
+	m_startDb = pc->get_volume();
+	m_endDb = m_action.GetVolume();
+	m_step = 0;
 
-	m_timerID = ServiceManager::Instance().GetTimersManager().CreateTimer(
-		boost::posix_time::second_clock::local_time() + boost::posix_time::seconds(1), boost::posix_time::seconds(1), false);
+	m_stepsPerDescriptionUpdate = std::max(1, 1000 / resolution);
+
+	const boost::posix_time::time_duration period = boost::posix_time::milliseconds(resolution);
+
+	m_timerID = ServiceManager::Instance().GetTimersManager().CreateTimer(period, period, false);
 
 	AsyncCall::CallbackPtr pTimerCallback = AsyncCall::MakeCallback<ActionSetVolume::ExecSession>(shared_from_this(),
 		boost::bind(&ActionSetVolume::ExecSession::OnTimer, this));
@@ -291,6 +351,26 @@ BOOL ActionSetVolumeEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
 	m_durationUnitsCombo = GetDlgItem(IDC_COMBO_DURATION_UNITS);
 	ComboHelpers::InitCombo(m_durationUnitsCombo, comboItems, m_action.GetFadeDurationUnits());
 
+	std::vector<std::pair<std::wstring, int>> curveItems;
+
+	for (int i = 0; i < FadeCurve::numTypes; ++i)
+		curveItems.push_back(std::make_pair(FadeCurve::Label(static_cast<FadeCurve::Type>(i)), i));
+
+	m_fadeCurveCombo = GetDlgItem(IDC_COMBO_FADE_CURVE);
+	ComboHelpers::InitCombo(m_fadeCurveCombo, curveItems, m_action.GetFadeCurve());
+
+	static const int resolutions[] = { 50, 100, 250, 500, 1000 };
+	std::vector<std::pair<std::wstring, int>> resolutionItems;
+
+	for (int i = 0; i < _countof(resolutions); ++i)
+		resolutionItems.push_back(std::make_pair(boost::str(boost::wformat(L"%1% ms") % resolutions[i]), resolutions[i]));
+
+	m_fadeResolutionCombo = GetDlgItem(IDC_COMBO_FADE_RESOLUTION);
+	ComboHelpers::InitCombo(m_fadeResolutionCombo, resolutionItems, m_action.GetFadeResolution());
+
+	if (m_fadeResolutionCombo.GetCurSel() == CB_ERR)
+		m_fadeResolutionCombo.SetCurSel(m_fadeResolutionCombo.GetCount() - 1);
+
 	CUpDownCtrl spin = ::GetDlgItem(m_hWnd, IDC_SPIN_DURATION);
 
 	spin.SetRange(1, ActionSetVolume::s_maxFadeDuration);
@@ -307,6 +387,10 @@ void ActionSetVolumeEditor::EnableFadeDurationControls(bool enable)
 	GetDlgItem(IDC_STATIC_DURATION).EnableWindow(enable);
 	GetDlgItem(IDC_EDIT_DURATION).EnableWindow(enable);
 	GetDlgItem(IDC_COMBO_DURATION_UNITS).EnableWindow(enable);
+	GetDlgItem(IDC_STATIC_FADE_CURVE).EnableWindow(enable);
+	GetDlgItem(IDC_COMBO_FADE_CURVE).EnableWindow(enable);
+	GetDlgItem(IDC_STATIC_FADE_RESOLUTION).EnableWindow(enable);
+	GetDlgItem(IDC_COMBO_FADE_RESOLUTION).EnableWindow(enable);
 }
 
 void ActionSetVolumeEditor::SetVolumeLabel()
@@ -346,11 +430,15 @@ void ActionSetVolumeEditor::OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl
 
 			m_action.SetFadeDuration(duration);
 			m_action.SetFadeDurationUnits(ComboHelpers::GetSelectedItem<DurationUnits::Type>(m_durationUnitsCombo));
+			m_action.SetFadeCurve(ComboHelpers::GetSelectedItem<FadeCurve::Type>(m_fadeCurveCombo));
+			m_action.SetFadeResolution(ComboHelpers::GetSelectedItem<int>(m_fadeResolutionCombo));
 		}
 		else
 		{
 			m_action.SetFadeDuration(1);
 			m_action.SetFadeDurationUnits(DurationUnits::seconds);
+			m_action.SetFadeCurve(FadeCurve::linearPower);
+			m_action.SetFadeResolution(ActionSetVolume::s_defaultFadeResolution);
 		}
 	}
 
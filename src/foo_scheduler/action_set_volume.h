@@ -3,6 +3,7 @@
 #include "resource.h"
 #include "action.h"
 #include "duration_units.h"
+#include "fade_curve.h"
 #include "popup_tooltip_message.h"
 #include "timers_manager.h"
 
@@ -22,6 +23,7 @@ public:
 
 		virtual void Init(IActionListExecSessionFuncs& alesFuncs);
 		virtual void Run(const AsyncCall::CallbackPtr& completionCall);
+		virtual void Cancel();
 		virtual const IAction* GetParentAction() const;
 		virtual bool GetCurrentStateDescription(std::wstring& descr) const;
 
@@ -32,9 +34,17 @@ public:
 
 	private:
 		const ActionSetVolume& m_action;
-		float m_powerStep;
-		float m_power;
-		int m_secondsLeft;
+
+		// The volume of each timer tick is computed from its position in the fade,
+		// long fades at a fine resolution have too many steps to be precomputed.
+		float m_startDb;
+		float m_endDb;
+		std::size_t m_numSteps;
+		std::size_t m_step;
+
+		// The description is updated about once a second, not on every tick.
+		std::size_t m_stepsPerDescriptionUpdate;
+
 		TimersManager::TimerID m_timerID;
 		AsyncCall::CallbackPtr m_completionCall;
         IActionListExecSessionFuncs* m_alesFuncs = nullptr;
@@ -42,6 +52,9 @@ public:
 
 	static const int s_maxFadeDuration = 24 * 60 * 60 * 365;
 
+	static const int s_minFadeResolution = 50;
+	static const int s_defaultFadeResolution = 1000;
+
 	ActionSetVolume();
 
 	float GetVolume() const;
@@ -56,6 +69,13 @@ public:
 	DurationUnits::Type GetFadeDurationUnits() const;
 	void SetFadeDurationUnits(DurationUnits::Type val);
 
+	FadeCurve::Type GetFadeCurve() const;
+	void SetFadeCurve(FadeCurve::Type val);
+
+	// Interval between volume updates during fade, in milliseconds.
+	int GetFadeResolution() const;
+	void SetFadeResolution(int val);
+
 public: // IAction
 	virtual GUID GetPrototypeGUID() const;
 	virtual int GetPriority() const;
@@ -75,6 +95,8 @@ private:
 	bool m_useFade;
 	int m_fadeDuration;
 	DurationUnits::Type m_fadeDurationUnits;
+	FadeCurve::Type m_fadeCurve;
+	int m_fadeResolution;
 };
 
 //------------------------------------------------------------------------------
@@ -112,6 +134,8 @@ private:
 
 private:
 	CComboBox m_durationUnitsCombo;
+	CComboBox m_fadeCurveCombo;
+	CComboBox m_fadeResolutionCombo;
 	CButton m_checkUseFade;
 
 	float m_volume;
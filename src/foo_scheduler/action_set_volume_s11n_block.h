@@ -8,10 +8,12 @@ struct ActionSetVolumeS11nBlock : public S11nBlocks::Block<ActionSetVolumeS11nBl
 	S11nBlocks::Field<bool, 2> useFade;
 	S11nBlocks::Field<int, 3> fadeDuration;
 	S11nBlocks::Field<int, 4> fadeDurationUnits;
+	S11nBlocks::Field<int, 5> fadeCurve;
+	S11nBlocks::Field<int, 6> fadeResolution;
 
 	template<class Archive>
 	void RegisterFields(Archive& ar)
 	{
-		ar.RegisterFields(volume)(useFade)(fadeDuration)(fadeDurationUnits);
+		ar.RegisterFields(volume)(useFade)(fadeDuration)(fadeDurationUnits)(fadeCurve)(fadeResolution);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "pch.h"
+#include "action_shared_variable.h"
+#include "action_shared_variable_s11n_block.h"
+#include "service_manager.h"
+#include "scope_exit_function.h"
+
+namespace
+{
+	// Names of the shared variables holding a stored playback state.
+	std::wstring PlaylistVariableName(const std::wstring& name)
+	{
+		return name + L"/playlist";
+	}
+
+	std::wstring TrackVariableName(const std::wstring& name)
+	{
+		return name + L"/track";
+	}
+
+	std::wstring PositionVariableName(const std::wstring& name)
+	{
+		return name + L"/position";
+	}
+
+	SessionValues::Value ParseValue(const std::wstring& text)
+	{
+		if (!text.empty())
+		{
+			wchar_t* end = 0;
+			const double number = wcstod(text.c_str(), &end);
+
+			if (*end == L'\0')
+				return number;
+		}
+
+		return text;
+	}
+}
+
+ActionSharedVariable::ActionSharedVariable() : m_operation(opSetValue), m_persistent(false)
+{
+}
+
+GUID ActionSharedVariable::GetPrototypeGUID() const
+{
+	// {8f2d283c-5351-43f7-b9b0-dd0739435690} mod guid
+	static const GUID result = 
+	{ 0x8f2d283c, 0x5351, 0x43f7, { 0xb9, 0xb0, 0xdd, 0x07, 0x39, 0x43, 0x56, 0x90 } };
+
+	return result;
+}
+
+int ActionSharedVariable::GetPriority() const
+{
+	return 47;
+}
+
+std::wstring ActionSharedVariable::GetName() const
+{
+	return L"Shared variable";
+}
+
+IAction* ActionSharedVariable::Clone() const
+{
+	return new ActionSharedVariable(*this);
+}
+
+std::wstring ActionSharedVariable::GetDescription() const
+{
+	std::wstring result;
+
+	switch (m_operation)
+	{
+	case opSetValue:
+		result = boost::str(boost::wformat(L"Set shared variable \"%1%\" to \"%2%\"") % m_name % m_value);
+		break;
+
+	case opClear:
+		return boost::str(boost::wformat(L"Clear shared variable \"%1%\"") % m_name);
+
+	case opStorePlaybackState:
+		result = boost::str(boost::wformat(L"Store saved playback state in \"%1%\"") % m_name);
+		break;
+
+	case opRestorePlaybackState:
+		return boost::str(boost::wformat(L"Restore saved playback state from \"%1%\"") % m_name);
+
+	default:
+		_ASSERTE(false);
+		return std::wstring();
+	}
+
+	if (m_persistent)
+		result += L" (persistent)";
+
+	return result;
+}
+
+bool ActionSharedVariable::HasConfigDialog() const
+{
+	return true;
+}
+
+bool ActionSharedVariable::ShowConfigDialog(CWindow parent)
+{
+	ActionSharedVariableEditor dlg(*this);
+	return dlg.DoModal(parent) == IDOK;
+}
+
+ActionExecSessionPtr ActionSharedVariable::CreateExecSession() const
+{
+	return ActionExecSessionPtr(new ExecSession(*this));
+}
+
+void ActionSharedVariable::LoadFromS11nBlock(const ActionS11nBlock& block)
+{
+	if (!block.sharedVariable.Exists())
+		return;
+
+	const ActionSharedVariableS11nBlock& b = block.sharedVariable.GetValue();
+
+	if (b.operation.Exists())
+		m_operation = static_cast<EOperation>(b.operation.GetValue());
+
+	if (b.name.Exists())
+		m_name = pfc::stringcvt::string_wide_from_utf8(b.name.GetValue()).get_ptr();
+
+	if (b.value.Exists())
+		m_value = pfc::stringcvt::string_wide_from_utf8(b.value.GetValue()).get_ptr();
+
+	b.persistent.GetValueIfExists(m_persistent);
+}
+
+void ActionSharedVariable::SaveToS11nBlock(ActionS11nBlock& block) const
+{
+	ActionSharedVariableS11nBlock b;
+
+	b.operation.SetValue(m_operation);
+	b.name.SetValue(pfc::stringcvt::string_utf8_from_wide(m_name.c_str()).toString());
+
+	if (m_operation == opSetValue)
+		b.value.SetValue(pfc::stringcvt::string_utf8_from_wide(m_value.c_str()).toString());
+
+	b.persistent.SetValue(m_persistent);
+
+	block.sharedVariable.SetValue(b);
+}
+
+ActionSharedVariable::EOperation ActionSharedVariable::GetOperation() const
+{
+	return m_operation;
+}
+
+void ActionSharedVariable::SetOperation(EOperation operation)
+{
+	m_operation = operation;
+}
+
+std::wstring ActionSharedVariable::GetVariableName() const
+{
+	return m_name;
+}
+
+void ActionSharedVariable::SetVariableName(const std::wstring& name)
+{
+	m_name = name;
+}
+
+std::wstring ActionSharedVariable::GetValue() const
+{
+	return m_value;
+}
+
+void ActionSharedVariable::SetValue(const std::wstring& value)
+{
+	m_value = value;
+}
+
+bool ActionSharedVariable::IsPersistent() const
+{
+	return m_persistent;
+}
+
+void ActionSharedVariable::SetPersistent(bool persistent)
+{
+	m_persistent = persistent;
+}
+
+namespace
+{
+	const bool registered = ServiceManager::Instance().GetActionPrototypesManager().RegisterPrototype(
+		new ActionSharedVariable);
+}
+
+//------------------------------------------------------------------------------
+// ActionSharedVariable::ExecSession
+//------------------------------------------------------------------------------
+
+ActionSharedVariable::ExecSession::ExecSession(const ActionSharedVariable& action) : m_action(action)
+{
+}
+
+void ActionSharedVariable::ExecSession::Run(const AsyncCall::CallbackPtr& completionCall)
+{
+	ScopeExitFunction scopeExit(boost::bind(&AsyncCall::AsyncRunInMainThread, completionCall));
+
+	SharedVariables& sharedVariables = ServiceManager::Instance().GetSharedVariables();
+	const std::wstring name = m_action.GetVariableName();
+
+	switch (m_action.GetOperation())
+	{
+	case ActionSharedVariable::opSetValue:
+		sharedVariables.Set(name, ParseValue(m_action.GetValue()), m_action.IsPersistent());
+		break;
+
+	case ActionSharedVariable::opClear:
+		sharedVariables.Set(name, boost::blank(), false);
+		break;
+
+	case ActionSharedVariable::opStorePlaybackState:
+		{
+			SharedVariables::Variables changes;
+
+			changes[PlaylistVariableName(name)].value = m_alesFuncs->GetValue(SessionValues::keySavedPlaylist);
+			changes[TrackVariableName(name)].value = m_alesFuncs->GetValue(SessionValues::keySavedTrack);
+			changes[PositionVariableName(name)].value = m_alesFuncs->GetValue(SessionValues::keySavedPosition);
+
+			for (auto it = changes.begin(); it != changes.end(); ++it)
+				it->second.persistent = m_action.IsPersistent();
+
+			sharedVariables.Set(changes);
+		}
+		break;
+
+	case ActionSharedVariable::opRestorePlaybackState:
+		{
+			SharedVariables::SnapshotPtr pSnapshot = sharedVariables.GetSnapshot();
+
+			m_alesFuncs->SetValue(SessionValues::keySavedPlaylist, pSnapshot->GetValue(PlaylistVariableName(name)));
+			m_alesFuncs->SetValue(SessionValues::keySavedTrack, pSnapshot->GetValue(TrackVariableName(name)));
+			m_alesFuncs->SetValue(SessionValues::keySavedPosition, pSnapshot->GetValue(PositionVariableName(name)));
+		}
+		break;
+	}
+}
+
+const IAction* ActionSharedVariable::ExecSession::GetParentAction() const
+{
+	return &m_action;
+}
+
+void ActionSharedVariable::ExecSession::Init(IActionListExecSessionFuncs& alesFuncs)
+{
+	m_alesFuncs = &alesFuncs;
+}
+
+bool ActionSharedVariable::ExecSession::GetCurrentStateDescription(std::wstring& /*descr*/) const
+{
+	return false;
+}
+
+//------------------------------------------------------------------------------
+// ActionSharedVariableEditor
+//------------------------------------------------------------------------------
+
+ActionSharedVariableEditor::ActionSharedVariableEditor(ActionSharedVariable& action) :
+	m_action(action), m_operation(action.GetOperation()),
+	m_name(action.GetVariableName().c_str()), m_value(action.GetValue().c_str()),
+	m_persistent(action.IsPersistent())
+{
+}
+
+BOOL ActionSharedVariableEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
+{
+	DoDataExchange(DDX_LOAD);
+	UpdateControlsState();
+	CenterWindow(GetParent());
+
+	// dark mode
+	m_dark.AddDialogWithControls(m_hWnd);
+
+	return TRUE;
+}
+
+void ActionSharedVariableEditor::OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	if (nID == IDOK)
+	{
+		if (!DoDataExchange(DDX_SAVE))
+			return;
+
+		m_name.Trim();
+
+		if (m_name.IsEmpty())
+		{
+			m_popupTooltipMsg.Show(L"Enter the name of the variable.", GetDlgItem(IDC_EDIT_VARIABLE_NAME));
+			return;
+		}
+
+		const ActionSharedVariable::EOperation operation = static_cast<ActionSharedVariable::EOperation>(m_operation);
+
+		m_action.SetOperation(operation);
+		m_action.SetVariableName(m_name.GetString());
+		m_action.SetValue(operation == ActionSharedVariable::opSetValue ? m_value.GetString() : std::wstring());
+		m_action.SetPersistent(m_persistent);
+	}
+
+	EndDialog(nID);
+}
+
+void ActionSharedVariableEditor::OnOperationSelected(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	DoDataExchange(DDX_SAVE);
+	UpdateControlsState();
+}
+
+void ActionSharedVariableEditor::UpdateControlsState()
+{
+	GetDlgItem(IDC_EDIT_VARIABLE_VALUE).EnableWindow(m_operation == ActionSharedVariable::opSetValue);
+
+	GetDlgItem(IDC_CHECK_VARIABLE_PERSISTENT).EnableWindow(
+		m_operation == ActionSharedVariable::opSetValue || m_operation == ActionSharedVariable::opStorePlaybackState);
+}
\ No newline at end of file
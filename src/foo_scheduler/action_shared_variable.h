@@ -0,0 +1,127 @@
+#pragma once
+
+#include "resource.h"
+#include "action.h"
+#include "popup_tooltip_message.h"
+
+//------------------------------------------------------------------------------
+// ActionSharedVariable
+//------------------------------------------------------------------------------
+
+class ActionSharedVariable : public IAction
+{
+public:
+	class ExecSession : public IActionExecSession
+	{
+	public:
+		explicit ExecSession(const ActionSharedVariable& action);
+
+		virtual void Init(IActionListExecSessionFuncs& alesFuncs);
+		virtual void Run(const AsyncCall::CallbackPtr& completionCall);
+		virtual const IAction* GetParentAction() const;
+		virtual bool GetCurrentStateDescription(std::wstring& descr) const;
+
+	private:
+		const ActionSharedVariable& m_action;
+		IActionListExecSessionFuncs* m_alesFuncs = nullptr;
+	};
+
+	ActionSharedVariable();
+
+	enum EOperation
+	{
+		opSetValue = 0,
+		opClear,
+
+		// Copy the state saved by the "Save playback state" action to the shared variables and back,
+		// so that another action list can restore it.
+		opStorePlaybackState,
+		opRestorePlaybackState,
+	};
+
+	EOperation GetOperation() const;
+	void SetOperation(EOperation operation);
+
+	std::wstring GetVariableName() const;
+	void SetVariableName(const std::wstring& name);
+
+	// Stored as a number if the whole text is a number.
+	std::wstring GetValue() const;
+	void SetValue(const std::wstring& value);
+
+	bool IsPersistent() const;
+	void SetPersistent(bool persistent);
+
+public: // IAction
+	virtual GUID GetPrototypeGUID() const;
+	virtual int GetPriority() const;
+	virtual std::wstring GetName() const;
+	virtual IAction* Clone() const;
+
+	virtual std::wstring GetDescription() const;
+	virtual bool HasConfigDialog() const;
+	virtual bool ShowConfigDialog(CWindow parent);
+	virtual ActionExecSessionPtr CreateExecSession() const;
+
+	virtual void LoadFromS11nBlock(const ActionS11nBlock& block);
+	virtual void SaveToS11nBlock(ActionS11nBlock& block) const;
+
+private:
+	EOperation m_operation;
+	std::wstring m_name;
+	std::wstring m_value; // Used only when m_operation == opSetValue
+	bool m_persistent;
+};
+
+//------------------------------------------------------------------------------
+// ActionSharedVariableEditor
+//------------------------------------------------------------------------------
+
+class ActionSharedVariableEditor :
+	public CDialogImpl<ActionSharedVariableEditor>,
+	public CWinDataExchange<ActionSharedVariableEditor>
+{
+public:
+	enum { IDD = IDD_ACTION_SHARED_VARIABLE_CONFIG };
+
+	explicit ActionSharedVariableEditor(ActionSharedVariable& action);
+
+private:
+	BEGIN_MSG_MAP_EX(ActionSharedVariableEditor)
+		MSG_WM_INITDIALOG(OnInitDialog)
+
+		COMMAND_ID_HANDLER_EX(IDC_RADIO_VARIABLE_SET, OnOperationSelected)
+		COMMAND_ID_HANDLER_EX(IDC_RADIO_VARIABLE_CLEAR, OnOperationSelected)
+		COMMAND_ID_HANDLER_EX(IDC_RADIO_VARIABLE_STORE_STATE, OnOperationSelected)
+		COMMAND_ID_HANDLER_EX(IDC_RADIO_VARIABLE_RESTORE_STATE, OnOperationSelected)
+
+		COMMAND_ID_HANDLER_EX(IDOK,     OnCloseCmd)
+		COMMAND_ID_HANDLER_EX(IDCANCEL, OnCloseCmd)
+	END_MSG_MAP()
+
+	BEGIN_DDX_MAP(ActionSharedVariableEditor)
+		DDX_TEXT(IDC_EDIT_VARIABLE_NAME, m_name)
+		DDX_TEXT(IDC_EDIT_VARIABLE_VALUE, m_value)
+		DDX_RADIO(IDC_RADIO_VARIABLE_SET, m_operation)
+		DDX_CHECK(IDC_CHECK_VARIABLE_PERSISTENT, m_persistent)
+	END_DDX_MAP()
+
+	BOOL OnInitDialog(CWindow wndFocus, LPARAM lInitParam);
+
+	void OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnOperationSelected(UINT uNotifyCode, int nID, CWindow wndCtl);
+
+private:
+	void UpdateControlsState();
+
+private:
+	ActionSharedVariable& m_action;
+
+	int m_operation;
+	CString m_name;
+	CString m_value;
+	bool m_persistent;
+
+	PopupTooltipMessage m_popupTooltipMsg;
+	fb2k::CDarkModeHooks m_dark;
+};
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "s11n_blocks.h"
+
+struct ActionSharedVariableS11nBlock : public S11nBlocks::Block<ActionSharedVariableS11nBlock>
+{
+	S11nBlocks::Field<int, 1> operation;
+	S11nBlocks::Field<pfc::string8, 2> name;
+	S11nBlocks::Field<pfc::string8, 3> value;
+	S11nBlocks::Field<bool, 4> persistent;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(operation)(name)(value)(persistent);
+	}
+};
\ No newline at end of file
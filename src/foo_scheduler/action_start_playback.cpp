@@ -2,7 +2,6 @@
 #include "action_start_playback.h"
 #include "service_manager.h"
 #include "action_start_playback_s11n_block.h"
-#include "action_save_playback_state.h"
 #include "scope_exit_function.h"
 
 //------------------------------------------------------------------------------
@@ -156,11 +155,8 @@ void ActionStartPlayback::ExecSession::Run(const AsyncCall::CallbackPtr& complet
 	}
     else if (m_action.GetStartPlaybackType() == startTypeFromSavedState)
     {
-        const boost::any playlistAny = m_alesFuncs->GetValue(ActionSavePlaybackState::GetPlaylistKey());
-        const boost::any trackAny = m_alesFuncs->GetValue(ActionSavePlaybackState::GetTrackKey());
-
-        const t_size* playlist = boost::any_cast<t_size>(&playlistAny);
-        const t_size* track = boost::any_cast<t_size>(&trackAny);
+        const t_size* playlist = boost::get<t_size>(&m_alesFuncs->GetValue(SessionValues::keySavedPlaylist));
+        const t_size* track = boost::get<t_size>(&m_alesFuncs->GetValue(SessionValues::keySavedTrack));
 
         if (!playlist || !track)
             return;
@@ -190,8 +186,7 @@ void ActionStartPlayback::ExecSession::on_playback_new_track(metadb_handle_ptr p
 
             if (m_action.GetStartPlaybackType() == startTypeFromSavedState)
             {
-                const boost::any positionAny = m_alesFuncs->GetValue(ActionSavePlaybackState::GetPositionKey());
-                if (const double* position = boost::any_cast<double>(&positionAny))
+                if (const double* position = boost::get<double>(&m_alesFuncs->GetValue(SessionValues::keySavedPosition)))
                 {
                     pc->playback_seek(*position);
                 }
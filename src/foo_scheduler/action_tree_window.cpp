@@ -4,6 +4,7 @@
 #include "action_list.h"
 #include "pref_page_model.h"
 #include "generate_duplicate_name.h"
+#include "action_call_task.h"
 
 void ActionTreeWindow::Init(HWND hwndParent, UINT ctrlID, PrefPageModel* pModel)
 {
@@ -127,7 +128,7 @@ void ActionTreeWindow::ShowActionListContextMenu(CTreeItem ti, const CPoint& pnt
 		{
 			std::unique_ptr<IAction> pNewAction(actionPrototypes[uCmdID - 1]->Clone());
 
-			if (pNewAction->HasConfigDialog() && !pNewAction->ShowConfigDialog(*this))
+			if (pNewAction->HasConfigDialog() && !ShowActionConfigDialog(pNewAction.get(), pActionList))
 				return;
 
 			m_pModel->AddActionToActionList(pActionList, std::move(pNewAction));
@@ -172,7 +173,7 @@ void ActionTreeWindow::ShowActionContextMenu(CTreeItem ti, const CPoint& pntScre
 		return;
 
 	case actionMenuItemEdit:
-		if (pAction->ShowConfigDialog(*this))
+		if (ShowActionConfigDialog(pAction, pActionList))
 			m_pModel->UpdateAction(pActionList, pAction);
 		break;
 
@@ -248,8 +249,10 @@ void ActionTreeWindow::OnLButtonDblClk(UINT nFlags, CPoint point)
 	tiHit.Select();
 
 	IAction* pAction = static_cast<IAction*>(pItemData->pObj);
-	if (pAction->HasConfigDialog() && pAction->ShowConfigDialog(*this))
-		m_pModel->UpdateAction(GetParentActionList(tiHit), pAction);
+	ActionList* pActionList = GetParentActionList(tiHit);
+
+	if (pAction->HasConfigDialog() && ShowActionConfigDialog(pAction, pActionList))
+		m_pModel->UpdateAction(pActionList, pAction);
 
 	SetMsgHandled(true);
 }
@@ -321,6 +324,14 @@ ActionList* ActionTreeWindow::GetParentActionList(const CTreeItem& tiAction)
 	return static_cast<ActionList*>(pItemData->pObj);
 }
 
+bool ActionTreeWindow::ShowActionConfigDialog(IAction* pAction, ActionList* pActionList)
+{
+	if (ActionCallTask* pCallTask = dynamic_cast<ActionCallTask*>(pAction))
+		return pCallTask->ShowConfigDialog(*this, m_pModel->GetActionLists(), pActionList->GetGUID());
+
+	return pAction->ShowConfigDialog(*this);
+}
+
 CTreeItem ActionTreeWindow::FindActionItem(ActionList* pActionList, IAction* pAction)
 {
 	CTreeItem ti = FindActionListItem(pActionList);
@@ -33,6 +33,9 @@ private:
 
 	ActionList* GetParentActionList(const CTreeItem& tiAction);
 
+	// Some actions need the edited tasks in their editors.
+	bool ShowActionConfigDialog(IAction* pAction, ActionList* pActionList);
+
 private:
 	void OnActionListAdded(ActionList* pActionList);
 	void OnActionListRemoved(ActionList* pActionList);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ref_counted.h"
+#include "metrics.h"
 
 namespace AsyncCall
 {
@@ -39,18 +40,35 @@ namespace AsyncCall
 			boost::function<void (AsyncController*)> m_func;
 		};
 
+		class FunctionCallbackImpl : public RefCountedImpl<ICallback, true>
+		{
+		public:
+			explicit FunctionCallbackImpl(const boost::function<void ()>& func) : m_func(func) {}
+
+			virtual void Run()
+			{
+				m_func();
+			}
+
+		private:
+			boost::function<void ()> m_func;
+		};
+
 		class MainThreadCallbackImpl : public main_thread_callback
 		{
 		public:
-			MainThreadCallbackImpl(const CallbackPtr& callback) : m_callback(callback) {}
+			MainThreadCallbackImpl(const CallbackPtr& callback) :
+				m_callback(callback), m_queuedTime(Metrics::NowMicroseconds()) {}
 
 			virtual void callback_run()
 			{
+				Metrics::Record(Metrics::histMainThreadQueueDelay, Metrics::NowMicroseconds() - m_queuedTime);
 				m_callback->Run();
 			}
 
 		private:
 			CallbackPtr m_callback;
+			__int64 m_queuedTime;
 		};
 
 	} // namespace Detail
@@ -63,6 +81,12 @@ namespace AsyncCall
 		return CallbackPtr(new Detail::CallbackImpl<AsyncController>(pController, func));
 	}
 
+	// func must stay valid until the callback is run or released.
+	inline CallbackPtr MakeCallback(const boost::function<void ()>& func)
+	{
+		return CallbackPtr(new Detail::FunctionCallbackImpl(func));
+	}
+
 	inline void AsyncRunInMainThread(const CallbackPtr& callback)
 	{
 		typedef Detail::MainThreadCallbackImpl CallbackImpl;
@@ -0,0 +1,37 @@
+#pragma once
+
+// What happens when a task is triggered while it's running.
+namespace ConcurrencyPolicy
+{
+	enum Type
+	{
+		parallel = 0,  // Start another run.
+		skipIfRunning, // Drop the new run.
+		restart,       // Stop the running one and start the new run.
+		queue,         // Start the new run after the running one, up to the max queue depth.
+
+		numTypes
+	};
+
+	inline std::wstring Label(Type type)
+	{
+		switch (type)
+		{
+		case parallel:
+			return L"run in parallel";
+
+		case skipIfRunning:
+			return L"skip if running";
+
+		case restart:
+			return L"restart";
+
+		case queue:
+			return L"queue";
+		}
+
+		_ASSERTE(false);
+		return std::wstring();
+	}
+
+} // namespace ConcurrencyPolicy
\ No newline at end of file
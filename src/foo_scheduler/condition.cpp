@@ -0,0 +1,740 @@
+#include "pch.h"
+#include "condition.h"
+#include "service_manager.h"
+
+//------------------------------------------------------------------------------
+// Condition::Compiler
+//------------------------------------------------------------------------------
+
+class Condition::Compiler
+{
+public:
+	Compiler(Condition& condition, const std::wstring& text)
+		: m_condition(condition), m_text(text), m_pos(0), m_depth(0), m_nesting(0)
+	{
+	}
+
+	struct SyntaxError
+	{
+		SyntaxError(std::size_t pos, const std::wstring& message) : pos(pos), message(message)
+		{
+		}
+
+		std::wstring Format() const
+		{
+			return boost::str(boost::wformat(L"%1% at position %2%.") % message % (pos + 1));
+		}
+
+		std::size_t pos; // Offset in the text.
+		std::wstring message;
+	};
+
+	// Throws SyntaxError.
+	void Compile()
+	{
+		NextToken();
+		ParseOr();
+
+		if (m_token.type != tokenEnd)
+			throw Unexpected();
+
+		_ASSERTE(m_depth == 1);
+	}
+
+private:
+	enum TokenType
+	{
+		tokenEnd,
+		tokenNumber,
+		tokenString,
+		tokenField,
+		tokenIdentifier,
+		tokenOperator,
+		tokenOpenParen,
+		tokenCloseParen,
+	};
+
+	struct Token
+	{
+		TokenType type;
+		std::wstring text;
+		double number;
+		std::size_t pos;
+	};
+
+	void NextToken()
+	{
+		while (m_pos < m_text.size() && iswspace(m_text[m_pos]))
+			++m_pos;
+
+		m_token.pos = m_pos;
+		m_token.text.clear();
+		m_token.number = 0;
+
+		if (m_pos == m_text.size())
+		{
+			m_token.type = tokenEnd;
+			return;
+		}
+
+		const wchar_t c = m_text[m_pos];
+
+		if (iswdigit(c) || (c == L'-' && m_pos + 1 < m_text.size() && iswdigit(m_text[m_pos + 1])))
+		{
+			LexNumber();
+			return;
+		}
+
+		if (c == L'"' || c == L'%')
+		{
+			// "string" with "" for a quote, or %field%.
+			m_token.type = c == L'"' ? tokenString : tokenField;
+			++m_pos;
+
+			for (;;)
+			{
+				if (m_pos == m_text.size())
+					throw Error(m_token.pos, c == L'"' ? L"Unterminated string" : L"Unterminated field");
+
+				if (m_text[m_pos] == c)
+				{
+					if (c == L'"' && m_pos + 1 < m_text.size() && m_text[m_pos + 1] == L'"')
+						++m_pos;
+					else
+						break;
+				}
+
+				m_token.text += m_text[m_pos++];
+			}
+
+			++m_pos;
+
+			if (m_token.type == tokenField)
+				m_token.text = L"%" + m_token.text + L"%";
+
+			return;
+		}
+
+		if (iswalpha(c) || c == L'_')
+		{
+			m_token.type = tokenIdentifier;
+
+			while (m_pos < m_text.size() && (iswalnum(m_text[m_pos]) || m_text[m_pos] == L'_'))
+				m_token.text += towlower(m_text[m_pos++]);
+
+			return;
+		}
+
+		if (c == L'(' || c == L')')
+		{
+			m_token.type = c == L'(' ? tokenOpenParen : tokenCloseParen;
+			++m_pos;
+			return;
+		}
+
+		static const wchar_t* const operators[] =
+		{
+			L"==", L"!=", L"<>", L"<=", L">=", L"&&", L"||", L"=", L"<", L">", L"!"
+		};
+
+		for (std::size_t i = 0; i < _countof(operators); ++i)
+		{
+			if (m_text.compare(m_pos, wcslen(operators[i]), operators[i]) == 0)
+			{
+				m_token.type = tokenOperator;
+				m_token.text = operators[i];
+				m_pos += m_token.text.size();
+				return;
+			}
+		}
+
+		throw Error(m_pos, boost::str(boost::wformat(L"Unexpected '%1%'") % c));
+	}
+
+	// Numbers, including negative ones, and HH:MM time literals, which are minutes since midnight.
+	void LexNumber()
+	{
+		m_token.type = tokenNumber;
+
+		const wchar_t* begin = m_text.c_str() + m_pos;
+		wchar_t* end = 0;
+		m_token.number = wcstod(begin, &end);
+		m_pos += end - begin;
+
+		if (m_pos < m_text.size() && m_text[m_pos] == L':')
+		{
+			++m_pos;
+
+			const std::size_t minutesPos = m_pos;
+			while (m_pos < m_text.size() && iswdigit(m_text[m_pos]))
+				++m_pos;
+
+			const int minutes = m_pos - minutesPos == 2 ? _wtoi(m_text.c_str() + minutesPos) : -1;
+			const double hours = m_token.number;
+
+			if (minutes < 0 || minutes > 59 || hours != floor(hours) || hours < 0 || hours > 24 || (hours == 24 && minutes != 0))
+				throw Error(m_token.pos, L"Invalid time, expected HH:MM");
+
+			m_token.number = hours * 60 + minutes;
+		}
+	}
+
+	void ParseOr()
+	{
+		ParseAnd();
+
+		while (IsKeyword(L"or") || IsOperator(L"||"))
+		{
+			const std::size_t jump = Emit(opJumpIfTrueOrPop, 0, -1);
+			NextToken();
+			ParseAnd();
+			PatchJump(jump);
+		}
+	}
+
+	void ParseAnd()
+	{
+		ParseNot();
+
+		while (IsKeyword(L"and") || IsOperator(L"&&"))
+		{
+			const std::size_t jump = Emit(opJumpIfFalseOrPop, 0, -1);
+			NextToken();
+			ParseNot();
+			PatchJump(jump);
+		}
+	}
+
+	void ParseNot()
+	{
+		if (IsKeyword(L"not") || IsOperator(L"!"))
+		{
+			if (++m_nesting > maxStackDepth)
+				throw Error(m_token.pos, L"Expression is too complex");
+
+			NextToken();
+			ParseNot();
+			Emit(opNot, 0, 0);
+
+			--m_nesting;
+			return;
+		}
+
+		ParseComparison();
+	}
+
+	void ParseComparison()
+	{
+		ParsePrimary();
+
+		if (m_token.type != tokenOperator)
+			return;
+
+		OpCode op;
+
+		if (m_token.text == L"=" || m_token.text == L"==")
+			op = opEqual;
+		else if (m_token.text == L"!=" || m_token.text == L"<>")
+			op = opNotEqual;
+		else if (m_token.text == L"<")
+			op = opLess;
+		else if (m_token.text == L"<=")
+			op = opLessEqual;
+		else if (m_token.text == L">")
+			op = opGreater;
+		else if (m_token.text == L">=")
+			op = opGreaterEqual;
+		else
+			return;
+
+		NextToken();
+		ParsePrimary();
+		Emit(op, 0, -1);
+	}
+
+	void ParsePrimary()
+	{
+		switch (m_token.type)
+		{
+		case tokenNumber:
+			EmitConstant(m_token.number);
+			break;
+
+		case tokenString:
+			Emit(opPushString, AddString(m_token.text), 1);
+			break;
+
+		case tokenField:
+			Emit(opPushFormat, AddFormat(m_token.text), 1);
+			break;
+
+		case tokenOpenParen:
+			{
+				if (++m_nesting > maxStackDepth)
+					throw Error(m_token.pos, L"Expression is too complex");
+
+				NextToken();
+				ParseOr();
+
+				if (m_token.type != tokenCloseParen)
+					throw Error(m_token.pos, L"Expected ')'");
+
+				--m_nesting;
+			}
+			break;
+
+		case tokenIdentifier:
+			ParseIdentifier();
+			return;
+
+		default:
+			throw Unexpected();
+		}
+
+		NextToken();
+	}
+
+	void ParseIdentifier()
+	{
+		const Token identifier = m_token;
+		NextToken();
+
+		if (m_token.type == tokenOpenParen)
+		{
+			// var("name") or format("script")
+			NextToken();
+
+			if (m_token.type != tokenString)
+				throw Error(m_token.pos, L"Expected a string");
+
+			if (identifier.text == L"var")
+				Emit(opPushVariable, AddString(m_token.text), 1);
+			else if (identifier.text == L"format")
+				Emit(opPushFormat, AddFormat(m_token.text), 1);
+			else
+				throw Error(identifier.pos, boost::str(boost::wformat(L"Unknown function '%1%'") % identifier.text));
+
+			NextToken();
+
+			if (m_token.type != tokenCloseParen)
+				throw Error(m_token.pos, L"Expected ')'");
+
+			NextToken();
+			return;
+		}
+
+		static const struct
+		{
+			const wchar_t* name;
+			OpCode op;
+		} values[] =
+		{
+			{ L"time", opPushTime },
+			{ L"weekday", opPushWeekday },
+			{ L"day", opPushDay },
+			{ L"month", opPushMonth },
+			{ L"playing", opPushPlaying },
+			{ L"paused", opPushPaused },
+			{ L"stopped", opPushStopped },
+			{ L"volume", opPushVolume },
+		};
+
+		for (std::size_t i = 0; i < _countof(values); ++i)
+		{
+			if (identifier.text == values[i].name)
+			{
+				Emit(values[i].op, 0, 1);
+				return;
+			}
+		}
+
+		static const wchar_t* const weekdays[] = { L"mon", L"tue", L"wed", L"thu", L"fri", L"sat", L"sun" };
+
+		for (std::size_t i = 0; i < _countof(weekdays); ++i)
+		{
+			if (identifier.text == weekdays[i])
+			{
+				EmitConstant(static_cast<double>(i + 1));
+				return;
+			}
+		}
+
+		if (identifier.text == L"true" || identifier.text == L"false")
+		{
+			EmitConstant(identifier.text == L"true" ? 1 : 0);
+			return;
+		}
+
+		throw Error(identifier.pos, boost::str(boost::wformat(L"Unknown name '%1%'") % identifier.text));
+	}
+
+	bool IsKeyword(const wchar_t* keyword) const
+	{
+		return m_token.type == tokenIdentifier && m_token.text == keyword;
+	}
+
+	bool IsOperator(const wchar_t* op) const
+	{
+		return m_token.type == tokenOperator && m_token.text == op;
+	}
+
+	// stackChange is the change of the stack depth after the instruction.
+	std::size_t Emit(OpCode op, std::size_t arg, int stackChange)
+	{
+		if (arg > USHRT_MAX || m_condition.m_code.size() >= USHRT_MAX)
+			throw Error(m_token.pos, L"Expression is too long");
+
+		m_depth += stackChange;
+		if (m_depth > maxStackDepth)
+			throw Error(m_token.pos, L"Expression is too complex");
+
+		Instruction instruction = { static_cast<unsigned short>(op), static_cast<unsigned short>(arg) };
+		m_condition.m_code.push_back(instruction);
+
+		return m_condition.m_code.size() - 1;
+	}
+
+	void EmitConstant(double number)
+	{
+		m_condition.m_numbers.push_back(number);
+		Emit(opPushNumber, m_condition.m_numbers.size() - 1, 1);
+	}
+
+	// Jumps to the end of the code emitted so far.
+	void PatchJump(std::size_t jump)
+	{
+		m_condition.m_code[jump].arg = static_cast<unsigned short>(m_condition.m_code.size());
+	}
+
+	std::size_t AddString(const std::wstring& s)
+	{
+		m_condition.m_strings.push_back(s);
+		return m_condition.m_strings.size() - 1;
+	}
+
+	std::size_t AddFormat(const std::wstring& script)
+	{
+		m_condition.m_formatScripts.push_back(pfc::stringcvt::string_utf8_from_wide(script.c_str()).get_ptr());
+		return m_condition.m_formatScripts.size() - 1;
+	}
+
+	SyntaxError Error(std::size_t pos, const std::wstring& message) const
+	{
+		return SyntaxError(pos, message);
+	}
+
+	SyntaxError Unexpected() const
+	{
+		if (m_token.type == tokenEnd)
+			return Error(m_token.pos, L"Unexpected end of the condition");
+
+		return Error(m_token.pos, L"Unexpected token");
+	}
+
+private:
+	Condition& m_condition;
+	const std::wstring& m_text;
+	std::size_t m_pos;
+	Token m_token;
+
+	int m_depth;
+	int m_nesting;
+};
+
+//------------------------------------------------------------------------------
+// Condition
+//------------------------------------------------------------------------------
+
+Condition::Condition() : m_valid(true)
+{
+}
+
+bool Condition::Compile(const std::wstring& text, std::wstring& error)
+{
+	m_text = text;
+	m_valid = true;
+	m_code.clear();
+	m_numbers.clear();
+	m_strings.clear();
+	m_formatScripts.clear();
+	m_formats.clear();
+	m_formatResults.clear();
+
+	if (boost::trim_copy(text).empty())
+		return true;
+
+	try
+	{
+		Compiler(*this, text).Compile();
+	}
+	catch (const Compiler::SyntaxError& e)
+	{
+		error = e.Format();
+
+		m_valid = false;
+		m_code.clear();
+		return false;
+	}
+
+	m_formatResults.resize(m_formatScripts.size());
+	return true;
+}
+
+const std::wstring& Condition::GetText() const
+{
+	return m_text;
+}
+
+bool Condition::IsEmpty() const
+{
+	return m_valid && m_code.empty();
+}
+
+bool Condition::Evaluate() const
+{
+	if (m_code.empty())
+		return m_valid;
+
+	if (m_formats.size() != m_formatScripts.size())
+		CompileFormats();
+
+	Operand stack[maxStackDepth];
+	int top = -1;
+
+	// Fetched once per evaluation, when first needed.
+	SYSTEMTIME localTime;
+	bool localTimeFetched = false;
+	SharedVariables::SnapshotPtr pVariables;
+
+	for (std::size_t pc = 0; pc < m_code.size(); ++pc)
+	{
+		const Instruction& instruction = m_code[pc];
+		const OpCode op = static_cast<OpCode>(instruction.op);
+
+		if (op >= opPushTime && op <= opPushMonth && !localTimeFetched)
+		{
+			::GetLocalTime(&localTime);
+			localTimeFetched = true;
+		}
+
+		switch (op)
+		{
+		case opPushNumber:
+		case opPushTime:
+		case opPushWeekday:
+		case opPushDay:
+		case opPushMonth:
+		case opPushPlaying:
+		case opPushPaused:
+		case opPushStopped:
+		case opPushVolume:
+			{
+				Operand& operand = stack[++top];
+				operand.str = 0;
+
+				switch (op)
+				{
+				case opPushNumber:
+					operand.number = m_numbers[instruction.arg];
+					break;
+
+				case opPushTime:
+					operand.number = localTime.wHour * 60 + localTime.wMinute;
+					break;
+
+				case opPushWeekday:
+					// wDayOfWeek is 0 for Sunday.
+					operand.number = localTime.wDayOfWeek == 0 ? 7 : localTime.wDayOfWeek;
+					break;
+
+				case opPushDay:
+					operand.number = localTime.wDay;
+					break;
+
+				case opPushMonth:
+					operand.number = localTime.wMonth;
+					break;
+
+				case opPushPlaying:
+					operand.number = static_api_ptr_t<playback_control>()->is_playing() ? 1 : 0;
+					break;
+
+				case opPushPaused:
+					operand.number = static_api_ptr_t<playback_control>()->is_paused() ? 1 : 0;
+					break;
+
+				case opPushStopped:
+					operand.number = static_api_ptr_t<playback_control>()->is_playing() ? 0 : 1;
+					break;
+
+				case opPushVolume:
+					operand.number = static_api_ptr_t<playback_control>()->get_volume();
+					break;
+				}
+			}
+			break;
+
+		case opPushString:
+			stack[++top].str = &m_strings[instruction.arg];
+			break;
+
+		case opPushVariable:
+			{
+				static const std::wstring emptyString;
+
+				if (!pVariables)
+					pVariables = ServiceManager::Instance().GetSharedVariables().GetSnapshot();
+
+				const SessionValues::Value& value = pVariables->GetValue(m_strings[instruction.arg]);
+				Operand& operand = stack[++top];
+				operand.str = 0;
+
+				if (const t_size* pSize = boost::get<t_size>(&value))
+					operand.number = static_cast<double>(*pSize);
+				else if (const double* pDouble = boost::get<double>(&value))
+					operand.number = *pDouble;
+				else if (const std::wstring* pString = boost::get<std::wstring>(&value))
+					operand.str = pString;
+				else
+					operand.str = &emptyString;
+			}
+			break;
+
+		case opPushFormat:
+			stack[++top].str = FormatPlayingTrack(instruction.arg);
+			break;
+
+		case opEqual:
+		case opNotEqual:
+		case opLess:
+		case opLessEqual:
+		case opGreater:
+		case opGreaterEqual:
+			{
+				const bool result = CompareOperands(op, stack[top - 1], stack[top]);
+				--top;
+
+				stack[top].str = 0;
+				stack[top].number = result ? 1 : 0;
+			}
+			break;
+
+		case opNot:
+			{
+				const bool result = !IsTrue(stack[top]);
+
+				stack[top].str = 0;
+				stack[top].number = result ? 1 : 0;
+			}
+			break;
+
+		case opJumpIfFalseOrPop:
+		case opJumpIfTrueOrPop:
+			if (IsTrue(stack[top]) == (op == opJumpIfTrueOrPop))
+				pc = instruction.arg - 1;
+			else
+				--top;
+			break;
+
+		default:
+			_ASSERTE(false);
+			return false;
+		}
+
+		_ASSERTE(top >= -1 && top < maxStackDepth);
+	}
+
+	_ASSERTE(top == 0);
+	return IsTrue(stack[0]);
+}
+
+bool Condition::IsTrue(const Operand& operand)
+{
+	return operand.str ? !operand.str->empty() : operand.number != 0;
+}
+
+bool Condition::CompareOperands(OpCode op, const Operand& lhs, const Operand& rhs)
+{
+	int order = 0;
+
+	if (lhs.str && rhs.str)
+	{
+		order = _wcsicmp(lhs.str->c_str(), rhs.str->c_str());
+	}
+	else
+	{
+		double numbers[2] = { lhs.number, rhs.number };
+		const Operand* operands[2] = { &lhs, &rhs };
+
+		for (int i = 0; i < 2; ++i)
+		{
+			const std::wstring* str = operands[i]->str;
+			if (!str)
+				continue;
+
+			// Not a number: the operands are unordered.
+			wchar_t* end = 0;
+			numbers[i] = wcstod(str->c_str(), &end);
+			if (str->empty() || *end != L'\0')
+				return op == opNotEqual;
+		}
+
+		if (numbers[0] != numbers[0] || numbers[1] != numbers[1])
+			return op == opNotEqual;
+
+		order = numbers[0] < numbers[1] ? -1 : (numbers[0] > numbers[1] ? 1 : 0);
+	}
+
+	switch (op)
+	{
+	case opEqual:
+		return order == 0;
+
+	case opNotEqual:
+		return order != 0;
+
+	case opLess:
+		return order < 0;
+
+	case opLessEqual:
+		return order <= 0;
+
+	case opGreater:
+		return order > 0;
+
+	case opGreaterEqual:
+		return order >= 0;
+	}
+
+	_ASSERTE(false);
+	return false;
+}
+
+void Condition::CompileFormats() const
+{
+	m_formats.resize(m_formatScripts.size());
+
+	static_api_ptr_t<titleformat_compiler> compiler;
+
+	for (std::size_t i = 0; i < m_formatScripts.size(); ++i)
+		compiler->compile_safe(m_formats[i], m_formatScripts[i]);
+}
+
+const std::wstring* Condition::FormatPlayingTrack(unsigned short index) const
+{
+	std::wstring& result = m_formatResults[index];
+
+	// Nothing is formatted when the player is stopped.
+	if (!static_api_ptr_t<playback_control>()->playback_format_title(NULL, m_formatOutput, m_formats[index], NULL,
+		playback_control::display_level_all))
+	{
+		result.clear();
+		return &result;
+	}
+
+	result.resize(pfc::stringcvt::estimate_utf8_to_wide(m_formatOutput.get_ptr(), m_formatOutput.length()));
+	result.resize(pfc::stringcvt::convert_utf8_to_wide(&result[0], result.size(),
+		m_formatOutput.get_ptr(), m_formatOutput.length()));
+
+	return &result;
+}
\ No newline at end of file
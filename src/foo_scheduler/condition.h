@@ -0,0 +1,105 @@
+#pragma once
+
+// A condition such as
+//   weekday <= fri and time >= 22:30 and playing and %genre% = "Jazz"
+//
+// Values:
+//   time                  minutes since midnight, compared with HH:MM literals
+//   weekday               1 (mon) .. 7 (sun)
+//   day, month            day of the month, month
+//   playing, paused, stopped
+//   volume                player volume in dB
+//   var("name")           shared variable, an empty string if it isn't set
+//   %field%, format("...") title formatting of the playing track
+//   numbers, "strings", true, false
+// Operators: = != < <= > >= not and or, parentheses.
+//
+// Strings are compared case insensitively. A string compared with a number is converted
+// to a number; if it isn't one, only != is true.
+//
+// The text is compiled once into a small stack program, evaluation doesn't allocate
+// except for growing buffers of title formatting results.
+class Condition
+{
+public:
+	Condition();
+
+	// Returns false and sets error if the text is invalid. An empty text is a condition which is always true.
+	bool Compile(const std::wstring& text, std::wstring& error);
+
+	const std::wstring& GetText() const;
+	bool IsEmpty() const;
+
+	// Main thread only. An invalid condition is false.
+	bool Evaluate() const;
+
+private:
+	enum OpCode
+	{
+		opPushNumber = 0,
+		opPushString,
+		opPushTime,
+		opPushWeekday,
+		opPushDay,
+		opPushMonth,
+		opPushPlaying,
+		opPushPaused,
+		opPushStopped,
+		opPushVolume,
+		opPushVariable,
+		opPushFormat,
+
+		opEqual,
+		opNotEqual,
+		opLess,
+		opLessEqual,
+		opGreater,
+		opGreaterEqual,
+		opNot,
+
+		// Jump to arg if the top of the stack is false (true), keeping it. Otherwise pop it.
+		opJumpIfFalseOrPop,
+		opJumpIfTrueOrPop,
+	};
+
+	struct Instruction
+	{
+		unsigned short op;
+		unsigned short arg;
+	};
+
+	// A number if str is null.
+	struct Operand
+	{
+		double number;
+		const std::wstring* str;
+	};
+
+	enum { maxStackDepth = 16 };
+
+	class Compiler;
+	friend class Compiler;
+
+	static bool IsTrue(const Operand& operand);
+	static bool CompareOperands(OpCode op, const Operand& lhs, const Operand& rhs);
+
+	void CompileFormats() const;
+	const std::wstring* FormatPlayingTrack(unsigned short index) const;
+
+private:
+	std::wstring m_text;
+	bool m_valid;
+
+	std::vector<Instruction> m_code;
+	std::vector<double> m_numbers;
+	std::vector<std::wstring> m_strings; // String constants and variable names.
+	std::vector<pfc::string8> m_formatScripts;
+
+	// Title formatting scripts are compiled on the first evaluation, as the configuration
+	// can be loaded before the core services are available.
+	mutable std::vector<titleformat_object::ptr> m_formats;
+
+	// Reused between evaluations to keep their capacity.
+	mutable pfc::string8 m_formatOutput;
+	mutable std::vector<std::wstring> m_formatResults;
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "pch.h"
+#include "condition_editor.h"
+
+ConditionEditor::ConditionEditor(Condition& condition) : m_condition(condition)
+{
+}
+
+BOOL ConditionEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
+{
+	SetDlgItemText(IDC_EDIT_CONDITION, m_condition.GetText().c_str());
+	CenterWindow(GetParent());
+
+	// dark mode
+	m_dark.AddDialogWithControls(m_hWnd);
+
+	return TRUE;
+}
+
+void ConditionEditor::OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	if (nID == IDOK)
+	{
+		CString text;
+		GetDlgItemText(IDC_EDIT_CONDITION, text);
+
+		Condition condition;
+		std::wstring error;
+
+		if (!condition.Compile(text.GetString(), error))
+		{
+			m_popupTooltipMsg.Show(error.c_str(), GetDlgItem(IDC_EDIT_CONDITION));
+			return;
+		}
+
+		m_condition = condition;
+	}
+
+	EndDialog(nID);
+}
\ No newline at end of file
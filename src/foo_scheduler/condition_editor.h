@@ -0,0 +1,34 @@
+#pragma once
+
+#include "resource.h"
+#include "condition.h"
+#include "popup_tooltip_message.h"
+
+//------------------------------------------------------------------------------
+// ConditionEditor
+//------------------------------------------------------------------------------
+
+// Edits the condition of an event. Invalid conditions are not accepted.
+class ConditionEditor : public CDialogImpl<ConditionEditor>
+{
+public:
+	enum { IDD = IDD_CONDITION_CONFIG };
+
+	explicit ConditionEditor(Condition& condition);
+
+private:
+	BEGIN_MSG_MAP_EX(ConditionEditor)
+		MSG_WM_INITDIALOG(OnInitDialog)
+		COMMAND_ID_HANDLER_EX(IDOK,     OnCloseCmd)
+		COMMAND_ID_HANDLER_EX(IDCANCEL, OnCloseCmd)
+	END_MSG_MAP()
+
+	BOOL OnInitDialog(CWindow wndFocus, LPARAM lInitParam);
+	void OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl);
+
+private:
+	Condition& m_condition;
+
+	PopupTooltipMessage m_popupTooltipMsg;
+	fb2k::CDarkModeHooks m_dark;
+};
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "pref_page_model.h"
 #include "combo_helpers.h"
 #include "service_manager.h"
+#include "exception_calendars_editor.h"
 
 //------------------------------------------------------------------------------
 // DateTimeEvent
@@ -13,7 +14,8 @@
 DateTimeEvent::DateTimeEvent() :
 	m_type(typeOnce), m_weekDays(0),
 	m_date(boost::gregorian::day_clock::local_day()),
-	m_wakeup(false), m_finalAction(finalActionRemove)
+	m_wakeup(false), m_finalAction(finalActionRemove), m_catchUp(catchUpSkip),
+	m_calendarMode(calendarNone), m_calendarGUID(pfc::guid_null)
 {
 	//..
 }
@@ -21,7 +23,8 @@ DateTimeEvent::DateTimeEvent() :
 DateTimeEvent::DateTimeEvent(const DateTimeEvent& rhs) : Event(rhs),
 	m_type(rhs.m_type), m_weekDays(rhs.m_weekDays), m_date(rhs.m_date),
 	m_wakeup(rhs.m_wakeup), m_time(rhs.m_time), m_title(rhs.m_title),
-	m_finalAction(rhs.m_finalAction)
+	m_finalAction(rhs.m_finalAction), m_catchUp(rhs.m_catchUp),
+	m_calendarMode(rhs.m_calendarMode), m_calendarGUID(rhs.m_calendarGUID), m_pCalendar(rhs.m_pCalendar)
 {
 	//..
 }
@@ -53,7 +56,9 @@ std::wstring DateTimeEvent::GetDescription() const
 		break;
 	}
 
+	AddCalendar(eventDescr);
 	AddWakeUp(eventDescr);
+	AddCatchUp(eventDescr);
 
 	if (!title.empty())
 		result += title + L" [" + eventDescr + L"]";
@@ -253,6 +258,197 @@ void DateTimeEvent::AddWakeUp(std::wstring& strResult) const
 		strResult += L", wake up from hibernate/standby";
 }
 
+void DateTimeEvent::AddCatchUp(std::wstring& strResult) const
+{
+	if (m_catchUp == catchUpOnce)
+		strResult += L", fire once if missed";
+	else if (m_catchUp == catchUpAll)
+		strResult += L", fire all missed";
+}
+
+void DateTimeEvent::AddCalendar(std::wstring& strResult) const
+{
+	if (m_type == typeOnce || !m_pCalendar)
+		return;
+
+	if (m_calendarMode == calendarSkip)
+		strResult += L", except on " + m_pCalendar->GetName();
+	else if (m_calendarMode == calendarOnly)
+		strResult += L", only on " + m_pCalendar->GetName();
+}
+
+DateTimeEvent::ECatchUp DateTimeEvent::GetCatchUp() const
+{
+	return m_catchUp;
+}
+
+void DateTimeEvent::SetCatchUp(ECatchUp val)
+{
+	m_catchUp = val;
+}
+
+DateTimeEvent::ECalendarMode DateTimeEvent::GetCalendarMode() const
+{
+	return m_calendarMode;
+}
+
+const GUID& DateTimeEvent::GetCalendarGUID() const
+{
+	return m_calendarGUID;
+}
+
+ExceptionCalendarPtr DateTimeEvent::GetCalendar() const
+{
+	return m_pCalendar;
+}
+
+void DateTimeEvent::SetCalendar(ECalendarMode mode, const ExceptionCalendarPtr& pCalendar)
+{
+	if (mode == calendarNone || !pCalendar)
+	{
+		m_calendarMode = calendarNone;
+		m_calendarGUID = pfc::guid_null;
+		m_pCalendar.reset();
+		return;
+	}
+
+	m_calendarMode = mode;
+	m_calendarGUID = pCalendar->GetGUID();
+	m_pCalendar = pCalendar;
+}
+
+bool DateTimeEvent::OccursOn(const boost::gregorian::date& date) const
+{
+	if (m_type == typeWeekly)
+	{
+		// Format 0 = Mon, 1 = Tue, .. , 6 = Sun
+		const int dayOfWeek = (date.day_of_week().as_number() + 6) % 7;
+
+		if ((m_weekDays & (1 << dayOfWeek)) == 0)
+			return false;
+	}
+	else if (m_type != typeDaily)
+		return false;
+
+	if (m_pCalendar)
+		return m_pCalendar->Contains(date) == (m_calendarMode == calendarOnly);
+
+	return true;
+}
+
+void DateTimeEvent::GetOccurrences(const boost::posix_time::ptime& from, const boost::posix_time::ptime& to,
+	std::size_t maxCount, std::vector<boost::posix_time::ptime>& occurrences) const
+{
+	if (from >= to || maxCount == 0)
+		return;
+
+	if (m_type == typeOnce)
+	{
+		const boost::posix_time::ptime t(m_date, m_time);
+
+		if (t > from && t <= to)
+			occurrences.push_back(t);
+
+		return;
+	}
+
+	// Walks backwards from the end, so a long range keeps its most recent occurrences.
+	const std::size_t first = occurrences.size();
+
+	for (boost::gregorian::date d = to.date(); d >= from.date() && occurrences.size() - first < maxCount;
+		d -= boost::gregorian::days(1))
+	{
+		const boost::posix_time::ptime t(d, m_time);
+
+		if (t > from && t <= to && OccursOn(d))
+			occurrences.push_back(t);
+	}
+
+	std::reverse(occurrences.begin() + first, occurrences.end());
+}
+
+boost::posix_time::ptime DateTimeEvent::GetNextOccurrence(const boost::posix_time::ptime& after) const
+{
+	if (m_type == typeOnce)
+	{
+		const boost::posix_time::ptime t(m_date, m_time);
+		return t > after ? t : boost::posix_time::ptime(boost::posix_time::not_a_date_time);
+	}
+
+	if (m_type == typeWeekly && m_weekDays == 0)
+		return boost::posix_time::not_a_date_time;
+
+	// Searching forwards takes at most 8 days, unless calendar days put the next occurrence off.
+	// Past the calendar's last day the days of the week alone decide.
+	boost::gregorian::date lastDate = after.date() + boost::gregorian::days(7);
+
+	if (m_pCalendar)
+	{
+		const boost::gregorian::date calendarLastDate = m_pCalendar->GetLastDate();
+
+		if (m_calendarMode == calendarOnly)
+		{
+			if (calendarLastDate.is_special())
+				return boost::posix_time::not_a_date_time;
+
+			lastDate = calendarLastDate;
+		}
+		else if (!calendarLastDate.is_special())
+			lastDate = std::max(lastDate, calendarLastDate + boost::gregorian::days(7));
+	}
+
+	boost::gregorian::date d = after.date();
+
+	while (d <= lastDate)
+	{
+		// Days the calendar rules out are jumped over a run at a time, the others take at most a week.
+		if (m_pCalendar)
+		{
+			d = m_calendarMode == calendarOnly ? m_pCalendar->GetNextContainedDate(d) :
+				m_pCalendar->GetNextNotContainedDate(d);
+
+			if (d.is_special() || d > lastDate)
+				break;
+		}
+
+		const boost::posix_time::ptime t(d, m_time);
+
+		if (t > after && OccursOn(d))
+			return t;
+
+		d += boost::gregorian::days(1);
+	}
+
+	return boost::posix_time::not_a_date_time;
+}
+
+boost::posix_time::ptime DateTimeEvent::GetLastOccurrence(const boost::posix_time::ptime& from,
+	const boost::posix_time::ptime& to) const
+{
+	if (from >= to)
+		return boost::posix_time::not_a_date_time;
+
+	if (m_type == typeOnce)
+	{
+		const boost::posix_time::ptime t(m_date, m_time);
+		return t > from && t <= to ? t : boost::posix_time::ptime(boost::posix_time::not_a_date_time);
+	}
+
+	// Searching backwards takes at most 8 days.
+	for (boost::gregorian::date d = to.date(); d >= from.date(); d -= boost::gregorian::days(1))
+	{
+		const boost::posix_time::ptime t(d, m_time);
+
+		if (t <= from)
+			break;
+
+		if (t <= to && OccursOn(d))
+			return t;
+	}
+
+	return boost::posix_time::not_a_date_time;
+}
+
 void DateTimeEvent::LoadFromS11nBlock(const EventS11nBlock& block)
 {
 	if (!block.dateTimeEvent.Exists())
@@ -286,6 +482,31 @@ void DateTimeEvent::LoadFromS11nBlock(const EventS11nBlock& block)
 	}
 
 	b.wakeup.GetValueIfExists(m_wakeup);
+
+	if (b.catchUp.Exists())
+	{
+		const int catchUp = b.catchUp.GetValue();
+		m_catchUp = catchUp >= catchUpSkip && catchUp <= catchUpAll ? static_cast<ECatchUp>(catchUp) : catchUpSkip;
+	}
+
+	// Bound to the calendar by the model.
+	if (b.calendarMode.Exists() && b.calendarGUID.Exists())
+	{
+		const int calendarMode = b.calendarMode.GetValue();
+
+		if (calendarMode >= calendarNone && calendarMode <= calendarOnly)
+		{
+			m_calendarMode = static_cast<ECalendarMode>(calendarMode);
+			m_calendarGUID = b.calendarGUID.GetValue();
+		}
+		else
+		{
+			m_calendarMode = calendarNone;
+			m_calendarGUID = pfc::guid_null;
+		}
+
+		m_pCalendar.reset();
+	}
 }
 
 void DateTimeEvent::SaveToS11nBlock(EventS11nBlock& block) const
@@ -312,6 +533,15 @@ void DateTimeEvent::SaveToS11nBlock(EventS11nBlock& block) const
 
 	b.wakeup.SetValue(m_wakeup);
 
+	if (m_catchUp != catchUpSkip)
+		b.catchUp.SetValue(m_catchUp);
+
+	if (m_type != typeOnce && m_calendarMode != calendarNone)
+	{
+		b.calendarGUID.SetValue(m_calendarGUID);
+		b.calendarMode.SetValue(m_calendarMode);
+	}
+
 	block.dateTimeEvent.SetValue(b);
 }
 
@@ -378,6 +608,9 @@ BOOL DateTimeEventEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
 
 	m_typeCombo = GetDlgItem(IDC_COMBO_DAY);
 	m_finalActionCombo = GetDlgItem(IDC_COMBO_FINAL_ACTION);
+	m_catchUpCombo = GetDlgItem(IDC_COMBO_CATCH_UP);
+	m_calendarModeCombo = GetDlgItem(IDC_COMBO_CALENDAR_MODE);
+	m_calendarCombo = GetDlgItem(IDC_COMBO_CALENDAR);
 
 	ComboHelpers::InitCombo(m_typeCombo,
 		boost::assign::list_of<std::pair<std::wstring, int> >
@@ -396,6 +629,24 @@ BOOL DateTimeEventEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
 			DateTimeEvent::finalActionRemove
 	);
 
+	ComboHelpers::InitCombo(m_catchUpCombo,
+		boost::assign::list_of<std::pair<std::wstring, int> >
+		(L"Skip", DateTimeEvent::catchUpSkip)
+		(L"Fire once", DateTimeEvent::catchUpOnce)
+		(L"Fire all missed", DateTimeEvent::catchUpAll),
+		m_pEvent->GetCatchUp()
+	);
+
+	ComboHelpers::InitCombo(m_calendarModeCombo,
+		boost::assign::list_of<std::pair<std::wstring, int> >
+		(L"None", DateTimeEvent::calendarNone)
+		(L"Skip on", DateTimeEvent::calendarSkip)
+		(L"Only on", DateTimeEvent::calendarOnly),
+		m_pEvent->GetCalendarMode()
+	);
+
+	InitCalendars(m_pEvent->GetCalendarGUID());
+
 	switch (m_pEvent->GetType())
 	{
 	case DateTimeEvent::typeOnce:
@@ -425,6 +676,26 @@ void DateTimeEventEditor::InitWeekDays()
 		m_weekDays.SetCheckState(day, m_pEvent->GetWeekDays() & (0x01 << day));
 }
 
+void DateTimeEventEditor::InitCalendars(const GUID& selectedGUID)
+{
+	m_calendarCombo.ResetContent();
+
+	const ModelState::CalendarsContainer& calendars = m_pPrefPageModel->GetCalendars();
+
+	std::vector<std::pair<std::wstring, int>> comboItems;
+	int selected = calendars.empty() ? -1 : 0;
+
+	for (std::size_t i = 0; i < calendars.size(); ++i)
+	{
+		if (calendars[i]->GetGUID() == selectedGUID)
+			selected = static_cast<int>(i);
+
+		comboItems.push_back(std::make_pair(calendars[i]->GetName(), static_cast<int>(i)));
+	}
+
+	ComboHelpers::InitCombo(m_calendarCombo, comboItems, selected);
+}
+
 void DateTimeEventEditor::InitDate()
 {
 	SYSTEMTIME st;
@@ -493,6 +764,16 @@ void DateTimeEventEditor::OnClose(UINT uNotifyCode, int nID, CWindow wndCtl)
 			return;
 		}
 
+		const DateTimeEvent::ECalendarMode calendarMode =
+			ComboHelpers::GetSelectedItem<DateTimeEvent::ECalendarMode>(m_calendarModeCombo);
+
+		if (type != DateTimeEvent::typeOnce && calendarMode != DateTimeEvent::calendarNone &&
+			m_calendarCombo.GetCurSel() == CB_ERR)
+		{
+			m_popupTooltipMsg.Show(L"Select a calendar or add one.", m_calendarCombo);
+			return;
+		}
+
 		CString s;
 		GetDlgItemText(IDC_EDIT_TITLE, s);
 
@@ -500,6 +781,7 @@ void DateTimeEventEditor::OnClose(UINT uNotifyCode, int nID, CWindow wndCtl)
 		m_pEvent->SetWakeup(IsDlgButtonChecked(IDC_CHECK_WAKEUP) == TRUE);
 		m_pEvent->SetTime(GetTime());
 		m_pEvent->SetType(type);
+		m_pEvent->SetCatchUp(ComboHelpers::GetSelectedItem<DateTimeEvent::ECatchUp>(m_catchUpCombo));
 
 		switch (type)
 		{
@@ -513,6 +795,14 @@ void DateTimeEventEditor::OnClose(UINT uNotifyCode, int nID, CWindow wndCtl)
 			m_pEvent->SetWeekDays(GetWeekDays());
 			break;
 		}
+
+		if (type != DateTimeEvent::typeOnce && calendarMode != DateTimeEvent::calendarNone)
+		{
+			m_pEvent->SetCalendar(calendarMode,
+				m_pPrefPageModel->GetCalendars()[ComboHelpers::GetSelectedItem<int>(m_calendarCombo)]);
+		}
+		else
+			m_pEvent->SetCalendar(DateTimeEvent::calendarNone, ExceptionCalendarPtr());
 	}
 
 	EndDialog(nID);
@@ -525,6 +815,12 @@ void DateTimeEventEditor::UpdateDayControls()
 	m_date.ShowWindow(currentType == DateTimeEvent::typeOnce);
 	m_weekDays.ShowWindow(currentType == DateTimeEvent::typeWeekly);
 	m_finalActionCombo.ShowWindow(currentType == DateTimeEvent::typeOnce);
+
+	// Once events occur on their date regardless of calendars.
+	const bool repeated = currentType != DateTimeEvent::typeOnce;
+	m_calendarModeCombo.EnableWindow(repeated);
+	m_calendarCombo.EnableWindow(repeated &&
+		ComboHelpers::GetSelectedItem<DateTimeEvent::ECalendarMode>(m_calendarModeCombo) != DateTimeEvent::calendarNone);
 }
 
 void DateTimeEventEditor::OnDayTypeSelChange(UINT uNotifyCode, int nID, CWindow wndCtl)
@@ -533,6 +829,28 @@ void DateTimeEventEditor::OnDayTypeSelChange(UINT uNotifyCode, int nID, CWindow
 	UpdateDayControls();
 }
 
+void DateTimeEventEditor::OnCalendarModeSelChange(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	m_popupTooltipMsg.CleanUp();
+	UpdateDayControls();
+}
+
+void DateTimeEventEditor::OnEditCalendars(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	m_popupTooltipMsg.CleanUp();
+
+	const ModelState::CalendarsContainer& calendars = m_pPrefPageModel->GetCalendars();
+	const int selected = m_calendarCombo.GetCurSel();
+
+	const GUID selectedGUID = selected != CB_ERR ?
+		calendars[ComboHelpers::GetSelectedItem<int>(m_calendarCombo)]->GetGUID() : pfc::guid_null;
+
+	ExceptionCalendarsEditor dlg(m_pPrefPageModel);
+
+	if (dlg.DoModal(*this) == IDOK)
+		InitCalendars(selectedGUID);
+}
+
 LRESULT DateTimeEventEditor::OnNotify(UINT ctrl, LPNMHDR lpNmhdr) {
 
 	if (!m_dark.IsDark() || lpNmhdr->idFrom != IDC_DATE_PICKER) {
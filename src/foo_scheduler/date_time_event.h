@@ -4,6 +4,7 @@
 #include "event.h"
 #include "popup_tooltip_message.h"
 #include "date_time_event_s11n_block.h"
+#include "exception_calendar.h"
 
 class DateTimeEvent : public Event
 {
@@ -21,6 +22,22 @@ public:
 		finalActionDisable
 	};
 
+	// What to do with occurrences missed while the player was closed or the computer slept.
+	enum ECatchUp
+	{
+		catchUpSkip,  // Only the nearest pending occurrence fires when the computer wakes up.
+		catchUpOnce,  // The latest missed occurrence fires.
+		catchUpAll    // Every missed occurrence fires, in order.
+	};
+
+	// How daily and weekly events use their exception calendar.
+	enum ECalendarMode
+	{
+		calendarNone,
+		calendarSkip, // Doesn't occur on the calendar's days.
+		calendarOnly  // Occurs on the calendar's days only.
+	};
+
 	enum EDay
 	{
 		dayMon = 0x01, dayTue = 0x02, dayWed = 0x04, dayThu = 0x08,
@@ -48,6 +65,28 @@ public:
 	bool GetWakeup() const;
 	void SetWakeup(bool val);
 
+	ECatchUp GetCatchUp() const;
+	void SetCatchUp(ECatchUp val);
+
+	ECalendarMode GetCalendarMode() const;
+	const GUID& GetCalendarGUID() const;
+	ExceptionCalendarPtr GetCalendar() const;
+
+	// The calendar is stored by GUID and is bound again by the model when loaded, see ModelState::BindCalendar.
+	// A null calendar resets the mode to calendarNone.
+	void SetCalendar(ECalendarMode mode, const ExceptionCalendarPtr& pCalendar);
+
+	// Appends occurrences within (from, to] in ascending order, the latest maxCount of them.
+	void GetOccurrences(const boost::posix_time::ptime& from, const boost::posix_time::ptime& to,
+		std::size_t maxCount, std::vector<boost::posix_time::ptime>& occurrences) const;
+
+	// The first occurrence after the time or not_a_date_time.
+	boost::posix_time::ptime GetNextOccurrence(const boost::posix_time::ptime& after) const;
+
+	// The latest occurrence within (from, to] or not_a_date_time.
+	boost::posix_time::ptime GetLastOccurrence(const boost::posix_time::ptime& from,
+		const boost::posix_time::ptime& to) const;
+
 	std::unique_ptr<DateTimeEvent> Duplicate(const std::wstring &newTitle) const;
 
 public: // Event
@@ -73,6 +112,11 @@ private:
 	std::wstring GetWeeklyDescription() const;
 	std::wstring GetOnceDescription() const;
 	void AddWakeUp(std::wstring& strResult) const;
+	void AddCatchUp(std::wstring& strResult) const;
+	void AddCalendar(std::wstring& strResult) const;
+
+	// For daily and weekly events.
+	bool OccursOn(const boost::gregorian::date& date) const;
 
 private:
 	std::wstring m_title;
@@ -82,6 +126,10 @@ private:
 	char m_weekDays;
 	boost::posix_time::time_duration m_time;
 	bool m_wakeup;
+	ECatchUp m_catchUp;
+	ECalendarMode m_calendarMode;
+	GUID m_calendarGUID;
+	ExceptionCalendarPtr m_pCalendar; // Null until bound.
 };
 
 class DateTimeEventEditor : public CDialogImpl<DateTimeEventEditor>
@@ -106,6 +154,8 @@ private:
 	BEGIN_MSG_MAP(DateTimeEventEditor)
 		MSG_WM_INITDIALOG(OnInitDialog)
 		COMMAND_HANDLER_EX(IDC_COMBO_DAY, CBN_SELCHANGE, OnDayTypeSelChange)
+		COMMAND_HANDLER_EX(IDC_COMBO_CALENDAR_MODE, CBN_SELCHANGE, OnCalendarModeSelChange)
+		COMMAND_ID_HANDLER_EX(IDC_BTN_EDIT_CALENDARS, OnEditCalendars)
 		MSG_WM_NOTIFY(OnNotify)
 		MESSAGE_HANDLER(WM_CONTEXTMENU, OnContextMenu)
 		COMMAND_ID_HANDLER_EX(IDOK, OnClose)
@@ -116,6 +166,8 @@ private:
 	void OnClose(UINT uNotifyCode, int nID, CWindow wndCtl);
 
 	void OnDayTypeSelChange(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnCalendarModeSelChange(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnEditCalendars(UINT uNotifyCode, int nID, CWindow wndCtl);
 	LRESULT OnNotify(UINT /*ctrl*/, LPNMHDR /*lParam*/);
 	LRESULT OnContextMenu(UINT /*uMsg*/, WPARAM /*wParam*/, LPARAM /*lParam*/, BOOL& /*bHandled*/);
 	bool context_menu_show(HWND wnd, LPARAM lParamPos);
@@ -125,6 +177,7 @@ private:
 	void InitTime();
 	void InitDate();
 	void InitWeekDays();
+	void InitCalendars(const GUID& selectedGUID);
 
 	void CreateWeekDaysControl();
 	void UpdateDayControls();
@@ -141,6 +194,9 @@ private:
 
 	CComboBox m_typeCombo;
 	CComboBox m_finalActionCombo;
+	CComboBox m_catchUpCombo;
+	CComboBox m_calendarModeCombo;
+	CComboBox m_calendarCombo;
 	CCheckListViewCtrl m_weekDays;
 	CDateTimePickerCtrl m_date;
 	CDateTimePickerCtrl m_time;
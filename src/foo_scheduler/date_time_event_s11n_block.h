@@ -11,10 +11,14 @@ struct DateTimeEventS11nBlock : public S11nBlocks::Block<DateTimeEventS11nBlock>
 	S11nBlocks::Field<pfc::string8, 5> time;
 	S11nBlocks::Field<bool, 6> wakeup;
 	S11nBlocks::Field<int, 7> finalAction;
+	S11nBlocks::Field<int, 8> catchUp;
+	S11nBlocks::Field<GUID, 9> calendarGUID;
+	S11nBlocks::Field<int, 10> calendarMode;
 
 	template<class Archive>
 	void RegisterFields(Archive& ar)
 	{
-		ar.RegisterFields(title)(type)(date)(weekDays)(time)(wakeup)(finalAction);
+		ar.RegisterFields(title)(type)(date)(weekDays)(time)(wakeup)(finalAction)(catchUp)(calendarGUID)
+			(calendarMode);
 	}
 };
\ No newline at end of file
@@ -1,8 +1,21 @@
 #include "pch.h"
 #include "date_time_events_manager.h"
 #include "service_manager.h"
+#include "metrics.h"
+#include "tracer.h"
 
-DateTimeEventsManager::DateTimeEventsManager(Model& model)
+namespace
+{
+	// A timer that fires this late was delayed by sleep or hibernation.
+	const boost::posix_time::time_duration lateFireThreshold = boost::posix_time::minutes(1);
+
+	// Catch-up starts no more task runs while this many are running.
+	const std::size_t maxCatchUpSessions = 4;
+
+	const std::size_t maxCatchUpOccurrencesPerEvent = 100;
+}
+
+DateTimeEventsManager::DateTimeEventsManager(Model& model) : m_catchUpBatchScheduled(false)
 {
 	model.ConnectModelStateChangedSlot(
 		boost::bind(&DateTimeEventsManager::Reset, this));
@@ -11,12 +24,32 @@ DateTimeEventsManager::DateTimeEventsManager(Model& model)
 void DateTimeEventsManager::Reset()
 {
 	StopTimer();
+
+	if (!m_lastRunTimeUTC.is_not_a_date_time())
+	{
+		const boost::posix_time::ptime lastRunTimeUTC = m_lastRunTimeUTC;
+		m_lastRunTimeUTC = boost::posix_time::not_a_date_time;
+
+		// Occurrences are local times, the last run time is converted with the offset in effect back then.
+		if (ServiceManager::Instance().GetModel().IsSchedulerEnabled())
+		{
+			CatchUp(ServiceManager::Instance().GetTimersManager().UTCToLocal(lastRunTimeUTC),
+				boost::posix_time::second_clock::local_time());
+		}
+	}
+
 	UpdatePendingEvents();
 }
 
 void DateTimeEventsManager::Shutdown()
 {
 	StopTimer();
+	StopCatchUp();
+}
+
+void DateTimeEventsManager::SetLastRunTime(const boost::posix_time::ptime& lastRunTimeUTC)
+{
+	m_lastRunTimeUTC = lastRunTimeUTC;
 }
 
 void DateTimeEventsManager::OnTimerEvent(TimersManager::TimerID timerID)
@@ -24,11 +57,33 @@ void DateTimeEventsManager::OnTimerEvent(TimersManager::TimerID timerID)
 	_ASSERTE(m_currentPendingEvent != boost::none);
 	_ASSERTE(m_currentPendingEvent->second == timerID);
 
+	Tracer::ScopedSpan span("timer", "Date/time event");
+
+	const boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
+
+	// In UTC, local times an hour apart across a daylight saving time change may be the same instant.
+	const boost::posix_time::time_duration lateness =
+		boost::posix_time::microsec_clock::universal_time() - m_currentPendingEventUTC;
+
+	Metrics::Record(Metrics::histFireLateness, lateness.total_microseconds());
+
 	ServiceManager::Instance().GetTimersManager().CloseTimer(m_currentPendingEvent->second);
-	ServiceManager::Instance().GetRootController().ProcessEvent(m_currentPendingEvent->first);
+
+	DateTimeEvent* pEvent = m_currentPendingEvent->first;
+	const boost::posix_time::ptime scheduledTime = m_currentPendingEventTime;
 
 	m_currentPendingEvent = boost::none;
 
+	// Events that were due while the computer slept. The pending event was the nearest one,
+	// so nothing before its scheduled time was missed.
+	const bool late = lateness > lateFireThreshold;
+
+	if (late)
+		CatchUp(scheduledTime - boost::posix_time::microseconds(1), now);
+
+	if (!late || pEvent->GetCatchUp() == DateTimeEvent::catchUpSkip)
+		ServiceManager::Instance().GetRootController().ProcessEvent(pEvent);
+
 	UpdatePendingEvents();
 }
 
@@ -64,7 +119,8 @@ void DateTimeEventsManager::StopTimer()
 	}
 }
 
-boost::posix_time::ptime DateTimeEventsManager::GetEventStartTime(const DateTimeEvent* pEvent) const
+boost::posix_time::ptime DateTimeEventsManager::GetEventStartTime(const DateTimeEvent* pEvent,
+	const boost::posix_time::ptime& now) const
 {
 	boost::posix_time::ptime resultTime;
 
@@ -73,7 +129,7 @@ boost::posix_time::ptime DateTimeEventsManager::GetEventStartTime(const DateTime
 	case DateTimeEvent::typeOnce:
 		{
 			boost::posix_time::ptime scheduledTime(pEvent->GetDate(), pEvent->GetTime());
-			const boost::posix_time::time_duration d = boost::posix_time::second_clock::local_time() - scheduledTime;
+			const boost::posix_time::time_duration d = now - scheduledTime;
 
 			// This may happen after player startup if there is an event with date/time in the past.
 			if (d.total_seconds() > 1)
@@ -86,49 +142,9 @@ boost::posix_time::ptime DateTimeEventsManager::GetEventStartTime(const DateTime
 		break;
 
 	case DateTimeEvent::typeDaily:
-		{
-			boost::posix_time::ptime startTime(boost::gregorian::day_clock::local_day(), pEvent->GetTime());
-			
-			if (boost::posix_time::second_clock::local_time() >= startTime)
-				startTime += boost::gregorian::days(1);
-
-			resultTime = startTime;
-		}
-		break;
-
 	case DateTimeEvent::typeWeekly:
-		{
-			boost::gregorian::date dateNow(boost::gregorian::day_clock::local_day());
-
-			int currentDayOfWeek = dateNow.day_of_week().as_number();
-
-			if (currentDayOfWeek == 0)
-				currentDayOfWeek = 7;
-
-			--currentDayOfWeek; // Format 0 = Mon, 1 = Tue, .. , 6 = Sun
-			
-			boost::gregorian::date weekStartDate =
-				dateNow - boost::gregorian::date_duration(currentDayOfWeek);
-
-			std::vector<boost::posix_time::ptime> times;
-
-			for (int i = 0; i < 7; ++i)
-				if (pEvent->GetWeekDays() & (1 << i))
-				{
-					boost::posix_time::ptime startTime(
-						weekStartDate + boost::gregorian::date_duration(i), pEvent->GetTime());
-
-					if (boost::posix_time::second_clock::local_time() >= startTime)
-						startTime += boost::gregorian::days(7);
-
-					times.push_back(startTime);
-				}
-
-			std::sort(times.begin(), times.end());
-
-			_ASSERTE(!times.empty());
-			resultTime = times[0];
-		}
+		// Not a date time if the event's calendar leaves no day to occur on.
+		resultTime = pEvent->GetNextOccurrence(now);
 		break;
 	}
 
@@ -139,14 +155,17 @@ std::vector<DateTimeEventsManager::EventStartTimePair> DateTimeEventsManager::Ge
 {
 	std::vector<EventStartTimePair> result;
 
+	// The same for all events, so they are compared against one point in time.
+	const boost::posix_time::ptime now = boost::posix_time::second_clock::local_time();
+
 	const std::vector<DateTimeEvent*> dateTimeEvents = GetDateTimeEvents();
 	for (auto it = dateTimeEvents.begin(); it != dateTimeEvents.end(); ++it)
 	{
 		DateTimeEvent* event = *it;
 
-		const boost::posix_time::ptime eventStartTime = GetEventStartTime(event);
+		const boost::posix_time::ptime eventStartTime = GetEventStartTime(event, now);
 
-		// Skip once events in the past.
+		// Skip once events in the past and events their calendar leaves no day to occur on.
 		if (eventStartTime.is_not_a_date_time())
 		{
 			continue;
@@ -163,6 +182,8 @@ std::vector<DateTimeEventsManager::EventStartTimePair> DateTimeEventsManager::Ge
 
 void DateTimeEventsManager::UpdatePendingEvents()
 {
+	Metrics::ScopedTimer timer(Metrics::histScheduleUpdate);
+
 	const std::vector<EventStartTimePair> eventsNearestStartTime = GetEventsNearestStartTime();
 
 	if (ServiceManager::Instance().GetModel().IsSchedulerEnabled() && !eventsNearestStartTime.empty())
@@ -175,6 +196,8 @@ void DateTimeEventsManager::UpdatePendingEvents()
 			nearestEventTimePair.second, boost::posix_time::not_a_date_time, nearestEventTimePair.first->GetWakeup());
 
 		m_currentPendingEvent = std::make_pair(nearestEventTimePair.first, timerID);
+		m_currentPendingEventTime = nearestEventTimePair.second;
+		m_currentPendingEventUTC = ServiceManager::Instance().GetTimersManager().LocalToUTC(nearestEventTimePair.second);
 
 		// Proxy forwards OnTimerEvent invocation to DateTimeEventsManager::OnTimerEvent.
 		AsyncCall::CallbackPtr pTimerCallback =
@@ -203,4 +226,138 @@ boost::signals2::connection DateTimeEventsManager::ConnectPendingEventsUpdatedSl
 std::vector<DateTimeEvent*> DateTimeEventsManager::GetPendingEvents() const
 {
 	return m_pendingEvents;
+}
+
+std::vector<DateTimeForecast::Firing> DateTimeEventsManager::GetForecast(
+	const boost::posix_time::time_duration& horizon, std::size_t maxCount) const
+{
+	const boost::posix_time::ptime now = boost::posix_time::second_clock::local_time();
+
+	DateTimeForecast forecast(GetDateTimeEvents(), now, now + horizon);
+	return forecast.Take(maxCount);
+}
+
+void DateTimeEventsManager::CatchUp(const boost::posix_time::ptime& from, const boost::posix_time::ptime& to)
+{
+	std::vector<MissedOccurrence> missed;
+	std::vector<boost::posix_time::ptime> occurrences;
+
+	const std::vector<DateTimeEvent*> dateTimeEvents = GetDateTimeEvents();
+	for (auto it = dateTimeEvents.begin(); it != dateTimeEvents.end(); ++it)
+	{
+		const DateTimeEvent* pEvent = *it;
+
+		// With skip the pending event still fires, as it always did.
+		if (pEvent->GetCatchUp() == DateTimeEvent::catchUpSkip)
+			continue;
+
+		occurrences.clear();
+
+		if (pEvent->GetCatchUp() == DateTimeEvent::catchUpOnce)
+		{
+			const boost::posix_time::ptime last = pEvent->GetLastOccurrence(from, to);
+
+			if (!last.is_not_a_date_time())
+				occurrences.push_back(last);
+		}
+		else
+			pEvent->GetOccurrences(from, to, maxCatchUpOccurrencesPerEvent, occurrences);
+
+		for (std::size_t i = 0; i < occurrences.size(); ++i)
+		{
+			MissedOccurrence mo = { occurrences[i], pEvent->GetEventGUID() };
+			missed.push_back(mo);
+		}
+	}
+
+	if (missed.empty())
+		return;
+
+	Tracer::RecordInstant("timer", "Catch-up");
+
+	// Stable, so occurrences at the same time fire in the order of the event list.
+	std::stable_sort(missed.begin(), missed.end(),
+		boost::bind(&MissedOccurrence::time, _1) < boost::bind(&MissedOccurrence::time, _2));
+
+	m_catchUpQueue.insert(m_catchUpQueue.end(), missed.begin(), missed.end());
+
+	ScheduleCatchUpBatch();
+}
+
+void DateTimeEventsManager::ScheduleCatchUpBatch()
+{
+	if (m_catchUpBatchScheduled || m_catchUpQueue.empty())
+		return;
+
+	// Doesn't own the manager, only lets StopCatchUp cancel the callbacks in the message loop.
+	if (!m_catchUpController)
+		m_catchUpController.reset(this, [] (DateTimeEventsManager*) {});
+
+	if (!m_execSessionRemovedConnection.connected())
+	{
+		m_execSessionRemovedConnection =
+			ServiceManager::Instance().GetRootController().ConnectActionListExecSessionRemovedSlot(
+				boost::bind(&DateTimeEventsManager::OnExecSessionRemoved, this, _1));
+	}
+
+	m_catchUpBatchScheduled = true;
+	AsyncCall::AsyncRunInMainThread(AsyncCall::MakeCallback<DateTimeEventsManager>(m_catchUpController,
+		boost::bind(&DateTimeEventsManager::RunCatchUpBatch, _1)));
+}
+
+
+void DateTimeEventsManager::RunCatchUpBatch()
+{
+	m_catchUpBatchScheduled = false;
+
+	if (!ServiceManager::Instance().GetModel().IsSchedulerEnabled())
+	{
+		m_catchUpQueue.clear();
+		return;
+	}
+
+	if (m_catchUpQueue.empty() || m_catchUpSessions.size() >= maxCatchUpSessions)
+		return;
+
+	RootController& rootController = ServiceManager::Instance().GetRootController();
+	Model& model = ServiceManager::Instance().GetModel();
+
+	// Sessions started while processing the missed occurrences are the catch-up runs.
+	boost::signals2::scoped_connection sessionAddedConnection = rootController.ConnectActionListExecSessionAddedSlot(
+		boost::bind(&DateTimeEventsManager::OnCatchUpSessionAdded, this, _1));
+
+	// Continued when one of the runs completes.
+	while (!m_catchUpQueue.empty() && m_catchUpSessions.size() < maxCatchUpSessions)
+	{
+		const MissedOccurrence missed = m_catchUpQueue.front();
+		m_catchUpQueue.pop_front();
+
+		DateTimeEvent* pEvent = dynamic_cast<DateTimeEvent*>(model.GetEventByGUID(missed.eventGUID));
+
+		// Removed or disabled meanwhile, once events remove or disable themselves when processed.
+		if (!pEvent || !pEvent->IsEnabled())
+			continue;
+
+		rootController.ProcessEvent(pEvent);
+	}
+}
+
+void DateTimeEventsManager::StopCatchUp()
+{
+	m_catchUpController.reset();
+	m_catchUpQueue.clear();
+	m_catchUpBatchScheduled = false;
+	m_execSessionRemovedConnection.disconnect();
+	m_catchUpSessions.clear();
+}
+
+void DateTimeEventsManager::OnCatchUpSessionAdded(ActionListExecSession* pSession)
+{
+	m_catchUpSessions.insert(pSession);
+}
+
+void DateTimeEventsManager::OnExecSessionRemoved(ActionListExecSession* pSession)
+{
+	if (m_catchUpSessions.erase(pSession) != 0)
+		ScheduleCatchUpBatch();
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "date_time_event.h"
+#include "date_time_forecast.h"
 #include "timers_manager.h"
 #include "async_call.h"
 
+class ActionListExecSession;
+
 class MethodCallProxy
 {
 public:
@@ -34,6 +37,15 @@ public:
 
 	std::vector<DateTimeEvent*> GetPendingEvents() const;
 
+	// Up to maxCount next firings of the enabled events within the horizon from now, in time order.
+	// An event occurring repeatedly appears once per firing.
+	std::vector<DateTimeForecast::Firing> GetForecast(const boost::posix_time::time_duration& horizon,
+		std::size_t maxCount) const;
+
+	// UTC time up to which events were processed in the previous run, stored in the configuration.
+	// Missed occurrences since then are caught up on the next reset.
+	void SetLastRunTime(const boost::posix_time::ptime& lastRunTimeUTC);
+
 private:
 	void StopTimer();
 	void UpdatePendingEvents();
@@ -41,17 +53,47 @@ private:
 	std::vector<DateTimeEvent*> GetDateTimeEvents() const;
 	void OnTimerEvent(TimersManager::TimerID timerID);
 
-	boost::posix_time::ptime GetEventStartTime(const DateTimeEvent* pEvent) const;
+	boost::posix_time::ptime GetEventStartTime(const DateTimeEvent* pEvent, const boost::posix_time::ptime& now) const;
 
 	typedef std::pair<DateTimeEvent*, boost::posix_time::ptime> EventStartTimePair;
 	std::vector<EventStartTimePair> GetEventsNearestStartTime() const;
 
+	// Queues missed occurrences within (from, to] according to the events' catch-up policy.
+	void CatchUp(const boost::posix_time::ptime& from, const boost::posix_time::ptime& to);
+
+	void ScheduleCatchUpBatch();
+	void RunCatchUpBatch();
+	void StopCatchUp();
+
+	void OnCatchUpSessionAdded(ActionListExecSession* pSession);
+	void OnExecSessionRemoved(ActionListExecSession* pSession);
+
 private:
 	boost::shared_ptr<MethodCallProxy> m_onTimerEventProxy;
 	boost::optional<std::pair<DateTimeEvent*, TimersManager::TimerID>> m_currentPendingEvent;
+	boost::posix_time::ptime m_currentPendingEventTime;
+	boost::posix_time::ptime m_currentPendingEventUTC; // When the timer fires.
 
 	// Pending events. The first event is the nearest.
 	std::vector<DateTimeEvent*> m_pendingEvents;
 
 	PendingEventsUpdated m_pendingEventsUpdatedSignal;
+
+	boost::posix_time::ptime m_lastRunTimeUTC;
+
+	struct MissedOccurrence
+	{
+		boost::posix_time::ptime time;
+		GUID eventGUID;
+	};
+
+	// Missed occurrences in order, fired a few at a time.
+	std::deque<MissedOccurrence> m_catchUpQueue;
+	boost::shared_ptr<DateTimeEventsManager> m_catchUpController;
+	bool m_catchUpBatchScheduled;
+	boost::signals2::scoped_connection m_execSessionRemovedConnection;
+
+	// Running sessions started by catch-up. Only they count against maxCatchUpSessions,
+	// so that long running tasks started otherwise can't hold catch-up back.
+	std::unordered_set<ActionListExecSession*> m_catchUpSessions;
 };
\ No newline at end of file
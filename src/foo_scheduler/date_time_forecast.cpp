@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "date_time_forecast.h"
+#include "date_time_event.h"
+
+DateTimeForecast::DateTimeForecast(const std::vector<DateTimeEvent*>& events,
+	const boost::posix_time::ptime& from, const boost::posix_time::ptime& horizon) :
+	m_events(events), m_horizon(horizon)
+{
+	m_heap.reserve(m_events.size());
+
+	for (std::size_t i = 0; i < m_events.size(); ++i)
+	{
+		const boost::posix_time::ptime t = m_events[i]->GetNextOccurrence(from);
+
+		if (!t.is_not_a_date_time() && t <= m_horizon)
+		{
+			HeapEntry entry = { t, i };
+			m_heap.push_back(entry);
+		}
+	}
+
+	// Building the heap at once is linear.
+	std::make_heap(m_heap.begin(), m_heap.end());
+}
+
+bool DateTimeForecast::Next(Firing& firing)
+{
+	if (m_heap.empty())
+		return false;
+
+	std::pop_heap(m_heap.begin(), m_heap.end());
+	const HeapEntry entry = m_heap.back();
+	m_heap.pop_back();
+
+	firing.time = entry.time;
+	firing.pEvent = m_events[entry.eventIndex];
+
+	Push(entry.eventIndex, entry.time);
+
+	return true;
+}
+
+std::vector<DateTimeForecast::Firing> DateTimeForecast::Take(std::size_t maxCount)
+{
+	std::vector<Firing> result;
+	Firing firing;
+
+	while (result.size() < maxCount && Next(firing))
+		result.push_back(firing);
+
+	return result;
+}
+
+void DateTimeForecast::Push(std::size_t eventIndex, const boost::posix_time::ptime& after)
+{
+	const boost::posix_time::ptime t = m_events[eventIndex]->GetNextOccurrence(after);
+
+	if (t.is_not_a_date_time() || t > m_horizon)
+		return;
+
+	HeapEntry entry = { t, eventIndex };
+	m_heap.push_back(entry);
+	std::push_heap(m_heap.begin(), m_heap.end());
+}
\ No newline at end of file
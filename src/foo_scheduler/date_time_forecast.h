@@ -0,0 +1,50 @@
+#pragma once
+
+class DateTimeEvent;
+
+//------------------------------------------------------------------------------
+// DateTimeForecast
+//------------------------------------------------------------------------------
+
+// Produces the firings of date/time events within (from, horizon] in time order, one at a time.
+// The events' occurrences are merged with a heap, so the next firing takes O(log n) for n events
+// and nothing beyond the firings asked for is computed.
+// Events must not be changed or removed while the forecast is in use.
+class DateTimeForecast : private boost::noncopyable
+{
+public:
+	struct Firing
+	{
+		boost::posix_time::ptime time;
+		DateTimeEvent* pEvent;
+	};
+
+	DateTimeForecast(const std::vector<DateTimeEvent*>& events,
+		const boost::posix_time::ptime& from, const boost::posix_time::ptime& horizon);
+
+	// Returns false if there are no more firings within the horizon.
+	bool Next(Firing& firing);
+
+	// Up to maxCount next firings.
+	std::vector<Firing> Take(std::size_t maxCount);
+
+private:
+	struct HeapEntry
+	{
+		boost::posix_time::ptime time;
+		std::size_t eventIndex; // Firings at the same time come in the order of the events.
+
+		// For std::push_heap and std::pop_heap, which keep the greatest entry on top.
+		bool operator < (const HeapEntry& rhs) const
+		{
+			return time != rhs.time ? time > rhs.time : eventIndex > rhs.eventIndex;
+		}
+	};
+
+	void Push(std::size_t eventIndex, const boost::posix_time::ptime& after);
+
+private:
+	std::vector<DateTimeEvent*> m_events;
+	boost::posix_time::ptime m_horizon;
+	std::vector<HeapEntry> m_heap;
+};
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+// Lightweight replacement of boost::signals2::signal for notifications that are raised and handled
+// in the main thread only: no locking, no connection bookkeeping, no allocation per call.
+// Slots live as long as the list, so the list must be destroyed before its subscribers.
+// Connecting slots while the list is being called is not supported.
+template<class Signature>
+class DelegateList;
+
+template<class... Args>
+class DelegateList<void (Args...)> : boost::noncopyable
+{
+public:
+	typedef boost::function<void (Args...)> Slot;
+
+	// There is no disconnect. Whatever the slot refers to must outlive the list, e.g. a window binding
+	// its own member functions must be destroyed after the owner of the list, not before.
+	void Connect(const Slot& slot)
+	{
+		m_slots.push_back(slot);
+	}
+
+	bool Empty() const
+	{
+		return m_slots.empty();
+	}
+
+	void operator () (Args... args) const
+	{
+		for (std::size_t i = 0; i < m_slots.size(); ++i)
+			m_slots[i](args...);
+	}
+
+private:
+	std::vector<Slot> m_slots;
+};
\ No newline at end of file
@@ -8,7 +8,7 @@ Event::Event() : m_enabled(true), m_actionListGUID(pfc::guid_null)
 }
 
 Event::Event(const Event& rhs) : m_enabled(rhs.m_enabled), m_actionListGUID(rhs.m_actionListGUID),
-	m_eventGUID(rhs.GetEventGUID())
+	m_eventGUID(rhs.GetEventGUID()), m_condition(rhs.m_condition)
 {
 
 }
@@ -46,12 +46,30 @@ void Event::SetActionListGUID(const GUID& guid)
 	m_actionListGUID = guid;
 }
 
+const Condition& Event::GetCondition() const
+{
+	return m_condition;
+}
+
+void Event::SetCondition(const Condition& condition)
+{
+	m_condition = condition;
+}
+
 void Event::Load(const EventS11nBlock& block)
 {
 	block.enabled.GetValueIfExists(m_enabled);
 	block.eventGUID.GetValueIfExists(m_eventGUID);
 	block.actionListGUID.GetValueIfExists(m_actionListGUID);
 
+	if (block.condition.Exists())
+	{
+		// The editor doesn't accept invalid conditions, so an error means a damaged configuration;
+		// the condition is then false.
+		std::wstring error;
+		m_condition.Compile(pfc::stringcvt::string_wide_from_utf8(block.condition.GetValue()).get_ptr(), error);
+	}
+
 	LoadFromS11nBlock(block);
 }
 
@@ -61,5 +79,8 @@ void Event::Save(EventS11nBlock& block) const
 	block.eventGUID.SetValue(m_eventGUID);
 	block.actionListGUID.SetValue(m_actionListGUID);
 
+	if (!m_condition.GetText().empty())
+		block.condition.SetValue(pfc::stringcvt::string_utf8_from_wide(m_condition.GetText().c_str()).get_ptr());
+
 	SaveToS11nBlock(block);
 }
@@ -2,6 +2,7 @@
 
 #include "event_s11n_block.h"
 #include "event_visitor.h"
+#include "condition.h"
 
 class ActionList;
 
@@ -18,6 +19,10 @@ public:
 	const GUID& GetActionListGUID() const;
 	void SetActionListGUID(const GUID& guid);
 
+	// The task runs only if the condition is true when the event fires.
+	const Condition& GetCondition() const;
+	void SetCondition(const Condition& condition);
+
 	void Load(const EventS11nBlock& block);
 	void Save(EventS11nBlock& block) const;
 
@@ -51,6 +56,7 @@ private:
 	bool m_enabled;
 	GUID m_eventGUID;
 	GUID m_actionListGUID;
+	Condition m_condition;
 };
 
 // For boost::ptr_vector.
@@ -5,6 +5,7 @@
 #include "action_list.h"
 #include "pref_page_model.h"
 #include "generate_duplicate_name.h"
+#include "condition_editor.h"
 
 namespace
 {
@@ -51,6 +52,11 @@ private: // IEventVisitor
 		m_event = event.Duplicate(newMenuItemName);
 	}
 
+	void Visit(PlaybackPositionEvent& event) override
+	{
+		m_event = event.Clone();
+	}
+
 private:
 	std::vector<Event*> m_modelEvents;
 	std::unique_ptr<Event> m_event;
@@ -84,16 +90,22 @@ void EventListWindow::Init(PrefPageModel* pModel)
 	std::vector<Event*> events = m_pModel->GetEvents();
 	std::for_each(events.begin(), events.end(), boost::bind(&EventListWindow::AddNewEvent, this, _1));
 
-	m_pModel->ConnectEventAddedSlot(boost::bind(&EventListWindow::OnNewEventAdded, this, _1));
-	m_pModel->ConnectEventUpdatedSlot(boost::bind(&EventListWindow::OnEventUpdated, this, _1));
+	m_pModel->ConnectEventsAddedSlot(boost::bind(&EventListWindow::OnNewEventsAdded, this, _1));
+	m_pModel->ConnectEventsUpdatedSlot(boost::bind(&EventListWindow::OnEventsUpdated, this, _1));
 	m_pModel->ConnectEventRemovedSlot(boost::bind(&EventListWindow::OnEventRemoved, this, _1));
+	m_pModel->ConnectEventReplacedSlot(boost::bind(&EventListWindow::OnEventReplaced, this, _1, _2));
 
 	m_pModel->ConnectModelResetSlot(boost::bind(&EventListWindow::OnModelReset, this));
 }
 
-void EventListWindow::OnNewEventAdded(Event* pNewEvent)
+void EventListWindow::OnNewEventsAdded(const std::vector<Event*>& events)
 {
-	SelectSingle(AddNewEvent(pNewEvent));
+	size_t pos = 0;
+
+	for (auto it = events.begin(); it != events.end(); ++it)
+		pos = AddNewEvent(*it);
+
+	SelectSingle(pos);
 }
 
 size_t EventListWindow::AddNewEvent(Event* pNewEvent)
@@ -124,14 +136,19 @@ void build_row_data(data_t& out, size_t pos, const Event* pEvent, ActionList* pA
 	out.p = reinterpret_cast<DWORD_PTR>(pEvent);
 }
 
-void EventListWindow::OnEventUpdated(Event* pEvent)
+void EventListWindow::OnEventsUpdated(const std::vector<Event*>& events)
 {
-	size_t item = FindItemByEventID(pEvent);
-	_ASSERTE(item != -1);
+	for (auto it = events.begin(); it != events.end(); ++it)
+	{
+		Event* pEvent = *it;
 
-	auto & d = m_vdata.at(item);
-	ActionList* pActionList = m_pModel->GetActionListByGUID(pEvent->GetActionListGUID());
-	build_row_data(d, item, pEvent, pActionList);
+		size_t item = FindItemByEventID(pEvent);
+		_ASSERTE(item != -1);
+
+		auto & d = m_vdata.at(item);
+		ActionList* pActionList = m_pModel->GetActionListByGUID(pEvent->GetActionListGUID());
+		build_row_data(d, item, pEvent, pActionList);
+	}
 
 	UpdateItemsAll();
 }
@@ -143,18 +160,29 @@ void EventListWindow::ItemAction(size_t item)
 
 size_t EventListWindow::FindItemByEventID(const Event* pEvent)
 {
+	if (!m_itemIndexValid)
+	{
+		m_itemIndex.clear();
+		m_itemIndex.reserve(m_vdata.size());
 
-	auto fit = std::find_if(m_vdata.begin(), m_vdata.end(), [pEvent](const data_t item) {
-		return reinterpret_cast<const Event*>(item.p)->GetEventGUID() == pEvent->GetEventGUID();
-		});
+		for (size_t i = 0; i < m_vdata.size(); ++i)
+			m_itemIndex[reinterpret_cast<const Event*>(m_vdata[i].p)->GetEventGUID()] = i;
 
-	if (fit != m_vdata.end()) return std::distance(m_vdata.begin(), fit);
+		m_itemIndexValid = true;
+	}
+
+	auto fit = m_itemIndex.find(pEvent->GetEventGUID());
+
+	if (fit != m_itemIndex.end()) return fit->second;
 
 	return -1;
 }
 
 size_t EventListWindow::FindItemByEvent(const Event* pEvent)
 {
+	const size_t item = FindItemByEventID(pEvent);
+
+	if (item != -1 && reinterpret_cast<const Event*>(m_vdata[item].p) == pEvent) return item;
 
 	auto fit = std::find_if(m_vdata.begin(), m_vdata.end(), [pEvent](const data_t item) {
 		return reinterpret_cast<const Event*>(item.p) == pEvent;
@@ -193,12 +221,19 @@ void EventListWindow::ShowEventContextMenu(pfc::bit_array_bittable selmask, cons
 		EditEvent(pEvent);
 		break;
 
+	case menuItemCondition:
+		EditEventCondition(pEvent);
+		break;
+
 	case menuItemDuplicate:
 		{
 			EventDuplicateVisitor visitor(m_pModel->GetEvents());
 			pEvent->ApplyVisitor(visitor);
-			pEvent->NewEventGUID();
-			m_pModel->AddEvent(visitor.TakeEvent());
+
+			// The duplicate gets the new GUID, the original keeps its identity.
+			std::unique_ptr<Event> pDuplicate = visitor.TakeEvent();
+			pDuplicate->NewEventGUID();
+			m_pModel->AddEvent(std::move(pDuplicate));
 		}
 		break;
 
@@ -215,6 +250,9 @@ void EventListWindow::ShowEventContextMenu(pfc::bit_array_bittable selmask, cons
 			std::size_t actionListIndex = uCmdID - 1;
 			std::vector<ActionList*> actionLists = m_pModel->GetActionLists();
 
+			// One notification and one redraw for the whole selection.
+			PrefPageModel::Transaction transaction(*m_pModel);
+
 			size_t w = selmask.find_first(true, 0, GetItemCount());
 			while (w < GetItemCount()) {
 				Event* pEvent = first_sel < GetItemCount() ? reinterpret_cast<Event*>(m_vdata.at(w).p) : nullptr;
@@ -278,7 +316,7 @@ void EventListWindow::AppendActionListsItems(CMenu& menuPopup, bool replace, Eve
 	}
 }
 
-void EventListWindow::AppendEventItems(CMenu& menuPopup, const bool single_sel)
+void EventListWindow::AppendEventItems(CMenu& menuPopup, const bool single_sel, bool runnable)
 {
 	menuPopup.AppendMenu(MF_SEPARATOR);
 
@@ -288,6 +326,9 @@ void EventListWindow::AppendEventItems(CMenu& menuPopup, const bool single_sel)
     menuPopup.AppendMenu(MF_STRING | !single_sel ? MF_DISABLED | MF_GRAYED : 0 | MF_BYCOMMAND,
         static_cast<UINT_PTR>(menuItemDuplicate), L"&Duplicate");
 
+	menuPopup.AppendMenu(MF_STRING | !single_sel ? MF_DISABLED | MF_GRAYED : 0 | MF_BYCOMMAND,
+		static_cast<UINT_PTR>(menuItemCondition), L"&Condition...");
+
 	menuPopup.AppendMenu(MF_STRING | MF_BYCOMMAND,
 		static_cast<UINT_PTR>(menuItemRemove), L"Re&move");
 
@@ -313,17 +354,42 @@ void EventListWindow::EditEvent(Event* pEvent)
 	m_pModel->UpdateEvent(pEvent);
 }
 
+void EventListWindow::EditEventCondition(Event* pEvent)
+{
+	Condition condition = pEvent->GetCondition();
+
+	ConditionEditor dlg(condition);
+	if (dlg.DoModal(*this) != IDOK)
+		return;
+
+	pEvent->SetCondition(condition);
+	m_pModel->UpdateEvent(pEvent);
+}
+
 void EventListWindow::OnEventRemoved(Event* pEvent)
 {
 	size_t pos = FindItemByEvent(pEvent);
 	_ASSERTE(pos != -1);
 	m_vdata.erase(m_vdata.begin() + pos);
+	InvalidateItemIndex();
 	UpdateItemsAll();
 }
 
+void EventListWindow::OnEventReplaced(Event* pOldEvent, Event* pNewEvent)
+{
+	// Same GUID, the row index stays valid.
+	size_t pos = FindItemByEvent(pOldEvent);
+	_ASSERTE(pos != -1);
+
+	ActionList* pActionList = m_pModel->GetActionListByGUID(pNewEvent->GetActionListGUID());
+	build_row_data(m_vdata.at(pos), pos, pNewEvent, pActionList);
+	UpdateItem(pos);
+}
+
 void EventListWindow::OnModelReset()
 {
 	m_vdata.clear();
+	InvalidateItemIndex();
 	UpdateItemsAll();
 }
 
@@ -380,6 +446,7 @@ void EventListWindow::InsertEventAtPos(size_t pos, const Event* pEvent)
 	data_t item;
 	build_row_data(item, pos, pEvent, pActionList);
 	m_vdata.emplace_back(item);
+	InvalidateItemIndex();
 }
 
 void EventListWindow::SetCellCheckState(size_t item, size_t subItem, bool value) {
@@ -487,6 +554,7 @@ void EventListWindow::RequestReorder(size_t const* order, size_t count) {
 	}
 
 	pfc::reorder_t(m_vdata, order, count);
+	InvalidateItemIndex();
 
 	this->OnItemsReordered(order, count);
 }
\ No newline at end of file
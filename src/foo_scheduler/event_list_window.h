@@ -1,6 +1,7 @@
 #pragma once
 
 #include "event.h"
+#include "guid_helpers.h"
 
 #include <libPPUI/CListControlComplete.h>
 #include <libPPUI/CListControl-Cells.h>
@@ -27,6 +28,7 @@ public:
 		size_t pos = FindItemByEventID(pEvent);
 		if (pos != ~0) {
 			m_vdata.erase(m_vdata.begin() + pos);
+			InvalidateItemIndex();
 			OnItemRemoved(pos);
 			UpdateItemsAll();
 			return true;
@@ -178,9 +180,10 @@ public:
 	}
 
 private:
-	void OnNewEventAdded(Event* pNewEvent);
-	void OnEventUpdated(Event* pEvent);
+	void OnNewEventsAdded(const std::vector<Event*>& events);
+	void OnEventsUpdated(const std::vector<Event*>& events);
 	void OnEventRemoved(Event* pEvent);
+	void OnEventReplaced(Event* pOldEvent, Event* pNewEvent);
 
 	void OnModelReset();
 
@@ -195,6 +198,7 @@ private:
 	size_t FindItemByEventID(const Event* pEvent);
 	//void MoveEventItem(const Event* pEvent, bool up);
 	void EditEvent(Event* pEvent);
+	void EditEventCondition(Event* pEvent);
 
 	void ShowEventContextMenu(pfc::bit_array_bittable selmask, const CPoint& point);
 
@@ -232,10 +236,17 @@ private:
 		menuItemRemove,
 		menuItemRun,
 		menuItemMoveUp,
-		menuItemMoveDown
+		menuItemMoveDown,
+		menuItemCondition
 	};
 
+	void InvalidateItemIndex() { m_itemIndexValid = false; }
+
 	PrefPageModel* m_pModel;
 	std::vector<data_t> m_vdata;
+
+	// Row of each event by GUID, rebuilt on the first lookup after rows were added, removed or moved.
+	std::unordered_map<GUID, size_t, GUIDHelpers::Hash> m_itemIndex;
+	bool m_itemIndexValid = false;
 };
 
@@ -3,6 +3,7 @@
 #include "date_time_event_s11n_block.h"
 #include "menu_item_event_s11n_block.h"
 #include "player_event_s11n_block.h"
+#include "playback_position_event_s11n_block.h"
 
 struct EventS11nBlock : public S11nBlocks::Block<EventS11nBlock>
 {
@@ -16,10 +17,13 @@ struct EventS11nBlock : public S11nBlocks::Block<EventS11nBlock>
 	S11nBlocks::Field<MenuItemEventS11nBlock, 6> menuItemEvent;
 
 	S11nBlocks::Field<GUID, 7> eventGUID;
+	S11nBlocks::Field<pfc::string8, 8> condition;
+	S11nBlocks::Field<PlaybackPositionEventS11nBlock, 9> positionEvent;
 
 	template<class Archive>
 	void RegisterFields(Archive& ar)
 	{
-		ar.RegisterFields(enabled)(actionListGUID)(protoGUID)(dateTimeEvent)(playerEvent)(menuItemEvent)(eventGUID);
+		ar.RegisterFields(enabled)(actionListGUID)(protoGUID)(dateTimeEvent)(playerEvent)(menuItemEvent)(eventGUID)
+			(condition)(positionEvent);
 	}
 };
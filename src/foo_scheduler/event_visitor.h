@@ -3,6 +3,7 @@
 class PlayerEvent;
 class DateTimeEvent;
 class MenuItemEvent;
+class PlaybackPositionEvent;
 
 class IEventVisitor
 {
@@ -12,4 +13,5 @@ public:
     virtual void Visit(PlayerEvent& event) = 0;
     virtual void Visit(DateTimeEvent& event) = 0;
     virtual void Visit(MenuItemEvent& event) = 0;
+    virtual void Visit(PlaybackPositionEvent& event) = 0;
 };
\ No newline at end of file
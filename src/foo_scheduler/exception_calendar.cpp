@@ -0,0 +1,256 @@
+#include "pch.h"
+#include "exception_calendar.h"
+
+namespace
+{
+	// Days boost::gregorian::date can represent, from_day_number throws outside them.
+	const unsigned long minDay = boost::gregorian::date(1400, 1, 1).day_number();
+	const unsigned long maxDay = boost::gregorian::date(9999, 12, 31).day_number();
+
+	boost::gregorian::date DateFromDayNumber(unsigned long day)
+	{
+		return boost::gregorian::date(boost::gregorian::gregorian_calendar::from_day_number(day));
+	}
+}
+
+ExceptionCalendar::ExceptionCalendar() : m_firstDay(0)
+{
+	NewGUID();
+}
+
+const GUID& ExceptionCalendar::GetGUID() const
+{
+	return m_guid;
+}
+
+void ExceptionCalendar::NewGUID()
+{
+	::UuidCreate(&m_guid);
+}
+
+std::wstring ExceptionCalendar::GetName() const
+{
+	return m_name;
+}
+
+void ExceptionCalendar::SetName(const std::wstring& name)
+{
+	m_name = name;
+}
+
+std::vector<boost::gregorian::date_period> ExceptionCalendar::GetPeriods() const
+{
+	std::vector<boost::gregorian::date_period> result;
+	result.reserve(m_runs.size());
+
+	for (std::size_t i = 0; i < m_runs.size(); ++i)
+	{
+		const boost::gregorian::date first = DateFromDayNumber(m_runs[i].firstDay);
+		result.push_back(boost::gregorian::date_period(first, boost::gregorian::days(m_runs[i].dayCount)));
+	}
+
+	return result;
+}
+
+unsigned long ExceptionCalendar::GetSpan(const std::vector<boost::gregorian::date_period>& periods)
+{
+	unsigned long firstDay = ULONG_MAX;
+	unsigned long endDay = 0;
+
+	for (std::size_t i = 0; i < periods.size(); ++i)
+	{
+		if (periods[i].is_null())
+			continue;
+
+		firstDay = std::min<unsigned long>(firstDay, periods[i].begin().day_number());
+		endDay = std::max<unsigned long>(endDay, periods[i].end().day_number());
+	}
+
+	return endDay > firstDay ? endDay - firstDay : 0;
+}
+
+void ExceptionCalendar::SetPeriods(const std::vector<boost::gregorian::date_period>& periods)
+{
+	std::vector<Run> runs;
+	runs.reserve(periods.size());
+
+	for (std::size_t i = 0; i < periods.size(); ++i)
+	{
+		if (periods[i].is_null())
+			continue;
+
+		Run run = { periods[i].begin().day_number(), static_cast<unsigned long>(periods[i].length().days()) };
+		runs.push_back(run);
+	}
+
+	SetRuns(runs);
+}
+
+bool ExceptionCalendar::Contains(const boost::gregorian::date& date) const
+{
+	if (date.is_special())
+		return false;
+
+	const unsigned long day = date.day_number();
+	return day >= m_firstDay && day - m_firstDay < m_days.size() && m_days[day - m_firstDay];
+}
+
+boost::gregorian::date ExceptionCalendar::GetNextContainedDate(const boost::gregorian::date& date) const
+{
+	if (date.is_special())
+		return boost::gregorian::date(boost::gregorian::not_a_date_time);
+
+	const unsigned long day = date.day_number();
+	auto it = FindRun(day);
+
+	if (it == m_runs.end())
+		return boost::gregorian::date(boost::gregorian::not_a_date_time);
+
+	return it->firstDay <= day ? date : DateFromDayNumber(it->firstDay);
+}
+
+boost::gregorian::date ExceptionCalendar::GetNextNotContainedDate(const boost::gregorian::date& date) const
+{
+	if (date.is_special())
+		return boost::gregorian::date(boost::gregorian::not_a_date_time);
+
+	const unsigned long day = date.day_number();
+	auto it = FindRun(day);
+
+	if (it == m_runs.end() || it->firstDay > day)
+		return date;
+
+	// Runs are merged, so the day after one isn't in the calendar.
+	const unsigned long endDay = it->firstDay + it->dayCount;
+
+	if (endDay > maxDay)
+		return boost::gregorian::date(boost::gregorian::not_a_date_time);
+
+	return DateFromDayNumber(endDay);
+}
+
+bool ExceptionCalendar::IsEmpty() const
+{
+	return m_runs.empty();
+}
+
+boost::gregorian::date ExceptionCalendar::GetLastDate() const
+{
+	if (m_runs.empty())
+		return boost::gregorian::date(boost::gregorian::not_a_date_time);
+
+	return DateFromDayNumber(m_runs.back().firstDay + m_runs.back().dayCount - 1);
+}
+
+void ExceptionCalendar::SetRuns(std::vector<Run> runs)
+{
+	std::sort(runs.begin(), runs.end(),
+		boost::bind(&Run::firstDay, _1) < boost::bind(&Run::firstDay, _2));
+
+	// Overlapping and adjacent runs are merged, so the stored form is minimal.
+	m_runs.clear();
+
+	for (std::size_t i = 0; i < runs.size(); ++i)
+	{
+		if (!m_runs.empty() && runs[i].firstDay <= m_runs.back().firstDay + m_runs.back().dayCount)
+		{
+			Run& last = m_runs.back();
+			last.dayCount = std::max(last.dayCount, runs[i].firstDay + runs[i].dayCount - last.firstDay);
+		}
+		else
+			m_runs.push_back(runs[i]);
+	}
+
+	if (!m_runs.empty())
+	{
+		const unsigned long endDay = m_runs.front().firstDay + maxSpanDays;
+
+		while (!m_runs.empty() && m_runs.back().firstDay >= endDay)
+			m_runs.pop_back();
+
+		Run& last = m_runs.back();
+		last.dayCount = std::min(last.dayCount, endDay - last.firstDay);
+	}
+
+	m_days.clear();
+	m_firstDay = 0;
+
+	if (m_runs.empty())
+		return;
+
+	m_firstDay = m_runs.front().firstDay;
+	m_days.resize(m_runs.back().firstDay + m_runs.back().dayCount - m_firstDay);
+
+	for (std::size_t i = 0; i < m_runs.size(); ++i)
+	{
+		const std::size_t offset = m_runs[i].firstDay - m_firstDay;
+		std::fill_n(m_days.begin() + offset, m_runs[i].dayCount, true);
+	}
+}
+
+std::vector<ExceptionCalendar::Run>::const_iterator ExceptionCalendar::FindRun(unsigned long day) const
+{
+	// Runs are sorted and don't overlap, so their last days are sorted as well.
+	return std::lower_bound(m_runs.begin(), m_runs.end(), day, [](const Run& run, unsigned long d) {
+		return run.firstDay + run.dayCount <= d;
+	});
+}
+
+void ExceptionCalendar::LoadFromS11nBlock(const ExceptionCalendarS11nBlock& block)
+{
+	block.guid.GetValueIfExists(m_guid);
+
+	if (block.name.Exists())
+		m_name = pfc::stringcvt::string_wide_from_utf8(block.name.GetValue()).get_ptr();
+
+	std::vector<Run> runs;
+
+	if (block.runs.Exists())
+	{
+		// 64-bit, so that the sum of damaged gaps doesn't wrap around into the valid range.
+		unsigned __int64 day = 0;
+
+		for (int i = 0; i + 1 < block.runs.GetSize(); i += 2)
+		{
+			const int gap = block.runs.GetAt(i);
+			const int dayCount = block.runs.GetAt(i + 1);
+
+			// Damaged data, the rest can't be placed.
+			if (gap < 0 || dayCount <= 0)
+				break;
+
+			const unsigned __int64 firstDay = day + gap;
+			const unsigned __int64 endDay = firstDay + dayCount;
+
+			// The dates can't be represented or the bitmap would grow too large.
+			if (firstDay < minDay || endDay > maxDay + 1 ||
+				(!runs.empty() && endDay - runs.front().firstDay > maxSpanDays))
+			{
+				break;
+			}
+
+			Run run = { static_cast<unsigned long>(firstDay), static_cast<unsigned long>(dayCount) };
+			runs.push_back(run);
+
+			day = endDay;
+		}
+	}
+
+	SetRuns(runs);
+}
+
+void ExceptionCalendar::SaveToS11nBlock(ExceptionCalendarS11nBlock& block) const
+{
+	block.guid.SetValue(m_guid);
+	block.name.SetValue(pfc::stringcvt::string_utf8_from_wide(m_name.c_str()).toString());
+
+	unsigned long day = 0;
+
+	for (std::size_t i = 0; i < m_runs.size(); ++i)
+	{
+		block.runs.Add(static_cast<int>(m_runs[i].firstDay - day));
+		block.runs.Add(static_cast<int>(m_runs[i].dayCount));
+
+		day = m_runs[i].firstDay + m_runs[i].dayCount;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "exception_calendar_s11n_block.h"
+
+// Named set of dates, e.g. public holidays or vacations, date/time events skip or are limited to.
+// Calendars are immutable once built and shared by the model and the events referring to them,
+// an edit replaces the calendar with a new one of the same GUID.
+class ExceptionCalendar
+{
+public:
+	// Consecutive days, by day number.
+	struct Run
+	{
+		unsigned long firstDay;
+		unsigned long dayCount;
+	};
+
+	// From the first to the last day, bounds the size of the day bitmap. Days past it are dropped.
+	static const unsigned long maxSpanDays = 100 * 366;
+
+	ExceptionCalendar();
+
+	const GUID& GetGUID() const;
+	void NewGUID();
+
+	std::wstring GetName() const;
+	void SetName(const std::wstring& name);
+
+	// Periods may overlap and come in any order, they are merged into runs.
+	std::vector<boost::gregorian::date_period> GetPeriods() const;
+	void SetPeriods(const std::vector<boost::gregorian::date_period>& periods);
+
+	// Number of days from the first day of the periods to the last one, to check against maxSpanDays.
+	static unsigned long GetSpan(const std::vector<boost::gregorian::date_period>& periods);
+
+	// O(1), a bit lookup.
+	bool Contains(const boost::gregorian::date& date) const;
+
+	// First day from date on that is in the calendar, or isn't. not_a_date_time if there is none.
+	// O(log n) in the number of runs.
+	boost::gregorian::date GetNextContainedDate(const boost::gregorian::date& date) const;
+	boost::gregorian::date GetNextNotContainedDate(const boost::gregorian::date& date) const;
+
+	bool IsEmpty() const;
+
+	// not_a_date_time if the calendar is empty.
+	boost::gregorian::date GetLastDate() const;
+
+	void LoadFromS11nBlock(const ExceptionCalendarS11nBlock& block);
+	void SaveToS11nBlock(ExceptionCalendarS11nBlock& block) const;
+
+private:
+	void SetRuns(std::vector<Run> runs);
+
+	// First run ending on or after day, m_runs.end() if there is none.
+	std::vector<Run>::const_iterator FindRun(unsigned long day) const;
+
+private:
+	GUID m_guid;
+	std::wstring m_name;
+	std::vector<Run> m_runs;
+
+	// One bit per day from the first day of the first run to the last day of the last run.
+	unsigned long m_firstDay;
+	std::vector<bool> m_days;
+};
+
+typedef boost::shared_ptr<const ExceptionCalendar> ExceptionCalendarPtr;
\ No newline at end of file
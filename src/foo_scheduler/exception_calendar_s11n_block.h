@@ -0,0 +1,19 @@
+#pragma once
+
+#include "s11n_blocks.h"
+
+struct ExceptionCalendarS11nBlock : public S11nBlocks::Block<ExceptionCalendarS11nBlock>
+{
+	S11nBlocks::Field<GUID, 1> guid;
+	S11nBlocks::Field<pfc::string8, 2> name;
+
+	// Run-length encoded days as pairs: the gap in days since the end of the previous run
+	// (the day number for the first run) and the run length.
+	S11nBlocks::RepeatedField<int, 3> runs;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(guid)(name)(runs);
+	}
+};
\ No newline at end of file
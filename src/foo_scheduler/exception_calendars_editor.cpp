@@ -0,0 +1,254 @@
+#include "pch.h"
+#include "exception_calendars_editor.h"
+#include "pref_page_model.h"
+
+namespace
+{
+	std::wstring FormatDate(const boost::gregorian::date& date)
+	{
+		return pfc::stringcvt::string_wide_from_utf8(boost::gregorian::to_iso_extended_string(date).c_str()).get_ptr();
+	}
+
+	// One date or range per line: 2026-12-24 or 2026-12-24..2027-01-06.
+	std::wstring FormatPeriods(const std::vector<boost::gregorian::date_period>& periods)
+	{
+		std::wstring result;
+
+		for (std::size_t i = 0; i < periods.size(); ++i)
+		{
+			if (i != 0)
+				result += L"\r\n";
+
+			result += FormatDate(periods[i].begin());
+
+			if (periods[i].length().days() > 1)
+				result += L".." + FormatDate(periods[i].last());
+		}
+
+		return result;
+	}
+
+	bool ParseDate(const std::wstring& text, boost::gregorian::date& date)
+	{
+		try
+		{
+			date = boost::gregorian::from_simple_string(
+				pfc::stringcvt::string_utf8_from_wide(boost::trim_copy(text).c_str()).get_ptr());
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+
+		return !date.is_special();
+	}
+
+	// On failure returns the one-based number of the bad line.
+	bool ParsePeriods(const std::wstring& text, std::vector<boost::gregorian::date_period>& periods, int& errorLine)
+	{
+		std::vector<std::wstring> lines;
+		boost::split(lines, text, boost::is_any_of(L"\n"));
+
+		for (std::size_t i = 0; i < lines.size(); ++i)
+		{
+			const std::wstring line = boost::trim_copy(lines[i]);
+
+			if (line.empty())
+				continue;
+
+			const std::wstring::size_type separator = line.find(L"..");
+
+			boost::gregorian::date first;
+			boost::gregorian::date last;
+
+			const bool parsed = separator == std::wstring::npos ?
+				ParseDate(line, first) && ParseDate(line, last) :
+				ParseDate(line.substr(0, separator), first) && ParseDate(line.substr(separator + 2), last);
+
+			if (!parsed || last < first)
+			{
+				errorLine = static_cast<int>(i) + 1;
+				return false;
+			}
+
+			periods.push_back(boost::gregorian::date_period(first, last + boost::gregorian::days(1)));
+		}
+
+		return true;
+	}
+}
+
+ExceptionCalendarsEditor::ExceptionCalendarsEditor(PrefPageModel* pPrefPageModel) :
+	m_pPrefPageModel(pPrefPageModel), m_currentItem(-1), m_loadingItem(false)
+{
+}
+
+BOOL ExceptionCalendarsEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
+{
+	m_calendarsList = GetDlgItem(IDC_LIST_CALENDARS);
+
+	const ModelState::CalendarsContainer& calendars = m_pPrefPageModel->GetCalendars();
+
+	for (std::size_t i = 0; i < calendars.size(); ++i)
+	{
+		Item item;
+		item.pCalendar = calendars[i];
+		item.name = calendars[i]->GetName();
+		item.dates = FormatPeriods(calendars[i]->GetPeriods());
+
+		m_items.push_back(item);
+		m_calendarsList.AddString(item.name.c_str());
+	}
+
+	SelectItem(m_items.empty() ? -1 : 0);
+
+	CenterWindow(GetParent());
+
+	// dark mode
+	m_dark.AddDialogWithControls(m_hWnd);
+
+	return TRUE;
+}
+
+void ExceptionCalendarsEditor::StoreCurrentItem()
+{
+	if (m_currentItem < 0)
+		return;
+
+	CString name;
+	GetDlgItemText(IDC_EDIT_CALENDAR_NAME, name);
+
+	CString dates;
+	GetDlgItemText(IDC_EDIT_CALENDAR_DATES, dates);
+
+	m_items[m_currentItem].name = name.GetString();
+	m_items[m_currentItem].dates = dates.GetString();
+}
+
+void ExceptionCalendarsEditor::SelectItem(int index)
+{
+	m_currentItem = index;
+	m_calendarsList.SetCurSel(index);
+
+	m_loadingItem = true;
+	SetDlgItemText(IDC_EDIT_CALENDAR_NAME, index >= 0 ? m_items[index].name.c_str() : L"");
+	SetDlgItemText(IDC_EDIT_CALENDAR_DATES, index >= 0 ? m_items[index].dates.c_str() : L"");
+	m_loadingItem = false;
+
+	UpdateControls();
+}
+
+void ExceptionCalendarsEditor::UpdateControls()
+{
+	const bool selected = m_currentItem >= 0;
+
+	GetDlgItem(IDC_EDIT_CALENDAR_NAME).EnableWindow(selected);
+	GetDlgItem(IDC_EDIT_CALENDAR_DATES).EnableWindow(selected);
+	GetDlgItem(IDC_BTN_REMOVE_CALENDAR).EnableWindow(selected);
+}
+
+void ExceptionCalendarsEditor::OnCalendarSelChange(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	m_popupTooltipMsg.CleanUp();
+
+	StoreCurrentItem();
+	SelectItem(m_calendarsList.GetCurSel());
+}
+
+void ExceptionCalendarsEditor::OnNameChange(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	if (m_loadingItem || m_currentItem < 0)
+		return;
+
+	StoreCurrentItem();
+
+	// The list shows the name as it's typed.
+	m_calendarsList.DeleteString(m_currentItem);
+	m_calendarsList.InsertString(m_currentItem, m_items[m_currentItem].name.c_str());
+	m_calendarsList.SetCurSel(m_currentItem);
+}
+
+void ExceptionCalendarsEditor::OnAddCalendar(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	StoreCurrentItem();
+
+	Item item;
+	item.name = L"New calendar";
+
+	m_items.push_back(item);
+	m_calendarsList.AddString(item.name.c_str());
+
+	SelectItem(static_cast<int>(m_items.size()) - 1);
+
+	GetDlgItem(IDC_EDIT_CALENDAR_NAME).SetFocus();
+	SendDlgItemMessage(IDC_EDIT_CALENDAR_NAME, EM_SETSEL, 0, -1);
+}
+
+void ExceptionCalendarsEditor::OnRemoveCalendar(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	if (m_currentItem < 0)
+		return;
+
+	m_popupTooltipMsg.CleanUp();
+
+	m_items.erase(m_items.begin() + m_currentItem);
+	m_calendarsList.DeleteString(m_currentItem);
+
+	SelectItem(std::min(m_currentItem, static_cast<int>(m_items.size()) - 1));
+}
+
+void ExceptionCalendarsEditor::OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	if (nID == IDOK)
+	{
+		StoreCurrentItem();
+
+		ModelState::CalendarsContainer calendars;
+
+		for (std::size_t i = 0; i < m_items.size(); ++i)
+		{
+			const Item& item = m_items[i];
+			const int index = static_cast<int>(i);
+
+			if (boost::trim_copy(item.name).empty())
+			{
+				SelectItem(index);
+				m_popupTooltipMsg.Show(L"Enter a name.", GetDlgItem(IDC_EDIT_CALENDAR_NAME));
+				return;
+			}
+
+			std::vector<boost::gregorian::date_period> periods;
+			int errorLine = 0;
+
+			if (!ParsePeriods(item.dates, periods, errorLine))
+			{
+				SelectItem(index);
+
+				const std::wstring message = boost::str(boost::wformat(
+					L"Line %1%: expected a date as YYYY-MM-DD or a range as YYYY-MM-DD..YYYY-MM-DD.") % errorLine);
+				m_popupTooltipMsg.Show(message.c_str(), GetDlgItem(IDC_EDIT_CALENDAR_DATES));
+				return;
+			}
+
+			if (ExceptionCalendar::GetSpan(periods) > ExceptionCalendar::maxSpanDays)
+			{
+				SelectItem(index);
+				m_popupTooltipMsg.Show(L"The dates span more than 100 years.", GetDlgItem(IDC_EDIT_CALENDAR_DATES));
+				return;
+			}
+
+			// An edited calendar keeps its GUID, so the events using it stay bound.
+			boost::shared_ptr<ExceptionCalendar> pCalendar(
+				item.pCalendar ? new ExceptionCalendar(*item.pCalendar) : new ExceptionCalendar);
+
+			pCalendar->SetName(boost::trim_copy(item.name));
+			pCalendar->SetPeriods(periods);
+
+			calendars.push_back(pCalendar);
+		}
+
+		m_pPrefPageModel->SetCalendars(calendars);
+	}
+
+	EndDialog(nID);
+}
\ No newline at end of file
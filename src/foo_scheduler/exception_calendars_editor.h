@@ -0,0 +1,66 @@
+#pragma once
+
+#include "resource.h"
+#include "exception_calendar.h"
+#include "popup_tooltip_message.h"
+
+class PrefPageModel;
+
+//------------------------------------------------------------------------------
+// ExceptionCalendarsEditor
+//------------------------------------------------------------------------------
+
+// Edits all exception calendars of the preferences at once. On OK the calendars are replaced
+// in the preferences model, they are saved when the preferences are applied.
+class ExceptionCalendarsEditor : public CDialogImpl<ExceptionCalendarsEditor>
+{
+public:
+	enum { IDD = IDD_EXCEPTION_CALENDARS };
+
+	explicit ExceptionCalendarsEditor(PrefPageModel* pPrefPageModel);
+
+private:
+	BEGIN_MSG_MAP_EX(ExceptionCalendarsEditor)
+		MSG_WM_INITDIALOG(OnInitDialog)
+		COMMAND_HANDLER_EX(IDC_LIST_CALENDARS, LBN_SELCHANGE, OnCalendarSelChange)
+		COMMAND_HANDLER_EX(IDC_EDIT_CALENDAR_NAME, EN_CHANGE, OnNameChange)
+		COMMAND_ID_HANDLER_EX(IDC_BTN_ADD_CALENDAR, OnAddCalendar)
+		COMMAND_ID_HANDLER_EX(IDC_BTN_REMOVE_CALENDAR, OnRemoveCalendar)
+		COMMAND_ID_HANDLER_EX(IDOK,     OnCloseCmd)
+		COMMAND_ID_HANDLER_EX(IDCANCEL, OnCloseCmd)
+	END_MSG_MAP()
+
+	BOOL OnInitDialog(CWindow wndFocus, LPARAM lInitParam);
+	void OnCloseCmd(UINT uNotifyCode, int nID, CWindow wndCtl);
+
+	void OnCalendarSelChange(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnNameChange(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnAddCalendar(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnRemoveCalendar(UINT uNotifyCode, int nID, CWindow wndCtl);
+
+private:
+	// Calendar as edited, the dates are parsed on OK.
+	struct Item
+	{
+		ExceptionCalendarPtr pCalendar; // Null for added calendars.
+		std::wstring name;
+		std::wstring dates;
+	};
+
+	void StoreCurrentItem();
+	void SelectItem(int index);
+	void UpdateControls();
+
+private:
+	PrefPageModel* m_pPrefPageModel;
+
+	std::vector<Item> m_items;
+	int m_currentItem;
+
+	// Set while the fields are filled, so that their notifications are ignored.
+	bool m_loadingItem;
+
+	CListBox m_calendarsList;
+	PopupTooltipMessage m_popupTooltipMsg;
+	fb2k::CDarkModeHooks m_dark;
+};
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+namespace FadeCurve
+{
+	enum Type
+	{
+		linearPower = 0,
+		linearDb,
+		equalPower,
+		sCurve,
+		exponential,
+
+		numTypes
+	};
+
+	inline std::wstring Label(Type type)
+	{
+		switch (type)
+		{
+		case linearPower:
+			return L"linear";
+
+		case linearDb:
+			return L"linear dB";
+
+		case equalPower:
+			return L"equal power";
+
+		case sCurve:
+			return L"S-curve";
+
+		case exponential:
+			return L"exponential";
+		}
+
+		_ASSERTE(false);
+		return std::wstring();
+	}
+
+	// Volume in dB at the position x (0..1) of a fade from startDb to endDb.
+	inline float Evaluate(Type type, float startDb, float endDb, float x)
+	{
+		// Power 1e-5 corresponds to -100 dB, the lowest volume of the player.
+		const float minPower = 1e-5f;
+
+		const float startPower = std::powf(10.0f, startDb / 20.0f);
+		const float endPower = std::powf(10.0f, endDb / 20.0f);
+
+		float power = 0.0f;
+
+		switch (type)
+		{
+		case linearPower:
+			power = startPower + (endPower - startPower) * x;
+			break;
+
+		case linearDb:
+			return startDb + (endDb - startDb) * x;
+
+		case equalPower:
+			power = std::sqrtf(startPower * startPower * (1.0f - x) + endPower * endPower * x);
+			break;
+
+		case sCurve:
+			return startDb + (endDb - startDb) * x * x * (3.0f - 2.0f * x);
+
+		case exponential:
+			{
+				// Slow start, fast finish.
+				const float k = 5.0f;
+				power = startPower + (endPower - startPower) * (std::expf(k * x) - 1.0f) / (std::expf(k) - 1.0f);
+			}
+			break;
+		}
+
+		return 20.0f * std::log10f(std::max(power, minPower));
+	}
+
+} // namespace FadeCurve
@@ -3,6 +3,9 @@
 #include "service_manager.h"
 #include "version.h"
 #include "foobar_stream.h"
+#include "s11n_blocks.h"
+#include "metrics.h"
+#include "tracer.h"
 
 //------------------------------------------------------------------------------
 // PluginInitQuit
@@ -28,6 +31,8 @@ PluginConfiguration::PluginConfiguration(const GUID& p_guid) : cfg_var(p_guid)
 
 void PluginConfiguration::get_data_raw(stream_writer* p_stream, abort_callback& p_abort)
 {
+	Metrics::ScopedTimer timer(Metrics::histConfigSave);
+
 	foobar_stream_writer stream(*p_stream, p_abort);
 
 	t_uint16 cfgVersion = PLUGIN_CFG_GLOBAL_VERSION;
@@ -38,6 +43,8 @@ void PluginConfiguration::get_data_raw(stream_writer* p_stream, abort_callback&
 
 void PluginConfiguration::set_data_raw(stream_reader* p_stream, t_size p_sizehint, abort_callback& p_abort)
 {
+	Metrics::ScopedTimer timer(Metrics::histConfigLoad);
+
 	foobar_stream_reader stream(*p_stream, p_abort);
 
 	// Reading config version
@@ -60,7 +67,8 @@ void PluginConfiguration::set_data_raw(stream_reader* p_stream, t_size p_sizehin
 		return;
 	}
 
-	ServiceManager::Instance().GetModel().Load(stream);
+	S11nBlocks::ParseLimitsScope limits(S11nBlocks::ParseLimits(), p_sizehint);
+	ServiceManager::Instance().GetModel().Load(stream, cfgVersion >= PLUGIN_CFG_GLOBAL_V4_22);
 }
 
 //------------------------------------------------------------------------------
@@ -118,6 +126,25 @@ namespace MainMenuItems
 		static const GUID guidStopAllActionLists =
 			{ 0xd67d975e, 0x5b8, 0x499a, { 0x9b, 0x8d, 0x75, 0xb9, 0xa8, 0x87, 0x5a, 0x30 } };
 
+		// {6AECFED9-BFC5-44A0-B677-AD5E5C206AA7} mod guid
+		static const GUID guidDumpStatistics =
+			{ 0x6aecfed9, 0xbfc5, 0x44a0, { 0xb6, 0x77, 0xad, 0x5e, 0x5c, 0x20, 0x6a, 0xa7 } };
+
+		// {DC31B3CA-1370-48B8-B11E-D13895B969F9} mod guid
+		static const GUID guidSaveStatistics =
+			{ 0xdc31b3ca, 0x1370, 0x48b8, { 0xb1, 0x1e, 0xd1, 0x38, 0x95, 0xb9, 0x69, 0xf9 } };
+
+		// {AB03F95E-6702-4A99-81CD-E720494276B3} mod guid
+		static const GUID guidResetStatistics =
+			{ 0xab03f95e, 0x6702, 0x4a99, { 0x81, 0xcd, 0xe7, 0x20, 0x49, 0x42, 0x76, 0xb3 } };
+
+		// {9B61B4AB-0D4D-47AB-80A3-E47F5706677E} mod guid
+		static const GUID guidRecordTrace =
+			{ 0x9b61b4ab, 0xd4d, 0x47ab, { 0x80, 0xa3, 0xe4, 0x7f, 0x57, 0x6, 0x67, 0x7e } };
+
+		// {B5FEBC4E-F29F-4443-9CBE-8AC84D498246} mod guid
+		static const GUID guidSaveTrace =
+			{ 0xb5febc4e, 0xf29f, 0x4443, { 0x9c, 0xbe, 0x8a, 0xc8, 0x4d, 0x49, 0x82, 0x46 } };
 
 		if (p_index == miiPreferences)
 			return guidPreferences;
@@ -125,6 +152,16 @@ namespace MainMenuItems
 			return guidStatusWindow;
 		else if (p_index == miiStopAllActionLists)
 			return guidStopAllActionLists;
+		else if (p_index == miiDumpStatistics)
+			return guidDumpStatistics;
+		else if (p_index == miiSaveStatistics)
+			return guidSaveStatistics;
+		else if (p_index == miiResetStatistics)
+			return guidResetStatistics;
+		else if (p_index == miiRecordTrace)
+			return guidRecordTrace;
+		else if (p_index == miiSaveTrace)
+			return guidSaveTrace;
 
 		return pfc::guid_null;
 	}
@@ -137,6 +174,16 @@ namespace MainMenuItems
 			p_out = "Status window";
 		else if (p_index == miiStopAllActionLists)
 			p_out = "Stop all tasks";
+		else if (p_index == miiDumpStatistics)
+			p_out = "Dump statistics";
+		else if (p_index == miiSaveStatistics)
+			p_out = "Save statistics";
+		else if (p_index == miiResetStatistics)
+			p_out = "Reset statistics";
+		else if (p_index == miiRecordTrace)
+			p_out = "Record execution trace";
+		else if (p_index == miiSaveTrace)
+			p_out = "Save execution trace";
 	}
 
 	bool SchedulerMainPopupCommands::get_description(t_uint32 p_index, pfc::string_base& p_out)
@@ -147,12 +194,33 @@ namespace MainMenuItems
 			p_out = "Opens status window.";
 		else if (p_index == miiStopAllActionLists)
 			p_out = "Stops all tasks.";
+		else if (p_index == miiDumpStatistics)
+			p_out = "Writes scheduler timing statistics to the console.";
+		else if (p_index == miiSaveStatistics)
+			p_out = "Saves scheduler timing statistics in JSON format to the profile folder.";
+		else if (p_index == miiResetStatistics)
+			p_out = "Clears scheduler timing statistics collected so far.";
+		else if (p_index == miiRecordTrace)
+			p_out = "Records events, tasks and actions for later analysis.";
+		else if (p_index == miiSaveTrace)
+			p_out = "Saves recorded execution trace in Chrome trace-event format to the profile folder.";
 		else
 			return false;
 
 		return true;
 	}
 
+	bool SchedulerMainPopupCommands::get_display(t_uint32 p_index, pfc::string_base& p_text, t_uint32& p_flags)
+	{
+		p_flags = 0;
+
+		if (p_index == miiRecordTrace && Tracer::IsEnabled())
+			p_flags |= flag_checked;
+
+		get_name(p_index, p_text);
+		return true;
+	}
+
 	GUID SchedulerMainPopupCommands::get_parent()
 	{
 		return SchedulerMainPopupMenu::m_guid;
@@ -171,6 +239,35 @@ namespace MainMenuItems
 			ServiceManager::Instance().GetRootController().ShowStatusWindow();
 		else if (p_index == miiStopAllActionLists)
 			ServiceManager::Instance().GetRootController().RemoveAllExecSessions();
+		else if (p_index == miiDumpStatistics)
+			console::info((COMPONENT_NAME " statistics:\n" + Metrics::FormatText()).c_str());
+		else if (p_index == miiRecordTrace)
+			Tracer::Enable(!Tracer::IsEnabled());
+		else if (p_index == miiSaveStatistics)
+			SaveToProfileFolder(COMPONENT_NAME "_statistics.json", Metrics::FormatJson(), "statistics");
+		else if (p_index == miiResetStatistics)
+			Metrics::Reset();
+		else if (p_index == miiSaveTrace)
+			SaveToProfileFolder(COMPONENT_NAME "_trace.json", Tracer::ExportChromeJson(), "execution trace");
+	}
+
+	void SchedulerMainPopupCommands::SaveToProfileFolder(const char* fileName, const std::string& content, const char* what)
+	{
+		pfc::string8 path = core_api::get_profile_path();
+		path << "\\" << fileName;
+
+		try
+		{
+			file::ptr pFile;
+			filesystem::g_open_write_new(pFile, path, fb2k::noAbort);
+			pFile->write(content.data(), content.size(), fb2k::noAbort);
+
+			console::formatter() << COMPONENT_NAME ": " << what << " saved to " << path;
+		}
+		catch (const std::exception& e)
+		{
+			console::formatter() << COMPONENT_NAME ": failed to save " << what << ": " << e.what();
+		}
 	}
 
 	//------------------------------------------------------------------------------
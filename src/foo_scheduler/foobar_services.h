@@ -42,16 +42,26 @@ namespace MainMenuItems
 		virtual GUID     get_command(t_uint32 p_index);
 		virtual void     get_name(t_uint32 p_index, pfc::string_base& p_out);
 		virtual bool     get_description(t_uint32 p_index, pfc::string_base& p_out);
+		virtual bool     get_display(t_uint32 p_index, pfc::string_base& p_text, t_uint32& p_flags);
 		virtual GUID     get_parent();
 		virtual t_uint32 get_sort_priority();
 		virtual void     execute(t_uint32 p_index, service_ptr_t<service_base> p_callback);
 
+	private:
+		// Writes content to a file in the profile folder and reports the result to the console.
+		void SaveToProfileFolder(const char* fileName, const std::string& content, const char* what);
+
 	private:
 		enum EMenuItemIndex
 		{
 			miiPreferences = 0,
 			miiStatusWindow,
 			miiStopAllActionLists,
+			miiDumpStatistics,
+			miiSaveStatistics,
+			miiResetStatistics,
+			miiRecordTrace,
+			miiSaveTrace,
 
 			numMenuItems
 		};
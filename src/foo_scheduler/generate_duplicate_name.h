@@ -1,23 +1,69 @@
 #pragma once
 
-template <typename Container, typename Func>
-std::wstring GenerateDuplicateName(
-    const std::wstring &originalName, const Container &container, const Func &nameAccessor)
+// Names taken so far, kept in a hash set, so that many names can be generated
+// without rescanning the container for every candidate.
+class DuplicateNameSet
 {
-    for (int i = 1;; ++i)
+public:
+    template <typename Container, typename Func>
+    DuplicateNameSet(const Container &container, const Func &nameAccessor)
     {
-        const std::wstring candidateName = originalName + L" (" + boost::lexical_cast<std::wstring>(i) + L")";
+        m_names.reserve(container.size());
 
-        auto it = std::find_if(
-            container.cbegin(), container.cend(),
-            [&candidateName, &nameAccessor](const typename Container::value_type &item) {
-            return nameAccessor(item) == candidateName;
-        });
+        for (auto it = container.cbegin(); it != container.cend(); ++it)
+            m_names.insert(nameAccessor(*it));
+    }
 
-        if (it == container.cend())
-            return candidateName;
+    bool Contains(const std::wstring &name) const
+    {
+        return m_names.count(name) != 0;
     }
 
-    // Unreachable
-    return std::wstring();
+    void Add(const std::wstring &name)
+    {
+        m_names.insert(name);
+    }
+
+    void Remove(const std::wstring &name)
+    {
+        m_names.erase(name);
+    }
+
+    // Returns the first free "originalName (i)" and takes it.
+    std::wstring GenerateDuplicateName(const std::wstring &originalName)
+    {
+        // Suffixes below the last one generated for this name are taken.
+        int &nextSuffix = m_nextSuffixes[originalName];
+
+        for (int i = std::max(nextSuffix, 1);; ++i)
+        {
+            std::wstring candidateName = originalName + L" (" + boost::lexical_cast<std::wstring>(i) + L")";
+
+            if (m_names.insert(candidateName).second)
+            {
+                nextSuffix = i + 1;
+                return candidateName;
+            }
+        }
+    }
+
+    // Returns the name itself if it's free, otherwise a generated duplicate name. The result is taken.
+    std::wstring MakeUnique(const std::wstring &name)
+    {
+        if (m_names.insert(name).second)
+            return name;
+
+        return GenerateDuplicateName(name);
+    }
+
+private:
+    std::unordered_set<std::wstring> m_names;
+    std::unordered_map<std::wstring, int> m_nextSuffixes;
+};
+
+template <typename Container, typename Func>
+std::wstring GenerateDuplicateName(
+    const std::wstring &originalName, const Container &container, const Func &nameAccessor)
+{
+    return DuplicateNameSet(container, nameAccessor).GenerateDuplicateName(originalName);
 }
\ No newline at end of file
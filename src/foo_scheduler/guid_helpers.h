@@ -0,0 +1,33 @@
+#pragma once
+
+namespace GUIDHelpers
+{
+	// Strict weak ordering of GUIDs for ordered containers.
+	struct Less
+	{
+		bool operator () (const GUID& lhs, const GUID& rhs) const
+		{
+			return memcmp(&lhs, &rhs, sizeof(GUID)) < 0;
+		}
+	};
+
+	// Hash for unordered containers. GUIDs are created randomly, mixing the two halves is enough.
+	struct Hash
+	{
+		std::size_t operator () (const GUID& guid) const
+		{
+			unsigned __int64 halves[2];
+			memcpy(halves, &guid, sizeof(halves));
+
+			const unsigned __int64 h = halves[0] ^ (halves[1] * 0x9e3779b97f4a7c15ULL);
+			return static_cast<std::size_t>(h ^ (h >> 32));
+		}
+	};
+
+	template<class T>
+	struct Index
+	{
+		typedef std::unordered_map<GUID, T*, Hash> Type;
+	};
+
+} // namespace GUIDHelpers
\ No newline at end of file
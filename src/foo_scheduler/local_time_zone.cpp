@@ -0,0 +1,211 @@
+#include "pch.h"
+#include "local_time_zone.h"
+
+namespace
+{
+	// Years covered around the current one, the table is extended for times outside them.
+	const int yearsBack = 1;
+	const int yearsAhead = 4;
+
+	// Time zone changes are rare, querying the zone on every conversion isn't worth it.
+	const ULONGLONG checkIntervalMs = 60 * 1000;
+
+	// Local time of a transition in the year. A rule either has the date (wYear is set)
+	// or is the wDay-th wDayOfWeek of the month, 5 meaning the last one.
+	boost::posix_time::ptime TransitionTime(const SYSTEMTIME& rule, int year)
+	{
+		boost::gregorian::date date;
+
+		if (rule.wYear != 0)
+			date = boost::gregorian::date(year, rule.wMonth, rule.wDay);
+		else if (rule.wDay >= 5)
+			date = boost::gregorian::last_day_of_the_week_in_month(rule.wDayOfWeek, rule.wMonth).get_date(year);
+		else
+		{
+			date = boost::gregorian::nth_day_of_the_week_in_month(
+				static_cast<boost::gregorian::nth_day_of_the_week_in_month::week_num>(rule.wDay),
+				rule.wDayOfWeek, rule.wMonth).get_date(year);
+		}
+
+		return boost::posix_time::ptime(date,
+			boost::posix_time::hours(rule.wHour) + boost::posix_time::minutes(rule.wMinute) +
+			boost::posix_time::seconds(rule.wSecond) + boost::posix_time::milliseconds(rule.wMilliseconds));
+	}
+
+	struct Transition
+	{
+		boost::posix_time::ptime utcTime;
+		boost::posix_time::time_duration utcOffset;
+	};
+}
+
+LocalTimeZone::LocalTimeZone() : m_lastCheckTime(0), m_firstYear(0), m_lastYear(0)
+{
+	memset(&m_timeZone, 0, sizeof(m_timeZone));
+}
+
+boost::posix_time::ptime LocalTimeZone::LocalToUTC(const boost::posix_time::ptime& local,
+	SkippedTimePolicy skippedPolicy, RepeatedTimePolicy repeatedPolicy)
+{
+	if (local.is_special())
+		return local;
+
+	EnsureTable(local.date().year());
+
+	// The last period starting at or before the local time.
+	auto it = std::upper_bound(m_periods.begin(), m_periods.end(), local,
+		[] (const boost::posix_time::ptime& t, const Period& period) { return t < period.localStart; });
+
+	if (it != m_periods.begin())
+		--it;
+
+	const boost::posix_time::ptime utc = local - it->utcOffset;
+
+	// Clocks went back at the start of the period, the end of the previous one is repeated.
+	if (it != m_periods.begin())
+	{
+		const boost::posix_time::ptime previousUTC = local - (it - 1)->utcOffset;
+
+		if (previousUTC < it->utcStart)
+			return repeatedPolicy == repeatedEarlier ? previousUTC : utc;
+	}
+
+	// Clocks go forward at the start of the next period and skip the time.
+	auto next = it + 1;
+
+	if (next != m_periods.end() && utc >= next->utcStart)
+		return skippedPolicy == skippedShiftForward ? utc : next->utcStart;
+
+	return utc;
+}
+
+boost::posix_time::ptime LocalTimeZone::UTCToLocal(const boost::posix_time::ptime& utc)
+{
+	if (utc.is_special())
+		return utc;
+
+	EnsureTable(utc.date().year());
+
+	// The last period starting at or before the time.
+	auto it = std::upper_bound(m_periods.begin(), m_periods.end(), utc,
+		[] (const boost::posix_time::ptime& t, const Period& period) { return t < period.utcStart; });
+
+	if (it != m_periods.begin())
+		--it;
+
+	return utc + it->utcOffset;
+}
+
+bool LocalTimeZone::TimeZoneChanged(DYNAMIC_TIME_ZONE_INFORMATION& timeZone)
+{
+	const ULONGLONG now = GetTickCount64();
+
+	if (!m_periods.empty() && now - m_lastCheckTime < checkIntervalMs)
+		return false;
+
+	m_lastCheckTime = now;
+
+	// Zeroed, so that the unused parts of the names compare equal.
+	memset(&timeZone, 0, sizeof(timeZone));
+	GetDynamicTimeZoneInformation(&timeZone);
+
+	return m_periods.empty() || memcmp(&timeZone, &m_timeZone, sizeof(timeZone)) != 0;
+}
+
+void LocalTimeZone::EnsureTable(int year)
+{
+	DYNAMIC_TIME_ZONE_INFORMATION timeZone;
+	const bool changed = TimeZoneChanged(timeZone);
+
+	if (!changed && year >= m_firstYear && year <= m_lastYear)
+		return;
+
+	int firstYear = m_firstYear;
+	int lastYear = m_lastYear;
+
+	if (changed)
+	{
+		const int currentYear = boost::gregorian::day_clock::local_day().year();
+
+		firstYear = currentYear - yearsBack;
+		lastYear = currentYear + yearsAhead;
+
+		m_timeZone = timeZone;
+	}
+
+	BuildTable(std::min(firstYear, year), std::max(lastYear, year));
+}
+
+void LocalTimeZone::BuildTable(int firstYear, int lastYear)
+{
+	m_periods.clear();
+	m_firstYear = firstYear;
+	m_lastYear = lastYear;
+
+	std::vector<Transition> transitions;
+
+	for (int year = firstYear; year <= lastYear; ++year)
+	{
+		TIME_ZONE_INFORMATION tzi;
+
+		// The previous year's offsets continue.
+		if (!GetTimeZoneInformationForYear(static_cast<USHORT>(year), &m_timeZone, &tzi))
+			continue;
+
+		const boost::posix_time::time_duration standardOffset =
+			boost::posix_time::minutes(-(tzi.Bias + tzi.StandardBias));
+		const boost::posix_time::time_duration daylightOffset =
+			boost::posix_time::minutes(-(tzi.Bias + tzi.DaylightBias));
+
+		const boost::posix_time::ptime yearStart(boost::gregorian::date(year, 1, 1));
+
+		// Rules may differ from year to year, they change at the new year.
+		if (m_timeZone.DynamicDaylightTimeDisabled || tzi.StandardDate.wMonth == 0 || tzi.DaylightDate.wMonth == 0)
+		{
+			Transition t = { yearStart - standardOffset, standardOffset };
+			transitions.push_back(t);
+			continue;
+		}
+
+		// Daylight time starts at a standard local time and ends at a daylight one.
+		const boost::posix_time::ptime daylightStart = TransitionTime(tzi.DaylightDate, year) - standardOffset;
+		const boost::posix_time::ptime standardStart = TransitionTime(tzi.StandardDate, year) - daylightOffset;
+
+		// In the southern hemisphere daylight time spans the new year.
+		const boost::posix_time::time_duration yearStartOffset =
+			daylightStart < standardStart ? standardOffset : daylightOffset;
+
+		Transition t1 = { yearStart - yearStartOffset, yearStartOffset };
+		Transition t2 = { daylightStart, daylightOffset };
+		Transition t3 = { standardStart, standardOffset };
+
+		transitions.push_back(t1);
+		transitions.push_back(t2);
+		transitions.push_back(t3);
+	}
+
+	std::sort(transitions.begin(), transitions.end(),
+		boost::bind(&Transition::utcTime, _1) < boost::bind(&Transition::utcTime, _2));
+
+	// A day ahead, so that the first year is covered whatever the offset is.
+	Period first;
+	first.utcStart = boost::posix_time::ptime(boost::gregorian::date(firstYear, 1, 1)) - boost::gregorian::days(1);
+	first.utcOffset = !transitions.empty() ? transitions.front().utcOffset :
+		boost::posix_time::minutes(-(m_timeZone.Bias + m_timeZone.StandardBias));
+	first.localStart = first.utcStart + first.utcOffset;
+
+	m_periods.push_back(first);
+
+	for (std::size_t i = 0; i < transitions.size(); ++i)
+	{
+		if (transitions[i].utcOffset == m_periods.back().utcOffset)
+			continue;
+
+		Period period;
+		period.utcStart = transitions[i].utcTime;
+		period.utcOffset = transitions[i].utcOffset;
+		period.localStart = period.utcStart + period.utcOffset;
+
+		m_periods.push_back(period);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// LocalTimeZone
+//------------------------------------------------------------------------------
+
+// Converts between local times and UTC with the UTC offset in effect at that time, not the current one.
+// The offsets of the system time zone are kept as a table of periods between transitions,
+// computed for a few years around the converted times, so a conversion is a binary search.
+// The system time zone is checked at most once a minute and the table is rebuilt when it has changed.
+// Not thread safe.
+class LocalTimeZone : private boost::noncopyable
+{
+public:
+	// Local times that don't exist, as clocks go forward over them.
+	enum SkippedTimePolicy
+	{
+		skippedShiftForward, // By the length of the gap: 02:30 is 03:30 when 02:00 becomes 03:00.
+		skippedToTransition  // The first valid time, 03:00.
+	};
+
+	// Local times that occur twice, as clocks go back over them.
+	enum RepeatedTimePolicy
+	{
+		repeatedEarlier,
+		repeatedLater
+	};
+
+	LocalTimeZone();
+
+	boost::posix_time::ptime LocalToUTC(const boost::posix_time::ptime& local,
+		SkippedTimePolicy skippedPolicy, RepeatedTimePolicy repeatedPolicy);
+
+	// Unambiguous, both passes of a repeated time map to the same local time.
+	boost::posix_time::ptime UTCToLocal(const boost::posix_time::ptime& utc);
+
+private:
+	struct Period
+	{
+		boost::posix_time::ptime utcStart;
+		boost::posix_time::ptime localStart;
+		boost::posix_time::time_duration utcOffset; // Local time minus UTC.
+	};
+
+	// Builds the table if the year isn't covered or the time zone has changed.
+	void EnsureTable(int year);
+	void BuildTable(int firstYear, int lastYear);
+
+	// True if the system time zone differs from m_timeZone. Queries it only once the check interval has passed.
+	bool TimeZoneChanged(DYNAMIC_TIME_ZONE_INFORMATION& timeZone);
+
+private:
+	DYNAMIC_TIME_ZONE_INFORMATION m_timeZone;
+	ULONGLONG m_lastCheckTime; // GetTickCount64() of the last time zone query.
+
+	// Ordered by start, the first period starts a day before the first year, the last one doesn't end.
+	std::vector<Period> m_periods;
+	int m_firstYear;
+	int m_lastYear;
+};
\ No newline at end of file
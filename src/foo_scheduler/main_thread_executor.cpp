@@ -0,0 +1,84 @@
+#include "pch.h"
+#include "main_thread_executor.h"
+#include "metrics.h"
+
+MainThreadExecutor::MainThreadExecutor() : m_sliceScheduled(false)
+{
+}
+
+void MainThreadExecutor::Post(TaskPriority::Type priority, const AsyncCall::CallbackPtr& callback)
+{
+	QueuedStep step;
+	step.callback = callback;
+	step.queuedTime = Metrics::NowMicroseconds();
+
+	m_queues[priority].push_back(step);
+
+	ScheduleSlice();
+}
+
+AsyncCall::CallbackPtr MainThreadExecutor::MakePostingCallback(
+	TaskPriority::Type priority, const AsyncCall::CallbackPtr& callback)
+{
+	return AsyncCall::MakeCallback(boost::bind(&MainThreadExecutor::Post, this, priority, callback));
+}
+
+void MainThreadExecutor::Shutdown()
+{
+	for (int i = 0; i < TaskPriority::numTypes; ++i)
+		m_queues[i].clear();
+}
+
+void MainThreadExecutor::ScheduleSlice()
+{
+	if (m_sliceScheduled)
+		return;
+
+	m_sliceScheduled = true;
+	AsyncCall::AsyncRunInMainThread(AsyncCall::MakeCallback(boost::bind(&MainThreadExecutor::RunSlice, this)));
+}
+
+void MainThreadExecutor::RunSlice()
+{
+	Metrics::Increment(Metrics::counterExecutorSlices);
+
+	const __int64 startTime = Metrics::NowMicroseconds();
+
+	for (;;)
+	{
+		int priority = TaskPriority::numTypes - 1;
+
+		while (priority >= 0 && m_queues[priority].empty())
+			--priority;
+
+		if (priority < 0)
+			break;
+
+		// At least one step is run, so every slice makes progress.
+		const __int64 now = Metrics::NowMicroseconds();
+
+		if (now - startTime >= s_sliceBudget)
+			break;
+
+		QueuedStep step = m_queues[priority].front();
+		m_queues[priority].pop_front();
+
+		Metrics::Record(static_cast<Metrics::HistogramID>(Metrics::histStepWaitLow + priority), now - step.queuedTime);
+
+		// Steps posted meanwhile are queued and run in this or the next slice.
+		step.callback->Run();
+	}
+
+	Metrics::Record(Metrics::histExecutorSlice, Metrics::NowMicroseconds() - startTime);
+
+	m_sliceScheduled = false;
+
+	for (int i = 0; i < TaskPriority::numTypes; ++i)
+	{
+		if (!m_queues[i].empty())
+		{
+			ScheduleSlice();
+			break;
+		}
+	}
+}
\ No newline at end of file
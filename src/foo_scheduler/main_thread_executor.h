@@ -0,0 +1,43 @@
+#pragma once
+
+#include "async_call.h"
+#include "task_priority.h"
+
+//------------------------------------------------------------------------------
+// MainThreadExecutor
+//------------------------------------------------------------------------------
+
+// Runs steps of tasks in the main thread in slices. A slice runs queued steps, higher priority first,
+// until the time budget is used up, the rest waits for the next slice, so other main thread work
+// isn't held up. A step is never interrupted, the order is decided only between steps.
+// All functions must be called in the main thread.
+class MainThreadExecutor : private boost::noncopyable
+{
+public:
+	MainThreadExecutor();
+
+	void Post(TaskPriority::Type priority, const AsyncCall::CallbackPtr& callback);
+
+	// Returns a callback that posts callback with priority when run.
+	// It's given to actions as a completion call, which they run in the main thread.
+	AsyncCall::CallbackPtr MakePostingCallback(TaskPriority::Type priority, const AsyncCall::CallbackPtr& callback);
+
+	// Drops all queued steps.
+	void Shutdown();
+
+	static const __int64 s_sliceBudget = 8000; // Microseconds.
+
+private:
+	void ScheduleSlice();
+	void RunSlice();
+
+private:
+	struct QueuedStep
+	{
+		AsyncCall::CallbackPtr callback;
+		__int64 queuedTime;
+	};
+
+	std::deque<QueuedStep> m_queues[TaskPriority::numTypes];
+	bool m_sliceScheduled;
+};
\ No newline at end of file
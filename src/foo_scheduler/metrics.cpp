@@ -0,0 +1,317 @@
+#include "pch.h"
+#include "metrics.h"
+
+namespace Metrics
+{
+
+namespace
+{
+	// Values below 2^subBucketBits are counted exactly. Above that every power of two
+	// is split into 2^subBucketBits linear sub-buckets, which keeps the relative error under 25%.
+	const int subBucketBits = 2;
+	const int subBuckets = 1 << subBucketBits;
+	const int maxValueBits = 40; // About 12 days in microseconds, larger values fall into the last bucket.
+	const int numBuckets = subBuckets + (maxValueBits - subBucketBits) * subBuckets;
+
+	int BucketIndex(unsigned __int64 value)
+	{
+		if (value < subBuckets)
+			return static_cast<int>(value);
+
+		int exponent = 0;
+
+		while ((value >> exponent) >= 2 * subBuckets)
+			++exponent;
+
+		const int index = subBuckets + exponent * subBuckets + static_cast<int>((value >> exponent) - subBuckets);
+		return std::min(index, numBuckets - 1);
+	}
+
+	// Highest value counted in the bucket.
+	unsigned __int64 BucketUpperBound(int index)
+	{
+		if (index < subBuckets)
+			return index;
+
+		const int exponent = (index - subBuckets) / subBuckets;
+		const unsigned __int64 base = static_cast<unsigned __int64>(subBuckets + (index - subBuckets) % subBuckets);
+
+		return ((base + 1) << exponent) - 1;
+	}
+
+	class Histogram : boost::noncopyable
+	{
+	public:
+		Histogram()
+		{
+			Reset();
+		}
+
+		void Record(__int64 value)
+		{
+			const unsigned __int64 v = value > 0 ? static_cast<unsigned __int64>(value) : 0;
+
+			m_buckets[BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+			m_sum.fetch_add(v, std::memory_order_relaxed);
+
+			unsigned __int64 max = m_max.load(std::memory_order_relaxed);
+			while (v > max && !m_max.compare_exchange_weak(max, v, std::memory_order_relaxed))
+				;
+		}
+
+		void Reset()
+		{
+			for (int i = 0; i < numBuckets; ++i)
+				m_buckets[i].store(0, std::memory_order_relaxed);
+
+			m_sum.store(0, std::memory_order_relaxed);
+			m_max.store(0, std::memory_order_relaxed);
+		}
+
+		struct Snapshot
+		{
+			std::vector<unsigned __int64> buckets;
+			unsigned __int64 count;
+			unsigned __int64 sum;
+			unsigned __int64 max;
+
+			double Mean() const
+			{
+				return count != 0 ? static_cast<double>(sum) / count : 0.0;
+			}
+
+			unsigned __int64 Percentile(double q) const
+			{
+				const unsigned __int64 rank = std::max<unsigned __int64>(1,
+					static_cast<unsigned __int64>(std::ceil(q * static_cast<double>(count))));
+
+				unsigned __int64 accumulated = 0;
+
+				for (int i = 0; i < numBuckets; ++i)
+				{
+					accumulated += buckets[i];
+
+					// The last bucket also holds all values out of range.
+					if (accumulated >= rank)
+						return i == numBuckets - 1 ? max : std::min(BucketUpperBound(i), max);
+				}
+
+				return max;
+			}
+		};
+
+		Snapshot GetSnapshot() const
+		{
+			Snapshot snapshot;
+			snapshot.buckets.resize(numBuckets);
+			snapshot.count = 0;
+
+			// Count is taken from the buckets, so that percentiles are consistent with them.
+			for (int i = 0; i < numBuckets; ++i)
+			{
+				snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+				snapshot.count += snapshot.buckets[i];
+			}
+
+			snapshot.sum = m_sum.load(std::memory_order_relaxed);
+			snapshot.max = m_max.load(std::memory_order_relaxed);
+
+			return snapshot;
+		}
+
+	private:
+		std::atomic<unsigned __int64> m_buckets[numBuckets];
+		std::atomic<unsigned __int64> m_sum;
+		std::atomic<unsigned __int64> m_max;
+	};
+
+	struct Gauge
+	{
+		Gauge() : value(0), max(0) {}
+
+		std::atomic<__int64> value;
+		std::atomic<__int64> max;
+	};
+
+	Histogram s_histograms[numHistograms];
+	std::atomic<__int64> s_counters[numCounters];
+	Gauge s_gauges[numGauges];
+
+	struct MetricName
+	{
+		const char* key;   // JSON export.
+		const char* label; // Text report.
+	};
+
+	const MetricName s_histogramNames[numHistograms] =
+	{
+		{ "fire_lateness", "Event fire lateness" },
+		{ "main_thread_queue_delay", "Main thread queue delay" },
+		{ "action_duration", "Action duration" },
+		{ "task_duration", "Task duration" },
+		{ "config_load", "Configuration load" },
+		{ "config_save", "Configuration save" },
+		{ "schedule_update", "Date/time schedule update" },
+		{ "player_event_dispatch", "Player event dispatch" },
+		{ "step_wait_low", "Task step wait (low priority)" },
+		{ "step_wait_normal", "Task step wait (normal priority)" },
+		{ "step_wait_high", "Task step wait (high priority)" },
+		{ "executor_slice", "Executor slice" }
+	};
+
+	const MetricName s_counterNames[numCounters] =
+	{
+		{ "events_fired", "Events fired" },
+		{ "actions_run", "Actions run" },
+		{ "tasks_completed", "Tasks completed" },
+		{ "events_skipped", "Events skipped by condition" },
+		{ "runs_queued", "Task runs queued" },
+		{ "runs_skipped", "Task runs skipped" },
+		{ "runs_replaced", "Task runs replaced" },
+		{ "executor_slices", "Executor slices" }
+	};
+
+	const MetricName s_gaugeNames[numGauges] =
+	{
+		{ "running_tasks", "Running tasks" }
+	};
+
+} // namespace
+
+void Record(HistogramID id, __int64 microseconds)
+{
+	s_histograms[id].Record(microseconds);
+}
+
+void Increment(CounterID id)
+{
+	s_counters[id].fetch_add(1, std::memory_order_relaxed);
+}
+
+void SetGauge(GaugeID id, __int64 value)
+{
+	Gauge& gauge = s_gauges[id];
+	gauge.value.store(value, std::memory_order_relaxed);
+
+	__int64 max = gauge.max.load(std::memory_order_relaxed);
+	while (value > max && !gauge.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+		;
+}
+
+__int64 NowMicroseconds()
+{
+	static const LONGLONG frequency = []
+	{
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		return f.QuadPart;
+	}();
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	// Split to avoid overflow of counter * 1000000.
+	return counter.QuadPart / frequency * 1000000 + counter.QuadPart % frequency * 1000000 / frequency;
+}
+
+std::string FormatText()
+{
+	std::string result;
+
+	for (int i = 0; i < numHistograms; ++i)
+	{
+		const Histogram::Snapshot snapshot = s_histograms[i].GetSnapshot();
+
+		if (snapshot.count == 0)
+		{
+			result += boost::str(boost::format("%1%: count=0\n") % s_histogramNames[i].label);
+			continue;
+		}
+
+		boost::format fmt("%1%: count=%2% mean=%3$.3f p50=%4$.3f p90=%5$.3f p99=%6$.3f max=%7$.3f (ms)\n");
+		fmt % s_histogramNames[i].label % snapshot.count % (snapshot.Mean() / 1000.0)
+			% (snapshot.Percentile(0.5) / 1000.0)
+			% (snapshot.Percentile(0.9) / 1000.0)
+			% (snapshot.Percentile(0.99) / 1000.0)
+			% (snapshot.max / 1000.0);
+
+		result += fmt.str();
+	}
+
+	for (int i = 0; i < numCounters; ++i)
+	{
+		result += boost::str(boost::format("%1%: %2%\n") %
+			s_counterNames[i].label % s_counters[i].load(std::memory_order_relaxed));
+	}
+
+	for (int i = 0; i < numGauges; ++i)
+	{
+		result += boost::str(boost::format("%1%: %2% (max %3%)\n") % s_gaugeNames[i].label %
+			s_gauges[i].value.load(std::memory_order_relaxed) % s_gauges[i].max.load(std::memory_order_relaxed));
+	}
+
+	return result;
+}
+
+std::string FormatJson()
+{
+	std::string result = "{\n\"histograms_us\": {";
+
+	for (int i = 0; i < numHistograms; ++i)
+	{
+		const Histogram::Snapshot snapshot = s_histograms[i].GetSnapshot();
+
+		boost::format fmt("%1%\n\"%2%\": {\"count\": %3%, \"mean\": %4$.1f, \"p50\": %5%, \"p90\": %6%, \"p99\": %7%, \"max\": %8%, \"buckets\": [");
+		fmt % (i != 0 ? "," : "") % s_histogramNames[i].key % snapshot.count % snapshot.Mean()
+			% snapshot.Percentile(0.5) % snapshot.Percentile(0.9) % snapshot.Percentile(0.99) % snapshot.max;
+
+		result += fmt.str();
+
+		// Non-empty buckets as [upper bound, count] pairs.
+		bool first = true;
+
+		for (int b = 0; b < numBuckets; ++b)
+		{
+			if (snapshot.buckets[b] == 0)
+				continue;
+
+			result += boost::str(boost::format("%1%[%2%, %3%]") % (first ? "" : ", ") % BucketUpperBound(b) % snapshot.buckets[b]);
+			first = false;
+		}
+
+		result += "]}";
+	}
+
+	result += "\n},\n\"counters\": {";
+
+	for (int i = 0; i < numCounters; ++i)
+	{
+		result += boost::str(boost::format("%1%\n\"%2%\": %3%") % (i != 0 ? "," : "") %
+			s_counterNames[i].key % s_counters[i].load(std::memory_order_relaxed));
+	}
+
+	result += "\n},\n\"gauges\": {";
+
+	for (int i = 0; i < numGauges; ++i)
+	{
+		result += boost::str(boost::format("%1%\n\"%2%\": {\"value\": %3%, \"max\": %4%}") % (i != 0 ? "," : "") %
+			s_gaugeNames[i].key % s_gauges[i].value.load(std::memory_order_relaxed) % s_gauges[i].max.load(std::memory_order_relaxed));
+	}
+
+	result += "\n}\n}\n";
+	return result;
+}
+
+void Reset()
+{
+	for (int i = 0; i < numHistograms; ++i)
+		s_histograms[i].Reset();
+
+	for (int i = 0; i < numCounters; ++i)
+		s_counters[i].store(0, std::memory_order_relaxed);
+
+	for (int i = 0; i < numGauges; ++i)
+		s_gauges[i].max.store(s_gauges[i].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+} // namespace Metrics
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+// Runtime statistics of the scheduler. Recording is lock-free and may be done from any thread.
+namespace Metrics
+{
+	// Durations in microseconds, kept in log-linear histograms.
+	enum HistogramID
+	{
+		histFireLateness = 0,      // Actual minus scheduled fire time of date/time events.
+		histMainThreadQueueDelay,  // Time AsyncCall callbacks wait for the main thread.
+		histActionDuration,
+		histActionListDuration,
+		histConfigLoad,
+		histConfigSave,
+		histScheduleUpdate,        // Computing the next date/time events and arming the timer.
+		histPlayerEventDispatch,   // Matching a player notification against player events.
+		histStepWaitLow,           // Time task steps wait in MainThreadExecutor, by TaskPriority.
+		histStepWaitNormal,
+		histStepWaitHigh,
+		histExecutorSlice,
+
+		numHistograms
+	};
+
+	enum CounterID
+	{
+		counterEventsFired = 0,
+		counterActionsRun,
+		counterActionListsCompleted,
+		counterEventsSkipped,      // Fired events whose condition was false.
+		counterRunsQueued,         // Task runs postponed by the queue policy.
+		counterRunsSkipped,        // Task runs dropped as the task was running or its queue was full.
+		counterRunsReplaced,       // Running tasks stopped by the restart policy.
+		counterExecutorSlices,
+
+		numCounters
+	};
+
+	// Gauges keep the current and the highest value.
+	enum GaugeID
+	{
+		gaugeExecSessions = 0,
+
+		numGauges
+	};
+
+	void Record(HistogramID id, __int64 microseconds);
+	void Increment(CounterID id);
+	void SetGauge(GaugeID id, __int64 value);
+
+	// Monotonic clock.
+	__int64 NowMicroseconds();
+
+	// Records the lifetime of the object.
+	class ScopedTimer : boost::noncopyable
+	{
+	public:
+		explicit ScopedTimer(HistogramID id) : m_id(id), m_startTime(NowMicroseconds()) {}
+
+		~ScopedTimer()
+		{
+			Record(m_id, NowMicroseconds() - m_startTime);
+		}
+
+	private:
+		HistogramID m_id;
+		__int64 m_startTime;
+	};
+
+	// Human readable report of all metrics.
+	std::string FormatText();
+
+	// All metrics including histogram buckets, stable keys allow to compare reports of different versions.
+	std::string FormatJson();
+
+	// Zeroes counters and histograms, gauge maximums restart from the current values.
+	void Reset();
+
+} // namespace Metrics
\ No newline at end of file
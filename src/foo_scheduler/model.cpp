@@ -3,9 +3,50 @@
 #include "s11n_blocks.h"
 #include "action_list_s11n_block.h"
 #include "event_s11n_block.h"
+#include "shared_variables_s11n_block.h"
+#include "exception_calendar_s11n_block.h"
+#include "date_time_event.h"
 #include "service_manager.h"
 
-Model::Model()
+ExceptionCalendarPtr ModelState::GetCalendarByGUID(const GUID& guid) const
+{
+	// There are few calendars, events are bound once per change.
+	for (std::size_t i = 0; i < calendars.size(); ++i)
+		if (calendars[i]->GetGUID() == guid)
+			return calendars[i];
+
+	return ExceptionCalendarPtr();
+}
+
+void ModelState::BindCalendar(Event& event) const
+{
+	DateTimeEvent* pEvent = dynamic_cast<DateTimeEvent*>(&event);
+
+	if (!pEvent || pEvent->GetCalendarMode() == DateTimeEvent::calendarNone)
+		return;
+
+	pEvent->SetCalendar(pEvent->GetCalendarMode(), GetCalendarByGUID(pEvent->GetCalendarGUID()));
+}
+
+std::vector<Event*> ModelState::BindCalendars()
+{
+	std::vector<Event*> result;
+
+	for (auto it = events.begin(); it != events.end(); ++it)
+	{
+		const DateTimeEvent* pEvent = dynamic_cast<const DateTimeEvent*>(&(*it));
+
+		if (!pEvent || pEvent->GetCalendarMode() == DateTimeEvent::calendarNone)
+			continue;
+
+		BindCalendar(*it);
+		result.push_back(&(*it));
+	}
+
+	return result;
+}
+
+Model::Model() : m_pEncodingContext(new S11nBlocks::EncodingContext), m_numDroppedCacheEntries(0)
 {
 }
 
@@ -16,20 +57,53 @@ struct ModelS11nBlock : public S11nBlocks::Block<ModelS11nBlock>
 	S11nBlocks::RepeatedField<ActionListS11nBlock, 2> actionLists;
 	S11nBlocks::RepeatedField<int, 3> eventWindowColumnsWidths;
 	S11nBlocks::Field<bool, 4> schedulerEnabled;
+	S11nBlocks::Field<SharedVariablesS11nBlock, 5> sharedVariables;
+	S11nBlocks::Field<pfc::string8, 6> lastRunTime; // Local time, only read from older configurations.
+	S11nBlocks::RepeatedField<ExceptionCalendarS11nBlock, 7> calendars;
+	S11nBlocks::Field<pfc::string8, 8> lastRunTimeUTC;
 
 	template<class Archive>
 	void RegisterFields(Archive& ar)
 	{
-		ar.RegisterFields(events)(actionLists)(eventWindowColumnsWidths)(schedulerEnabled);
+		ar.RegisterFields(events)(actionLists)(eventWindowColumnsWidths)(schedulerEnabled)(sharedVariables)
+			(lastRunTime)(calendars)(lastRunTimeUTC);
 	}
 };
 
-void Model::Load(foobar_stream_reader& stream)
+// Same layout as ModelS11nBlock, but events and action lists are written from their cached serialized form.
+struct ModelSaveS11nBlock : public S11nBlocks::Block<ModelSaveS11nBlock>
 {
+	S11nBlocks::RepeatedField<S11nBlocks::SerializedBlock, 1> events;
+	S11nBlocks::RepeatedField<S11nBlocks::SerializedBlock, 2> actionLists;
+	S11nBlocks::RepeatedField<int, 3> eventWindowColumnsWidths;
+	S11nBlocks::Field<bool, 4> schedulerEnabled;
+	S11nBlocks::Field<SharedVariablesS11nBlock, 5> sharedVariables;
+	S11nBlocks::Field<pfc::string8, 6> lastRunTime; // Local time, only read from older configurations.
+	S11nBlocks::RepeatedField<ExceptionCalendarS11nBlock, 7> calendars;
+	S11nBlocks::Field<pfc::string8, 8> lastRunTimeUTC;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(events)(actionLists)(eventWindowColumnsWidths)(schedulerEnabled)(sharedVariables)
+			(lastRunTime)(calendars)(lastRunTimeUTC);
+	}
+};
+
+void Model::Load(foobar_stream_reader& stream, bool compactEncoding)
+{
+	ClearCache();
+
 	ModelS11nBlock block;
 
+	// Actions of the action lists stay serialized until they are needed and refer to these tables,
+	// so the loaded tables become the ones the next Save extends.
 	try
 	{
+		if (compactEncoding)
+			m_pEncodingContext->ReadTables(stream);
+
+		S11nBlocks::EncodingScope scope(compactEncoding ? m_pEncodingContext.get() : 0);
 		block.ParseFromStream(stream);
 	}
 	catch (S11nBlocks::Exception&)
@@ -73,29 +147,96 @@ void Model::Load(foobar_stream_reader& stream)
 			m_eventsWindowColumnsWidths.push_back(block.eventWindowColumnsWidths.GetAt(i));
 	}
 
+	if (block.calendars.Exists())
+	{
+		for (int i = 0; i < block.calendars.GetSize(); ++i)
+		{
+			boost::shared_ptr<ExceptionCalendar> pCalendar(new ExceptionCalendar);
+			pCalendar->LoadFromS11nBlock(block.calendars.GetAt(i));
+			m_modelState.calendars.push_back(pCalendar);
+		}
+	}
+
+	m_modelState.BindCalendars();
+
 	block.schedulerEnabled.GetValueIfExists(m_modelState.schedulerEnabled);
+
+	RebuildIndexes();
+
+	if (block.sharedVariables.Exists())
+		ServiceManager::Instance().GetSharedVariables().LoadFromS11nBlock(block.sharedVariables.GetValue());
+
+	if (block.lastRunTimeUTC.Exists())
+	{
+		try
+		{
+			ServiceManager::Instance().GetDateTimeEventsManager().SetLastRunTime(
+				boost::posix_time::from_iso_string(block.lastRunTimeUTC.GetValue().get_ptr()));
+		}
+		catch (const std::exception&)
+		{
+		}
+	}
+	else if (block.lastRunTime.Exists())
+	{
+		try
+		{
+			ServiceManager::Instance().GetDateTimeEventsManager().SetLastRunTime(
+				ServiceManager::Instance().GetTimersManager().LocalToUTC(
+					boost::posix_time::from_iso_string(block.lastRunTime.GetValue().get_ptr())));
+		}
+		catch (const std::exception&)
+		{
+		}
+	}
 }
 
 
 void Model::Save(foobar_stream_writer& stream) const
 {
-	ModelS11nBlock block;
+	S11nBlocks::EncodingScope scope(m_pEncodingContext.get());
+	ModelSaveS11nBlock block;
 
 	for (std::size_t i = 0; i < m_modelState.events.size(); ++i)
 	{
-		EventS11nBlock eventBlock;
-		eventBlock.eventGUID.SetValue(m_modelState.events[i].GetEventGUID());
-		eventBlock.protoGUID.SetValue(m_modelState.events[i].GetPrototypeGUID());
+		const Event& event = m_modelState.events[i];
+		S11nBlocks::SerializedBlock& serializedEvent = m_eventsCache[event.GetEventGUID()];
+
+		if (serializedEvent.IsEmpty())
+		{
+			try
+			{
+				serializedEvent = SerializeEvent(event);
+			}
+			catch (S11nBlocks::Exception&)
+			{
+				m_eventsCache.erase(event.GetEventGUID());
+				continue;
+			}
+		}
 
-		m_modelState.events[i].Save(eventBlock);
-		block.events.Add(eventBlock);
+		block.events.Add(serializedEvent);
 	}
 
 	for (std::size_t i = 0; i < m_modelState.actionLists.size(); ++i)
 	{
-		ActionListS11nBlock alBlock;
-		m_modelState.actionLists[i].SaveToS11nBlock(alBlock);
-		block.actionLists.Add(alBlock);
+		const ActionList& actionList = m_modelState.actionLists[i];
+		S11nBlocks::SerializedBlock& serializedActionList = m_actionListsCache[actionList.GetGUID()];
+
+		if (serializedActionList.IsEmpty())
+		{
+			try
+			{
+				serializedActionList = SerializeActionList(actionList);
+			}
+			catch (S11nBlocks::Exception&)
+			{
+				m_actionListsCache.erase(actionList.GetGUID());
+				continue;
+			}
+		}
+
+		block.actionLists.Add(serializedActionList);
 	}
 
 	for (std::size_t i = 0; i < m_eventsWindowColumnsWidths.size(); ++i)
@@ -103,14 +244,38 @@ void Model::Save(foobar_stream_writer& stream) const
 
 	block.schedulerEnabled.SetValue(m_modelState.schedulerEnabled);
 
+	for (std::size_t i = 0; i < m_modelState.calendars.size(); ++i)
+	{
+		ExceptionCalendarS11nBlock calendarBlock;
+		m_modelState.calendars[i]->SaveToS11nBlock(calendarBlock);
+		block.calendars.Add(calendarBlock);
+	}
+
+	SharedVariablesS11nBlock sharedVariablesBlock;
+	ServiceManager::Instance().GetSharedVariables().SaveToS11nBlock(sharedVariablesBlock);
+
+	if (sharedVariablesBlock.variables.Exists())
+		block.sharedVariables.SetValue(sharedVariablesBlock);
+
+	// Date/time events are processed up to now, what's scheduled after this may be missed.
+	// In UTC, a local time is ambiguous when clocks go back and wrong when the time zone changes.
+	block.lastRunTimeUTC.SetValue(
+		boost::posix_time::to_iso_string(boost::posix_time::second_clock::universal_time()).c_str());
+
+	// The tables are complete only after the block has been serialized.
+	foobar_stream_buffer_writer bufferStream;
+
 	try
 	{
-		block.SerializeToStream(stream);
+		block.SerializeToStream(bufferStream);
 	}
 	catch (S11nBlocks::Exception&)
 	{
-
+		return;
 	}
+
+	m_pEncodingContext->WriteTables(stream);
+	stream.write_raw(bufferStream.m_buffer.get_ptr(), bufferStream.m_buffer.get_size());
 }
 
 std::vector<Event*> Model::GetEvents()
@@ -122,6 +287,7 @@ std::vector<Event*> Model::GetEvents()
 
 void Model::UpdateEvent(Event* pEvent)
 {
+	InvalidateCache(pEvent->GetEventGUID());
 	m_eventUpdatedSignal(pEvent);
 }
 
@@ -142,6 +308,9 @@ void Model::RemoveEvent(Event* pEvent)
 	auto it = std::find_if(m_modelState.events.begin(), m_modelState.events.end(), &boost::lambda::_1 == pEvent);
 	_ASSERTE(it != m_modelState.events.end());
 
+	InvalidateCache(pEvent->GetEventGUID());
+	m_eventsIndex.erase(pEvent->GetEventGUID());
+
 	ModelState::EventsContainer::auto_type pReleasedEvent = m_modelState.events.release(it);
 	m_eventRemovedSignal(pReleasedEvent.get());
 }
@@ -153,13 +322,34 @@ boost::signals2::connection Model::ConnectEventRemovedSlot(const EventRemovedSig
 
 ActionList* Model::GetActionListByGUID(const GUID& guid)
 {
-	auto it = std::find_if(m_modelState.actionLists.begin(), m_modelState.actionLists.end(),
-		boost::bind(&ActionList::GetGUID, _1) == guid);
+	auto it = m_actionListsIndex.find(guid);
+	return it != m_actionListsIndex.end() ? it->second : 0;
+}
+
+boost::shared_ptr<const ActionList> Model::GetActionListSnapshot(const GUID& guid) const
+{
+	boost::shared_ptr<const ActionList>& pSnapshot = m_actionListSnapshots[guid];
+
+	if (!pSnapshot)
+	{
+		auto it = m_actionListsIndex.find(guid);
 
-	if (it == m_modelState.actionLists.end())
-		return 0;
+		if (it == m_actionListsIndex.end())
+		{
+			m_actionListSnapshots.erase(guid);
+			return boost::shared_ptr<const ActionList>();
+		}
 
-	return &(*it);
+		pSnapshot.reset(it->second->Clone());
+	}
+
+	return pSnapshot;
+}
+
+Event* Model::GetEventByGUID(const GUID& guid)
+{
+	auto it = m_eventsIndex.find(guid);
+	return it != m_eventsIndex.end() ? it->second : 0;
 }
 
 const ModelState& Model::GetState() const
@@ -170,6 +360,13 @@ const ModelState& Model::GetState() const
 void Model::SetState(const ModelState& state)
 {
 	m_modelState = state;
+
+	// Events added in the preferences may refer to calendars they weren't bound to.
+	m_modelState.BindCalendars();
+
+	RebuildIndexes();
+	UpdateCache();
+
 	m_modelStateChanged();
 }
 
@@ -192,3 +389,127 @@ bool Model::IsSchedulerEnabled() const
 {
 	return m_modelState.schedulerEnabled;
 }
+
+
+S11nBlocks::SerializedBlock Model::SerializeEvent(const Event& event)
+{
+	EventS11nBlock eventBlock;
+	eventBlock.eventGUID.SetValue(event.GetEventGUID());
+	eventBlock.protoGUID.SetValue(event.GetPrototypeGUID());
+
+	event.Save(eventBlock);
+
+	return S11nBlocks::SerializedBlock::FromBlock(eventBlock);
+}
+
+S11nBlocks::SerializedBlock Model::SerializeActionList(const ActionList& actionList)
+{
+	ActionListS11nBlock alBlock;
+	actionList.SaveToS11nBlock(alBlock);
+
+	return S11nBlocks::SerializedBlock::FromBlock(alBlock);
+}
+
+void Model::InvalidateCache(const GUID& guid)
+{
+	m_numDroppedCacheEntries += m_eventsCache.erase(guid) + m_actionListsCache.erase(guid);
+	m_actionListSnapshots.erase(guid);
+}
+
+void Model::ClearCache()
+{
+	m_eventsCache.clear();
+	m_actionListsCache.clear();
+	m_actionListSnapshots.clear();
+	m_pEncodingContext.reset(new S11nBlocks::EncodingContext);
+	m_numDroppedCacheEntries = 0;
+}
+
+void Model::UpdateCache()
+{
+	std::vector<GUID> droppedGUIDs;
+
+	// A snapshot can be compared through the cached block of its action list only.
+	for (auto it = m_actionListSnapshots.begin(); it != m_actionListSnapshots.end(); ++it)
+		if (m_actionListsCache.find(it->first) == m_actionListsCache.end())
+			droppedGUIDs.push_back(it->first);
+
+	// An object that is still there is serialized with the current tables and compared with its cached block,
+	// an unchanged one interns no new strings. A changed one keeps the new block for the next Save.
+	S11nBlocks::EncodingScope scope(m_pEncodingContext.get());
+
+	for (auto it = m_eventsCache.begin(); it != m_eventsCache.end(); ++it)
+	{
+		auto itEvent = m_eventsIndex.find(it->first);
+
+		if (itEvent == m_eventsIndex.end())
+		{
+			droppedGUIDs.push_back(it->first);
+			continue;
+		}
+
+		try
+		{
+			S11nBlocks::SerializedBlock serializedEvent = SerializeEvent(*itEvent->second);
+
+			if (!serializedEvent.IsSameAs(it->second))
+			{
+				it->second = serializedEvent;
+				++m_numDroppedCacheEntries;
+			}
+		}
+		catch (S11nBlocks::Exception&)
+		{
+			droppedGUIDs.push_back(it->first);
+		}
+	}
+
+	for (auto it = m_actionListsCache.begin(); it != m_actionListsCache.end(); ++it)
+	{
+		auto itActionList = m_actionListsIndex.find(it->first);
+
+		if (itActionList == m_actionListsIndex.end())
+		{
+			droppedGUIDs.push_back(it->first);
+			continue;
+		}
+
+		try
+		{
+			S11nBlocks::SerializedBlock serializedActionList = SerializeActionList(*itActionList->second);
+
+			if (!serializedActionList.IsSameAs(it->second))
+			{
+				it->second = serializedActionList;
+				m_actionListSnapshots.erase(it->first);
+				++m_numDroppedCacheEntries;
+			}
+		}
+		catch (S11nBlocks::Exception&)
+		{
+			droppedGUIDs.push_back(it->first);
+		}
+	}
+
+	for (std::size_t i = 0; i < droppedGUIDs.size(); ++i)
+		InvalidateCache(droppedGUIDs[i]);
+
+	// Each full serialization is paid for by as many dropped blocks.
+	if (m_numDroppedCacheEntries > m_eventsCache.size() + m_actionListsCache.size())
+		ClearCache();
+}
+
+void Model::RebuildIndexes()
+{
+	m_eventsIndex.clear();
+	m_eventsIndex.reserve(m_modelState.events.size());
+
+	for (auto it = m_modelState.events.begin(); it != m_modelState.events.end(); ++it)
+		m_eventsIndex[it->GetEventGUID()] = &(*it);
+
+	m_actionListsIndex.clear();
+	m_actionListsIndex.reserve(m_modelState.actionLists.size());
+
+	for (auto it = m_modelState.actionLists.begin(); it != m_modelState.actionLists.end(); ++it)
+		m_actionListsIndex[it->GetGUID()] = &(*it);
+}
\ No newline at end of file
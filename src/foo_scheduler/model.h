@@ -4,11 +4,15 @@
 #include "action.h"
 #include "action_list.h"
 #include "foobar_stream.h"
+#include "s11n_blocks.h"
+#include "guid_helpers.h"
+#include "exception_calendar.h"
 
 struct ModelState
 {
 	typedef boost::ptr_vector<Event> EventsContainer;
 	typedef boost::ptr_vector<ActionList> ActionListsContainer;
+	typedef std::vector<ExceptionCalendarPtr> CalendarsContainer;
 
 	ModelState() : schedulerEnabled(true) {}
 
@@ -17,11 +21,24 @@ struct ModelState
 		schedulerEnabled = true;
 		events.clear();
 		actionLists.clear();
+		calendars.clear();
 	}
 
+	// Null if there is no such calendar.
+	ExceptionCalendarPtr GetCalendarByGUID(const GUID& guid) const;
+
+	// Points a date/time event to the calendar it refers to by GUID, an event whose calendar is gone stops using it.
+	void BindCalendar(Event& event) const;
+
+	// Binds all events, returns the ones that referred to a calendar.
+	std::vector<Event*> BindCalendars();
+
 	bool schedulerEnabled;
 	EventsContainer events;
 	ActionListsContainer actionLists;
+
+	// Shared by the events using them, calendars are replaced rather than changed.
+	CalendarsContainer calendars;
 };
 
 class Model : boost::noncopyable
@@ -29,13 +46,21 @@ class Model : boost::noncopyable
 public:
 	Model();
 
-	void Load(foobar_stream_reader& stream);
+	// compactEncoding is false for configurations written before version 4.22.
+	void Load(foobar_stream_reader& stream, bool compactEncoding);
+
+	// Writes the compact encoding: the string and GUID tables followed by the model block.
 	void Save(foobar_stream_writer& stream) const;
 
 	std::vector<Event*> GetEvents();
 	std::vector<ActionList*> GetActionLists();
 
 	ActionList* GetActionListByGUID(const GUID& guid);
+	Event* GetEventByGUID(const GUID& guid);
+
+	// Returns an immutable copy of the action list for running it, or a null pointer.
+	// The copy is made once and shared by all runs until the model state changes.
+	boost::shared_ptr<const ActionList> GetActionListSnapshot(const GUID& guid) const;
 
 	void UpdateEvent(Event* pEvent);
 	void RemoveEvent(Event* pEvent);
@@ -59,9 +84,42 @@ public:
 	boost::signals2::connection ConnectEventRemovedSlot(const EventRemovedSignal::slot_type& slot);
 	boost::signals2::connection ConnectModelStateChangedSlot(const ModelStateChanged::slot_type& slot);
 
+private:
+	typedef std::map<GUID, S11nBlocks::SerializedBlock, GUIDHelpers::Less> SerializedBlocksCache;
+
+	// Throw S11nBlocks::Exception.
+	static S11nBlocks::SerializedBlock SerializeEvent(const Event& event);
+	static S11nBlocks::SerializedBlock SerializeActionList(const ActionList& actionList);
+
+	void InvalidateCache(const GUID& guid);
+	void ClearCache();
+
+	// Keeps the entries of the objects of a new model state that haven't changed.
+	void UpdateCache();
+
+	void RebuildIndexes();
+
 private:
 	ModelState m_modelState;
 
+	// Events and action lists of m_modelState by GUID.
+	GUIDHelpers::Index<Event>::Type m_eventsIndex;
+	GUIDHelpers::Index<ActionList>::Type m_actionListsIndex;
+
+	// Events and action lists serialized by the previous Save, keyed by GUID.
+	// An entry is dropped when its object changes, so Save only serializes what has changed since.
+	mutable SerializedBlocksCache m_eventsCache;
+	mutable SerializedBlocksCache m_actionListsCache;
+
+	// Tables the cached blocks and not yet loaded actions refer to. Replaced together with the cache
+	// once more entries were dropped or replaced than are cached, so strings of removed and changed objects
+	// don't pile up.
+	// Blocks still referring to the previous tables keep them alive and are encoded again on Save.
+	boost::shared_ptr<S11nBlocks::EncodingContext> m_pEncodingContext;
+	std::size_t m_numDroppedCacheEntries;
+
+	mutable std::unordered_map<GUID, boost::shared_ptr<const ActionList>, GUIDHelpers::Hash> m_actionListSnapshots;
+
 	std::vector<int> m_eventsWindowColumnsWidths;
 
 	EventUpdatedSignal m_eventUpdatedSignal;
@@ -53,9 +53,14 @@
 #include <atlctrlx.h>
 #include <atldlgs.h>
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <thread>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/any.hpp>
@@ -76,3 +81,4 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/signals2.hpp>
 #include <boost/type_traits.hpp>
+#include <boost/variant.hpp>
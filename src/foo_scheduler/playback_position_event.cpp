@@ -0,0 +1,236 @@
+#include "pch.h"
+#include "playback_position_event.h"
+#include "service_manager.h"
+#include "combo_helpers.h"
+
+//------------------------------------------------------------------------------
+// PlaybackPositionEvent
+//------------------------------------------------------------------------------
+
+PlaybackPositionEvent::PlaybackPositionEvent() : m_anchor(anchorTrackStart), m_offsetMs(0)
+{
+}
+
+PlaybackPositionEvent::PlaybackPositionEvent(const PlaybackPositionEvent& rhs) : Event(rhs),
+	m_anchor(rhs.m_anchor), m_offsetMs(rhs.m_offsetMs)
+{
+}
+
+GUID PlaybackPositionEvent::GetPrototypeGUID() const
+{
+	// {ce6505da-ecee-40c4-97f8-88e7240d244e} mod guid
+	static const GUID result = 
+	{ 0xce6505da, 0xecee, 0x40c4, { 0x97, 0xf8, 0x88, 0xe7, 0x24, 0x0d, 0x24, 0x4e } };
+
+	return result;
+}
+
+int PlaybackPositionEvent::GetPriority() const
+{
+	return 15;
+}
+
+std::wstring PlaybackPositionEvent::GetName() const
+{
+	return L"playback position event";
+}
+
+std::wstring PlaybackPositionEvent::GetDescription() const
+{
+	if (m_anchor == anchorTrackEnd)
+		return boost::str(boost::wformat(L"At %1% before the end of track") % FormatOffset(m_offsetMs));
+
+	return boost::str(boost::wformat(L"At %1% into track") % FormatOffset(m_offsetMs));
+}
+
+bool PlaybackPositionEvent::ShowConfigDialog(CWindow parent, PrefPageModel* /*pPrefPageModel*/)
+{
+	PlaybackPositionEventEditor dlg(this);
+	return dlg.DoModal(parent) == IDOK;
+}
+
+void PlaybackPositionEvent::OnSignal()
+{
+}
+
+std::unique_ptr<Event> PlaybackPositionEvent::Clone() const
+{
+	return std::unique_ptr<Event>(new PlaybackPositionEvent(*this));
+}
+
+std::unique_ptr<Event> PlaybackPositionEvent::CreateFromPrototype() const
+{
+	std::unique_ptr<Event> pClone(new PlaybackPositionEvent(*this));
+	pClone->NewEventGUID();
+	return pClone;
+}
+
+void PlaybackPositionEvent::LoadFromS11nBlock(const EventS11nBlock& block)
+{
+	if (!block.positionEvent.Exists())
+		return;
+
+	const PlaybackPositionEventS11nBlock& b = block.positionEvent.GetValue();
+
+	if (b.anchor.Exists())
+		m_anchor = b.anchor.GetValue() == anchorTrackEnd ? anchorTrackEnd : anchorTrackStart;
+
+	b.offsetMs.GetValueIfExists(m_offsetMs);
+	m_offsetMs = std::max(m_offsetMs, 0);
+}
+
+void PlaybackPositionEvent::SaveToS11nBlock(EventS11nBlock& block) const
+{
+	PlaybackPositionEventS11nBlock b;
+
+	b.anchor.SetValue(m_anchor);
+	b.offsetMs.SetValue(m_offsetMs);
+
+	block.positionEvent.SetValue(b);
+}
+
+void PlaybackPositionEvent::ApplyVisitor(IEventVisitor& visitor)
+{
+	visitor.Visit(*this);
+}
+
+PlaybackPositionEvent::EAnchor PlaybackPositionEvent::GetAnchor() const
+{
+	return m_anchor;
+}
+
+void PlaybackPositionEvent::SetAnchor(EAnchor anchor)
+{
+	m_anchor = anchor;
+}
+
+int PlaybackPositionEvent::GetOffsetMs() const
+{
+	return m_offsetMs;
+}
+
+void PlaybackPositionEvent::SetOffsetMs(int offsetMs)
+{
+	m_offsetMs = offsetMs;
+}
+
+double PlaybackPositionEvent::GetPosition(double trackLength) const
+{
+	const double offset = m_offsetMs / 1000.0;
+
+	if (m_anchor == anchorTrackStart)
+		return trackLength <= 0 || offset < trackLength ? offset : -1;
+
+	// Streams and tracks of unknown length have no end.
+	if (trackLength <= 0 || offset > trackLength)
+		return -1;
+
+	return trackLength - offset;
+}
+
+std::wstring PlaybackPositionEvent::FormatOffset(int offsetMs)
+{
+	const int hours = offsetMs / 3600000;
+	const int minutes = offsetMs / 60000 % 60;
+	const int seconds = offsetMs / 1000 % 60;
+	const int ms = offsetMs % 1000;
+
+	std::wstring result = hours > 0 ?
+		boost::str(boost::wformat(L"%1%:%2$02d:%3$02d") % hours % minutes % seconds) :
+		boost::str(boost::wformat(L"%1%:%2$02d") % minutes % seconds);
+
+	if (ms != 0)
+		result += boost::str(boost::wformat(L".%1$03d") % ms);
+
+	return result;
+}
+
+bool PlaybackPositionEvent::ParseOffset(const std::wstring& text, int& offsetMs)
+{
+	std::vector<std::wstring> parts;
+	boost::split(parts, boost::trim_copy(text), boost::is_any_of(L":"));
+
+	if (parts.empty() || parts.size() > 3)
+		return false;
+
+	double seconds = 0;
+
+	for (std::size_t i = 0; i < parts.size(); ++i)
+	{
+		const bool last = i == parts.size() - 1;
+
+		if (parts[i].empty())
+			return false;
+
+		// Only the seconds may have a fraction.
+		wchar_t* end = 0;
+		const double value = last ? wcstod(parts[i].c_str(), &end) : wcstoul(parts[i].c_str(), &end, 10);
+
+		if (*end != L'\0' || !iswdigit(parts[i][0]) || (i > 0 && value >= 60))
+			return false;
+
+		seconds = seconds * 60 + value;
+	}
+
+	// Up to 24 hours.
+	if (seconds > 24 * 3600)
+		return false;
+
+	offsetMs = static_cast<int>(seconds * 1000 + 0.5);
+	return true;
+}
+
+namespace
+{
+	const bool registered = ServiceManager::Instance().GetEventPrototypesManager().RegisterPrototype(
+		new PlaybackPositionEvent);
+}
+
+//------------------------------------------------------------------------------
+// PlaybackPositionEventEditor
+//------------------------------------------------------------------------------
+
+PlaybackPositionEventEditor::PlaybackPositionEventEditor(PlaybackPositionEvent* pEvent) : m_pEvent(pEvent)
+{
+}
+
+BOOL PlaybackPositionEventEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
+{
+	m_anchor = GetDlgItem(IDC_COMBO_POSITION_ANCHOR);
+
+	std::vector<std::pair<std::wstring, int>> anchorItems;
+	anchorItems.push_back(std::make_pair(L"into the track", PlaybackPositionEvent::anchorTrackStart));
+	anchorItems.push_back(std::make_pair(L"before the end of the track", PlaybackPositionEvent::anchorTrackEnd));
+
+	ComboHelpers::InitCombo(m_anchor, anchorItems, m_pEvent->GetAnchor());
+
+	SetDlgItemText(IDC_EDIT_POSITION, PlaybackPositionEvent::FormatOffset(m_pEvent->GetOffsetMs()).c_str());
+
+	CenterWindow(GetParent());
+
+	// dark mode
+	m_dark.AddDialogWithControls(m_hWnd);
+
+	return TRUE;
+}
+
+void PlaybackPositionEventEditor::OnClose(UINT uNotifyCode, int nID, CWindow wndCtl)
+{
+	if (nID == IDOK)
+	{
+		CString text;
+		GetDlgItemText(IDC_EDIT_POSITION, text);
+
+		int offsetMs = 0;
+		if (!PlaybackPositionEvent::ParseOffset(text.GetString(), offsetMs))
+		{
+			m_popupTooltipMsg.Show(L"Enter the position as m:ss.", GetDlgItem(IDC_EDIT_POSITION));
+			return;
+		}
+
+		m_pEvent->SetAnchor(ComboHelpers::GetSelectedItem<PlaybackPositionEvent::EAnchor>(m_anchor));
+		m_pEvent->SetOffsetMs(offsetMs);
+	}
+
+	EndDialog(nID);
+}
\ No newline at end of file
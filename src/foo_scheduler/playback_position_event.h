@@ -0,0 +1,88 @@
+#pragma once
+
+#include "resource.h"
+#include "event.h"
+#include "playback_position_event_s11n_block.h"
+#include "popup_tooltip_message.h"
+
+//------------------------------------------------------------------------------
+// PlaybackPositionEvent
+//------------------------------------------------------------------------------
+
+// Fires when playback of every track reaches the position.
+class PlaybackPositionEvent : public Event
+{
+public: // Event
+	GUID GetPrototypeGUID() const override;
+	int GetPriority() const override;
+	std::wstring GetName() const override;
+	std::wstring GetDescription() const override;
+	bool ShowConfigDialog(CWindow parent, class PrefPageModel* pPrefPageModel) override;
+	void OnSignal() override;
+	std::unique_ptr<Event> Clone() const override;
+	std::unique_ptr<Event> CreateFromPrototype() const override;
+	void LoadFromS11nBlock(const EventS11nBlock& block) override;
+	void SaveToS11nBlock(EventS11nBlock& block) const override;
+	void ApplyVisitor(IEventVisitor& visitor) override;
+
+public:
+	PlaybackPositionEvent();
+
+	enum EAnchor
+	{
+		anchorTrackStart = 0,
+		anchorTrackEnd
+	};
+
+	EAnchor GetAnchor() const;
+	void SetAnchor(EAnchor anchor);
+
+	// Offset from the anchor.
+	int GetOffsetMs() const;
+	void SetOffsetMs(int offsetMs);
+
+	// Position in a track of the given length, or a negative value
+	// if the event doesn't fire in this track.
+	double GetPosition(double trackLength) const;
+
+	// Formats and parses offsets as [h:]m:ss[.fff].
+	static std::wstring FormatOffset(int offsetMs);
+	static bool ParseOffset(const std::wstring& text, int& offsetMs);
+
+private:
+	PlaybackPositionEvent(const PlaybackPositionEvent& rhs);
+
+private:
+	EAnchor m_anchor;
+	int m_offsetMs;
+};
+
+//------------------------------------------------------------------------------
+// PlaybackPositionEventEditor
+//------------------------------------------------------------------------------
+
+class PlaybackPositionEventEditor : public CDialogImpl<PlaybackPositionEventEditor>
+{
+public:
+	enum { IDD = IDD_POSITION_EVENT_CONFIG };
+
+	explicit PlaybackPositionEventEditor(PlaybackPositionEvent* pEvent);
+
+private:
+	BEGIN_MSG_MAP(PlaybackPositionEventEditor)
+		MSG_WM_INITDIALOG(OnInitDialog)
+		COMMAND_ID_HANDLER_EX(IDOK, OnClose)
+		COMMAND_ID_HANDLER_EX(IDCANCEL, OnClose)
+	END_MSG_MAP()
+
+	BOOL OnInitDialog(CWindow wndFocus, LPARAM lInitParam);
+	void OnClose(UINT uNotifyCode, int nID, CWindow wndCtl);
+
+private:
+	PlaybackPositionEvent* m_pEvent;
+
+	CComboBox m_anchor;
+
+	PopupTooltipMessage m_popupTooltipMsg;
+	fb2k::CDarkModeHooks m_dark;
+};
\ No newline at end of file
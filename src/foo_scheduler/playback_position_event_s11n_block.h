@@ -0,0 +1,15 @@
+#pragma once
+
+#include "s11n_blocks.h"
+
+struct PlaybackPositionEventS11nBlock : public S11nBlocks::Block<PlaybackPositionEventS11nBlock>
+{
+	S11nBlocks::Field<int, 1> anchor;
+	S11nBlocks::Field<int, 2> offsetMs;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(anchor)(offsetMs);
+	}
+};
\ No newline at end of file
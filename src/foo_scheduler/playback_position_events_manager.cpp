@@ -0,0 +1,182 @@
+#include "pch.h"
+#include "playback_position_events_manager.h"
+#include "service_manager.h"
+#include "metrics.h"
+#include "tracer.h"
+
+namespace
+{
+	// Timers may fire a bit early, events this close to the position are due.
+	const double positionTolerance = 0.05;
+}
+
+PlaybackPositionEventsManager::PlaybackPositionEventsManager(Model& model) :
+	m_nextEntry(0), m_timerID(TimersManager::invalidTimerID)
+{
+	model.ConnectModelStateChangedSlot(
+		boost::bind(&PlaybackPositionEventsManager::Reset, this));
+}
+
+void PlaybackPositionEventsManager::Reset()
+{
+	static_api_ptr_t<play_callback_manager>()->unregister_callback(this);
+
+	StopTimer();
+	m_timeline.clear();
+	m_nextEntry = 0;
+
+	if (!ServiceManager::Instance().GetModel().IsSchedulerEnabled())
+		return;
+
+	static_api_ptr_t<play_callback_manager>()->register_callback(this,
+		flag_on_playback_stop | flag_on_playback_pause | flag_on_playback_new_track | flag_on_playback_seek, false);
+
+	// Events of the current track are scheduled from the current position.
+	static_api_ptr_t<playback_control> pc;
+	metadb_handle_ptr track;
+
+	if (pc->get_now_playing(track))
+	{
+		BuildTimeline(track);
+
+		if (!pc->is_paused())
+			ArmTimer(pc->playback_get_position());
+	}
+}
+
+void PlaybackPositionEventsManager::Shutdown()
+{
+	static_api_ptr_t<play_callback_manager>()->unregister_callback(this);
+
+	StopTimer();
+	m_timeline.clear();
+}
+
+void PlaybackPositionEventsManager::BuildTimeline(const metadb_handle_ptr& track)
+{
+	m_timeline.clear();
+	m_nextEntry = 0;
+
+	const double trackLength = track.is_valid() ? track->get_length() : 0;
+
+	const std::vector<Event*> events = ServiceManager::Instance().GetModel().GetEvents();
+	for (auto it = events.begin(); it != events.end(); ++it)
+	{
+		if (PlaybackPositionEvent* pEvent = dynamic_cast<PlaybackPositionEvent*>(*it))
+		{
+			if (!pEvent->IsEnabled())
+				continue;
+
+			const double position = pEvent->GetPosition(trackLength);
+
+			if (position < 0)
+				continue;
+
+			TimelineEntry entry = { position, pEvent };
+			m_timeline.push_back(entry);
+		}
+	}
+
+	// Stable to fire events at the same position in the order of the list.
+	std::stable_sort(m_timeline.begin(), m_timeline.end());
+}
+
+void PlaybackPositionEventsManager::ArmTimer(double position)
+{
+	TimelineEntry key = { position - positionTolerance, 0 };
+	m_nextEntry = std::lower_bound(m_timeline.begin(), m_timeline.end(), key) - m_timeline.begin();
+
+	ArmNextEntryTimer(position);
+}
+
+void PlaybackPositionEventsManager::ArmNextEntryTimer(double position)
+{
+	StopTimer();
+
+	if (m_nextEntry == m_timeline.size())
+		return;
+
+	const double delay = std::max(m_timeline[m_nextEntry].position - position, 0.0);
+
+	m_onTimerEventProxy.reset(
+		new MethodCallProxy(boost::bind(&PlaybackPositionEventsManager::OnTimerEvent, this, _1)));
+
+	m_timerID = ServiceManager::Instance().GetTimersManager().CreateTimer(
+		boost::posix_time::microseconds(static_cast<__int64>(delay * 1000000)),
+		boost::posix_time::not_a_date_time, false);
+
+	AsyncCall::CallbackPtr pTimerCallback =
+		AsyncCall::MakeCallback<MethodCallProxy>(m_onTimerEventProxy,
+			boost::bind(&MethodCallProxy::OnTimerEvent, m_onTimerEventProxy.get(), m_timerID));
+
+	ServiceManager::Instance().GetTimersManager().StartTimer(m_timerID, pTimerCallback);
+}
+
+void PlaybackPositionEventsManager::StopTimer()
+{
+	// Pending callbacks in the message loop will not be executed.
+	m_onTimerEventProxy.reset();
+
+	if (m_timerID != TimersManager::invalidTimerID)
+	{
+		ServiceManager::Instance().GetTimersManager().CloseTimer(m_timerID);
+		m_timerID = TimersManager::invalidTimerID;
+	}
+}
+
+void PlaybackPositionEventsManager::OnTimerEvent(TimersManager::TimerID timerID)
+{
+	_ASSERTE(m_timerID == timerID);
+
+	Tracer::ScopedSpan span("timer", "Playback position event");
+
+	ServiceManager::Instance().GetTimersManager().CloseTimer(m_timerID);
+	m_timerID = TimersManager::invalidTimerID;
+
+	const double position = static_api_ptr_t<playback_control>()->playback_get_position();
+
+	std::vector<Event*> dueEvents;
+
+	while (m_nextEntry < m_timeline.size() && m_timeline[m_nextEntry].position <= position + positionTolerance)
+		dueEvents.push_back(m_timeline[m_nextEntry++].pEvent);
+
+	// The next timer is armed first, as actions may stop or seek playback and
+	// thus rebuild the timeline.
+	ArmNextEntryTimer(position);
+
+	for (std::size_t i = 0; i < dueEvents.size(); ++i)
+		ServiceManager::Instance().GetRootController().ProcessEvent(dueEvents[i]);
+}
+
+void PlaybackPositionEventsManager::on_playback_stop(playback_control::t_stop_reason p_reason)
+{
+	StopTimer();
+	m_timeline.clear();
+	m_nextEntry = 0;
+}
+
+void PlaybackPositionEventsManager::on_playback_pause(bool p_state)
+{
+	if (p_state)
+		StopTimer();
+	else
+		ArmTimer(static_api_ptr_t<playback_control>()->playback_get_position());
+}
+
+void PlaybackPositionEventsManager::on_playback_new_track(metadb_handle_ptr p_track)
+{
+	BuildTimeline(p_track);
+
+	static_api_ptr_t<playback_control> pc;
+
+	if (!pc->is_paused())
+		ArmTimer(pc->playback_get_position());
+}
+
+void PlaybackPositionEventsManager::on_playback_seek(double p_time)
+{
+	StopTimer();
+
+	if (!static_api_ptr_t<playback_control>()->is_paused())
+		ArmTimer(p_time);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "playback_position_event.h"
+#include "date_time_events_manager.h"
+
+class Model;
+
+// Keeps a timeline of the playback position events for the current track, sorted by position,
+// and arms a single timer for the nearest one. Seeking only searches the timeline for the new position.
+class PlaybackPositionEventsManager : public play_callback, private boost::noncopyable
+{
+public:
+	explicit PlaybackPositionEventsManager(Model& model);
+
+	void Reset();
+	void Shutdown();
+
+private: // play_callback
+	virtual void on_playback_stop(playback_control::t_stop_reason p_reason);
+	virtual void on_playback_pause(bool p_state);
+	virtual void on_playback_new_track(metadb_handle_ptr p_track);
+	virtual void on_playback_seek(double p_time);
+
+	virtual void on_playback_starting(play_control::t_track_command p_command, bool p_paused) {}
+	virtual void on_playback_edited(metadb_handle_ptr p_track) {}
+	virtual void on_playback_dynamic_info(const file_info & p_info) {}
+	virtual void on_playback_dynamic_info_track(const file_info & p_info) {}
+	virtual void on_playback_time(double p_time) {}
+	virtual void on_volume_change(float p_new_val) {}
+
+private:
+	void BuildTimeline(const metadb_handle_ptr& track);
+
+	// Arms the timer for the first event at or after the position.
+	void ArmTimer(double position);
+	void ArmNextEntryTimer(double position);
+	void StopTimer();
+
+	void OnTimerEvent(TimersManager::TimerID timerID);
+
+private:
+	struct TimelineEntry
+	{
+		double position; // Seconds.
+		PlaybackPositionEvent* pEvent;
+
+		bool operator<(const TimelineEntry& rhs) const { return position < rhs.position; }
+	};
+
+	std::vector<TimelineEntry> m_timeline;
+	std::size_t m_nextEntry;
+
+	boost::shared_ptr<MethodCallProxy> m_onTimerEventProxy;
+	TimersManager::TimerID m_timerID;
+};
\ No newline at end of file
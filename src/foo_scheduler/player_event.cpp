@@ -3,6 +3,7 @@
 #include "pref_page_model.h"
 #include "service_manager.h"
 #include "combo_helpers.h"
+#include "track_query_cache.h"
 
 //------------------------------------------------------------------------------
 // PlayerEvent
@@ -13,7 +14,8 @@ PlayerEvent::PlayerEvent() : m_type(PlayerEventType::onPlaybackStart), m_finalAc
 }
 
 PlayerEvent::PlayerEvent(const PlayerEvent& rhs) : Event(rhs),
-	m_type(rhs.m_type),	m_finalAction(rhs.m_finalAction), m_stopReasons(rhs.m_stopReasons)
+	m_type(rhs.m_type),	m_finalAction(rhs.m_finalAction), m_stopReasons(rhs.m_stopReasons),
+	m_trackQuery(rhs.m_trackQuery)
 {
 }
 
@@ -38,6 +40,10 @@ std::wstring PlayerEvent::GetDescription() const
 				result += L", ";
 		}
 	}
+	else if (m_type == PlayerEventType::onPlaybackNewTrack && !m_trackQuery.empty())
+	{
+		result += L" / " + m_trackQuery;
+	}
 
 	switch (m_finalAction)
 	{
@@ -106,6 +112,16 @@ void PlayerEvent::SetFinalAction(EFinalAction finalAction)
 	m_finalAction = finalAction;
 }
 
+const std::wstring& PlayerEvent::GetTrackQuery() const
+{
+	return m_trackQuery;
+}
+
+void PlayerEvent::SetTrackQuery(const std::wstring& trackQuery)
+{
+	m_trackQuery = trackQuery;
+}
+
 void PlayerEvent::LoadFromS11nBlock(const EventS11nBlock& block)
 {
 	if (!block.playerEvent.Exists())
@@ -141,6 +157,9 @@ void PlayerEvent::LoadFromS11nBlock(const EventS11nBlock& block)
 			m_stopReasons.push_back(PlayerEventStopReason::eof);
 		}
 	}
+
+	if (m_type == PlayerEventType::onPlaybackNewTrack && b.trackQuery.Exists())
+		m_trackQuery = pfc::stringcvt::string_wide_from_utf8(b.trackQuery.GetValue()).get_ptr();
 }
 
 void PlayerEvent::SaveToS11nBlock(EventS11nBlock& block) const
@@ -156,6 +175,9 @@ void PlayerEvent::SaveToS11nBlock(EventS11nBlock& block) const
 			b.stopReasons.Add(m_stopReasons[i]);
 	}
 
+	if (m_type == PlayerEventType::onPlaybackNewTrack && !m_trackQuery.empty())
+		b.trackQuery.SetValue(pfc::stringcvt::string_utf8_from_wide(m_trackQuery.c_str()).get_ptr());
+
 	block.playerEvent.SetValue(b);
 }
 
@@ -208,7 +230,7 @@ namespace
 
 PlayerEventEditor::PlayerEventEditor(PlayerEvent* pEvent, PrefPageModel* pPrefPageModel) :
 	m_pEvent(pEvent), m_pPrefPageModel(pPrefPageModel),
-	m_stopReasonsDy(0), m_stopReasonsControlVisible(true)
+	m_optionsDy(0), m_optionsControlsVisible(true)
 {
 
 }
@@ -237,7 +259,8 @@ BOOL PlayerEventEditor::OnInitDialog(CWindow wndFocus, LPARAM lInitParam)
 	);
 
 	CreateStopReasonsControl();
-	UpdateStopReasonsControlVisibility();
+	SetDlgItemText(IDC_EDIT_TRACK_QUERY, m_pEvent->GetTrackQuery().c_str());
+	UpdateOptionsControlsVisibility();
 
 	CenterWindow(GetParent());
 
@@ -271,6 +294,24 @@ void PlayerEventEditor::OnClose(UINT uNotifyCode, int nID, CWindow wndCtl)
 		else
 			m_pEvent->SetStopReasons(PlayerEvent::StopReasons());
 
+		std::wstring trackQuery;
+
+		if (type == PlayerEventType::onPlaybackNewTrack)
+		{
+			CString text;
+			GetDlgItemText(IDC_EDIT_TRACK_QUERY, text);
+			trackQuery = boost::trim_copy(std::wstring(text.GetString()));
+
+			std::wstring error;
+			if (!TrackQueryCache::Validate(trackQuery, error))
+			{
+				m_popupTooltipMsg.Show(error.empty() ? L"Invalid query." : error.c_str(), GetDlgItem(IDC_EDIT_TRACK_QUERY));
+				return;
+			}
+		}
+
+		m_pEvent->SetTrackQuery(trackQuery);
+
 		m_pEvent->SetType(type);
 		m_pEvent->SetFinalAction(ComboHelpers::GetSelectedItem<PlayerEvent::EFinalAction>(m_finalAction));
 	}
@@ -307,7 +348,7 @@ void PlayerEventEditor::CreateStopReasonsControl()
 	m_finalAction.GetWindowRect(finalActionRect);
 	ScreenToClient(finalActionRect);
 
-	m_stopReasonsDy = finalActionRect.top - stopReasonsRect.top;
+	m_optionsDy = finalActionRect.top - stopReasonsRect.top;
 
 	if (m_pEvent->GetType() == PlayerEventType::onPlaybackStop)
 	{
@@ -322,20 +363,26 @@ void PlayerEventEditor::CreateStopReasonsControl()
 	}
 }
 
-void PlayerEventEditor::UpdateStopReasonsControlVisibility()
+void PlayerEventEditor::UpdateOptionsControlsVisibility()
 {
 	PlayerEventType::Type type = ComboHelpers::GetSelectedItem<PlayerEventType::Type>(m_eventType);
 
-	bool show = type == PlayerEventType::onPlaybackStop;
+	const bool showStopReasons = type == PlayerEventType::onPlaybackStop;
+	const bool showTrackQuery = type == PlayerEventType::onPlaybackNewTrack;
 
-	if (m_stopReasonsControlVisible == show)
-		return;
+	GetDlgItem(IDC_STATIC_REASON).ShowWindow(showStopReasons);
+	m_stopReasons.ShowWindow(showStopReasons);
+
+	GetDlgItem(IDC_STATIC_TRACK_QUERY).ShowWindow(showTrackQuery);
+	GetDlgItem(IDC_EDIT_TRACK_QUERY).ShowWindow(showTrackQuery);
 
-	const int dy = m_stopReasonsControlVisible ? -m_stopReasonsDy : m_stopReasonsDy;
-	m_stopReasonsControlVisible = show;
+	const bool show = showStopReasons || showTrackQuery;
+
+	if (m_optionsControlsVisible == show)
+		return;
 
-	GetDlgItem(IDC_STATIC_REASON).ShowWindow(show);
-	m_stopReasons.ShowWindow(show);
+	const int dy = m_optionsControlsVisible ? -m_optionsDy : m_optionsDy;
+	m_optionsControlsVisible = show;
 
 	std::vector<CWindow> windowsToMove;
 
@@ -367,5 +414,5 @@ void PlayerEventEditor::UpdateStopReasonsControlVisibility()
 void PlayerEventEditor::OnEventTypeSelChange(UINT uNotifyCode, int nID, CWindow wndCtl)
 {
 	m_popupTooltipMsg.CleanUp();
-	UpdateStopReasonsControlVisibility();
+	UpdateOptionsControlsVisibility();
 }
\ No newline at end of file
@@ -111,6 +111,10 @@ public:
 	EFinalAction GetFinalAction() const;
 	void SetFinalAction(EFinalAction finalAction);
 
+	// New track events only fire for tracks matching the query, empty matches all tracks.
+	const std::wstring& GetTrackQuery() const;
+	void SetTrackQuery(const std::wstring& trackQuery);
+
 private:
 	PlayerEvent(const PlayerEvent& rhs);
 
@@ -118,6 +122,7 @@ private:
 	PlayerEventType::Type m_type;
 	StopReasons m_stopReasons;
 	EFinalAction m_finalAction;
+	std::wstring m_trackQuery;
 };
 
 //------------------------------------------------------------------------------
@@ -145,7 +150,7 @@ private:
 
 private:
 	void CreateStopReasonsControl();
-	void UpdateStopReasonsControlVisibility();
+	void UpdateOptionsControlsVisibility();
 
 private:
 	PlayerEvent* m_pEvent;
@@ -155,8 +160,9 @@ private:
 	CComboBox m_finalAction;
 	CCheckListViewCtrl m_stopReasons;
 
-	int m_stopReasonsDy;
-	bool m_stopReasonsControlVisible;
+	// Stop reasons and track query share the same place.
+	int m_optionsDy;
+	bool m_optionsControlsVisible;
 
 	PopupTooltipMessage m_popupTooltipMsg;
 	fb2k::CDarkModeHooks m_dark;
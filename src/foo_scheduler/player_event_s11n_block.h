@@ -7,10 +7,11 @@ struct PlayerEventS11nBlock : public S11nBlocks::Block<PlayerEventS11nBlock>
 	S11nBlocks::Field<int, 1> type;
 	S11nBlocks::Field<int, 2> finalAction;
 	S11nBlocks::RepeatedField<int, 3> stopReasons;
+	S11nBlocks::Field<pfc::string8, 4> trackQuery;
 
 	template<class Archive>
 	void RegisterFields(Archive& ar)
 	{
-		ar.RegisterFields(type)(finalAction)(stopReasons);
+		ar.RegisterFields(type)(finalAction)(stopReasons)(trackQuery);
 	}
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "player_events_manager.h"
 #include "service_manager.h"
+#include "metrics.h"
 
 PlayerEventsManager::PlayerEventsManager(Model& model) : m_blockEvents(false)
 {
@@ -17,6 +18,8 @@ void PlayerEventsManager::Reset()
 {
 	static_api_ptr_t<play_callback_manager>()->unregister_callback(this);
 
+	UpdateTrackQueries();
+
 	if (!ServiceManager::Instance().GetModel().IsSchedulerEnabled())
 		return;
 
@@ -26,6 +29,9 @@ void PlayerEventsManager::Reset()
 void PlayerEventsManager::Shutdown()
 {
 	static_api_ptr_t<play_callback_manager>()->unregister_callback(this);
+
+	m_eventQueryIDs.clear();
+	m_trackQueryCache.Clear();
 }
 
 void PlayerEventsManager::BlockEvents(bool block)
@@ -39,6 +45,8 @@ void PlayerEventsManager::EmitPlayerEvent(PlayerEventType::Type type,
 	if (m_blockEvents)
 		return;
 
+	Metrics::ScopedTimer timer(Metrics::histPlayerEventDispatch);
+
 	std::vector<Event*> events = ServiceManager::Instance().GetModel().GetEvents();
 
 	for (std::size_t i = 0; i < events.size(); ++i)
@@ -80,6 +88,33 @@ bool PlayerEventsManager::EqualStopReason(playback_control::t_stop_reason reason
 	return it != sr.end();
 }
 
+void PlayerEventsManager::UpdateTrackQueries()
+{
+	m_eventQueryIDs.clear();
+	m_trackQueryCache.Clear();
+
+	const std::vector<Event*> events = ServiceManager::Instance().GetModel().GetEvents();
+
+	for (std::size_t i = 0; i < events.size(); ++i)
+	{
+		if (PlayerEvent* pEvent = dynamic_cast<PlayerEvent*>(events[i]))
+		{
+			if (pEvent->GetType() == PlayerEventType::onPlaybackNewTrack)
+				m_eventQueryIDs[pEvent] = m_trackQueryCache.AddQuery(pEvent->GetTrackQuery());
+		}
+	}
+}
+
+bool PlayerEventsManager::MatchesTrackQuery(const metadb_handle_ptr& track, PlayerEvent* pEvent)
+{
+	auto it = m_eventQueryIDs.find(pEvent);
+
+	if (it == m_eventQueryIDs.end())
+		return pEvent->GetTrackQuery().empty();
+
+	return m_trackQueryCache.Matches(it->second, track);
+}
+
 void PlayerEventsManager::on_playback_stop(playback_control::t_stop_reason reason)
 {
 	// Ignore this reason cause we're shutting down and
@@ -103,6 +138,7 @@ void PlayerEventsManager::on_playback_starting(play_control::t_track_command p_c
 
 void PlayerEventsManager::on_playback_new_track(metadb_handle_ptr p_track)
 {
-	EmitPlayerEvent(PlayerEventType::onPlaybackNewTrack);
+	EmitPlayerEvent(PlayerEventType::onPlaybackNewTrack,
+		boost::bind(&PlayerEventsManager::MatchesTrackQuery, this, p_track, _1));
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "player_event.h"
+#include "track_query_cache.h"
 
 class Model;
 
@@ -35,7 +36,13 @@ private:
 		const AdditionalConditionFunc& condition = AdditionalConditionFunc());
 
 	bool EqualStopReason(playback_control::t_stop_reason reason, PlayerEvent* pEvent);
+	bool MatchesTrackQuery(const metadb_handle_ptr& track, PlayerEvent* pEvent);
+
+	void UpdateTrackQueries();
 
 private:
 	bool m_blockEvents;
+
+	TrackQueryCache m_trackQueryCache;
+	std::map<const PlayerEvent*, TrackQueryCache::QueryID> m_eventQueryIDs;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "version.h"
 #include "pref_page.h"
 #include "service_manager.h"
+#include "schedule_io.h"
 
 //snapLeft, snapTop, snapRight, snapBottom
 const CDialogResizeHelper::Param rs_params[] = {
@@ -12,6 +13,7 @@ const CDialogResizeHelper::Param rs_params[] = {
 	{IDC_BTN_ADD_ACTION_LIST, 1,0,1,0},
 	{IDC_ACTION_LIST_TREE, 0,0,1,0},
 	{IDC_STATIC_STATUS_HEADER, 0,0,1,0},
+	{IDC_BTN_IMPORT_EXPORT, 1,0,1,0},
 	{IDC_BTN_SHOW_STATUS_WINDOW, 1,0,1,0},
 };
 PreferencesPage::PreferencesPage(preferences_page_callback::ptr callback) :
@@ -148,6 +150,56 @@ void PreferencesPage::OnBtnShowStatusWindow(UINT /*uNotifyCode*/, int /*nID*/, C
 	ServiceManager::Instance().GetRootController().ShowStatusWindow();
 }
 
+void PreferencesPage::OnBtnImportExport(UINT /*uNotifyCode*/, int /*nID*/, CWindow /*wndCtl*/)
+{
+	enum { menuItemImport = 1, menuItemExport };
+
+	CMenu menuPopup;
+	menuPopup.CreatePopupMenu();
+	menuPopup.AppendMenu(MF_STRING | MF_BYCOMMAND, static_cast<UINT_PTR>(menuItemImport), L"Import events and tasks...");
+	menuPopup.AppendMenu(MF_STRING | MF_BYCOMMAND, static_cast<UINT_PTR>(menuItemExport), L"Export events and tasks...");
+
+	CRect rcBtn;
+	GetDlgItem(IDC_BTN_IMPORT_EXPORT).GetWindowRect(rcBtn);
+
+	UINT uCmdID = menuPopup.TrackPopupMenu(TPM_LEFTALIGN | TPM_NONOTIFY | TPM_RETURNCMD,
+		rcBtn.left, rcBtn.bottom, *this);
+
+	if (uCmdID == 0)
+		return;
+
+	const bool importing = uCmdID == menuItemImport;
+	const DWORD flags = importing ? OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY :
+		OFN_OVERWRITEPROMPT | OFN_HIDEREADONLY;
+
+	CFileDialog dlg(importing, L"jsonl", importing ? NULL : L"scheduler.jsonl", flags,
+		L"JSON lines (*.jsonl)\0*.jsonl\0All files (*.*)\0*.*\0");
+
+	if (dlg.DoModal(m_hWnd) != IDOK)
+		return;
+
+	pfc::string8 path = pfc::stringcvt::string_utf8_from_wide(dlg.m_szFileName).get_ptr();
+
+	try
+	{
+		if (importing)
+		{
+			const ScheduleIO::ImportResult result = ScheduleIO::Import(*m_pModel, path);
+			popup_message::g_show(pfc::stringcvt::string_utf8_from_wide(
+				ScheduleIO::FormatImportResult(result).c_str()), COMPONENT_NAME);
+		}
+		else
+		{
+			ScheduleIO::Export(*m_pModel, path);
+			console::formatter() << COMPONENT_NAME ": events and tasks exported to " << path;
+		}
+	}
+	catch (const std::exception& e)
+	{
+		popup_message::g_complain(importing ? COMPONENT_NAME ": import failed" : COMPONENT_NAME ": export failed", e);
+	}
+}
+
 void PreferencesPage::OnEnableScheduler(UINT uNotifyCode, int nID, CWindow wndCtl)
 {
 	m_pModel->SetSchedulerEnabled(IsDlgButtonChecked(IDC_ENABLED_CHECK) == 1);
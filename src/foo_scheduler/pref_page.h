@@ -34,6 +34,7 @@ private:
 		COMMAND_ID_HANDLER_EX(IDC_BTN_ADD_EVENT, OnBtnAddEvent)
 		COMMAND_ID_HANDLER_EX(IDC_BTN_ADD_ACTION_LIST, OnBtnAddActionList)
 		COMMAND_ID_HANDLER_EX(IDC_BTN_SHOW_STATUS_WINDOW, OnBtnShowStatusWindow)
+		COMMAND_ID_HANDLER_EX(IDC_BTN_IMPORT_EXPORT, OnBtnImportExport)
 		COMMAND_ID_HANDLER_EX(IDC_ENABLED_CHECK, OnEnableScheduler)
 	END_MSG_MAP()
 
@@ -46,6 +47,7 @@ private:
 	void OnBtnAddEvent(UINT uNotifyCode, int nID, CWindow wndCtl);
 	void OnBtnAddActionList(UINT uNotifyCode, int nID, CWindow wndCtl);
 	void OnBtnShowStatusWindow(UINT uNotifyCode, int nID, CWindow wndCtl);
+	void OnBtnImportExport(UINT uNotifyCode, int nID, CWindow wndCtl);
 	void OnEnableScheduler(UINT uNotifyCode, int nID, CWindow wndCtl);
 
 	void OnChanged();
@@ -63,6 +65,8 @@ private:
 	EventListWindow m_eventList;
 	ActionTreeWindow m_actionTree;
 
+	// The windows are subscribed to the model without a way to disconnect. Declared after them,
+	// so it's destroyed first and never calls a destroyed window, keep it that way.
 	boost::scoped_ptr<PrefPageModel> m_pModel;
 
 	bool m_changed;
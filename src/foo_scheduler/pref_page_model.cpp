@@ -7,21 +7,138 @@
 
 #include "action_start_playback.h"
 
-PrefPageModel::PrefPageModel(const ModelState& modelState) : m_modelState(modelState)
+PrefPageModel::PrefPageModel(const ModelState& modelState) : m_modelState(modelState),
+	m_transactionDepth(0), m_modelChangedPending(false)
 {
+	RebuildIndexes();
+}
+
+PrefPageModel::Transaction::Transaction(PrefPageModel& model) : m_model(model)
+{
+	m_model.BeginTransaction();
+}
+
+PrefPageModel::Transaction::~Transaction()
+{
+	m_model.CommitTransaction();
+}
+
+void PrefPageModel::BeginTransaction()
+{
+	++m_transactionDepth;
+}
+
+void PrefPageModel::CommitTransaction()
+{
+	_ASSERTE(m_transactionDepth > 0);
+
+	// Still inside the transaction, so the events are queued like any other update.
+	if (m_transactionDepth == 1 && !m_pendingUpdatedActionLists.empty())
+	{
+		for (auto it = m_modelState.events.begin(); it != m_modelState.events.end(); ++it)
+			if (m_pendingUpdatedActionLists.count(it->GetActionListGUID()) != 0)
+				QueueEventUpdate(&(*it));
+
+		m_pendingUpdatedActionLists.clear();
+	}
+
+	if (--m_transactionDepth != 0)
+		return;
+
+	// Pending state is taken first, listeners may change the model again.
+	std::vector<Event*> addedEvents;
+	addedEvents.swap(m_pendingAddedEvents);
+	m_pendingAddedEventsSet.clear();
+
+	std::vector<Event*> updatedEvents;
+	updatedEvents.swap(m_pendingUpdatedEvents);
+	m_pendingUpdatedEventsSet.clear();
+
+	const bool modelChanged = m_modelChangedPending;
+	m_modelChangedPending = false;
+
+	if (!addedEvents.empty())
+		m_eventsAddedSignal(addedEvents);
+
+	if (!updatedEvents.empty())
+		m_eventsUpdatedSignal(updatedEvents);
+
+	if (modelChanged)
+		m_modelChangedSignal();
+}
+
+void PrefPageModel::QueueEventUpdate(Event* pEvent)
+{
+	_ASSERTE(m_transactionDepth > 0);
+
+	// Listeners get added events with their latest state anyway.
+	if (m_pendingAddedEventsSet.count(pEvent) == 0 && m_pendingUpdatedEventsSet.insert(pEvent).second)
+		m_pendingUpdatedEvents.push_back(pEvent);
+
+	m_modelChangedPending = true;
+}
+
+void PrefPageModel::QueueLinkedEventsUpdate(const GUID& actionListGUID)
+{
+	_ASSERTE(m_transactionDepth > 0);
+
+	m_pendingUpdatedActionLists.insert(actionListGUID);
+	m_modelChangedPending = true;
+}
+
+bool PrefPageModel::DropPendingEvent(Event* pEvent)
+{
+	if (m_pendingUpdatedEventsSet.erase(pEvent) != 0)
+	{
+		m_pendingUpdatedEvents.erase(
+			std::remove(m_pendingUpdatedEvents.begin(), m_pendingUpdatedEvents.end(), pEvent),
+			m_pendingUpdatedEvents.end());
+	}
+
+	if (m_pendingAddedEventsSet.erase(pEvent) != 0)
+	{
+		m_pendingAddedEvents.erase(
+			std::remove(m_pendingAddedEvents.begin(), m_pendingAddedEvents.end(), pEvent),
+			m_pendingAddedEvents.end());
+
+		return true;
+	}
+
+	return false;
+}
+
+void PrefPageModel::RebuildIndexes()
+{
+	m_eventsIndex.clear();
+	m_eventsIndex.reserve(m_modelState.events.size());
+
+	for (auto it = m_modelState.events.begin(); it != m_modelState.events.end(); ++it)
+		m_eventsIndex[it->GetEventGUID()] = &(*it);
+
+	m_actionListsIndex.clear();
+	m_actionListsIndex.reserve(m_modelState.actionLists.size());
+
+	for (auto it = m_modelState.actionLists.begin(); it != m_modelState.actionLists.end(); ++it)
+		m_actionListsIndex[it->GetGUID()] = &(*it);
 }
 
 void PrefPageModel::AddEvent(std::unique_ptr<Event>&& pEvent)
 {
+	Transaction transaction(*this);
+
 	Event* pE = pEvent.get();
+	m_modelState.BindCalendar(*pE);
+	m_eventsIndex[pE->GetEventGUID()] = pE;
 	m_modelState.events.push_back(std::move(pEvent));
-	m_eventAddedSignal(pE);
-	m_modelChangedSignal();
+
+	m_pendingAddedEvents.push_back(pE);
+	m_pendingAddedEventsSet.insert(pE);
+	m_modelChangedPending = true;
 }
 
-boost::signals2::connection PrefPageModel::ConnectEventAddedSlot(const EventAddedSignal::slot_type& slot)
+void PrefPageModel::ConnectEventsAddedSlot(const EventsAddedSignal::Slot& slot)
 {
-	return m_eventAddedSignal.connect(slot);
+	m_eventsAddedSignal.Connect(slot);
 }
 
 std::vector<Event*> PrefPageModel::GetEvents()
@@ -31,15 +148,21 @@ std::vector<Event*> PrefPageModel::GetEvents()
 	return result;
 }
 
+Event* PrefPageModel::GetEventByGUID(const GUID& guid)
+{
+	auto it = m_eventsIndex.find(guid);
+	return it != m_eventsIndex.end() ? it->second : 0;
+}
+
 void PrefPageModel::UpdateEvent(Event* pEvent)
 {
-	m_eventUpdatedSignal(pEvent);
-	m_modelChangedSignal();
+	Transaction transaction(*this);
+	QueueEventUpdate(pEvent);
 }
 
-boost::signals2::connection PrefPageModel::ConnectEventUpdatedSlot(const EventUpdatedSignal::slot_type& slot)
+void PrefPageModel::ConnectEventsUpdatedSlot(const EventsUpdatedSignal::Slot& slot)
 {
-	return m_eventUpdatedSignal.connect(slot);
+	m_eventsUpdatedSignal.Connect(slot);
 }
 
 std::vector<ActionList*> PrefPageModel::GetActionLists()
@@ -54,30 +177,74 @@ void PrefPageModel::RemoveEvent(Event* pEvent)
 	auto it = std::find_if(m_modelState.events.begin(), m_modelState.events.end(), &boost::lambda::_1 == pEvent);
 	_ASSERTE(it != m_modelState.events.end());
 
+	Transaction transaction(*this);
+
+	m_eventsIndex.erase(pEvent->GetEventGUID());
+
+	// Listeners haven't seen an event added in this transaction.
+	const bool pendingAdd = DropPendingEvent(pEvent);
+
 	ModelState::EventsContainer::auto_type pReleasedEvent = m_modelState.events.release(it);
-	m_eventRemovedSignal(pReleasedEvent.get());
+
+	if (!pendingAdd)
+		m_eventRemovedSignal(pReleasedEvent.get());
 	
-	m_modelChangedSignal();
+	m_modelChangedPending = true;
 }
 
-boost::signals2::connection PrefPageModel::ConnectEventRemovedSlot(const EventRemovedSignal::slot_type& slot)
+void PrefPageModel::ConnectEventRemovedSlot(const EventRemovedSignal::Slot& slot)
 {
-	return m_eventRemovedSignal.connect(slot);
+	m_eventRemovedSignal.Connect(slot);
+}
+
+void PrefPageModel::ReplaceEvent(Event* pEvent, std::unique_ptr<Event>&& pNewEvent)
+{
+	auto it = std::find_if(m_modelState.events.begin(), m_modelState.events.end(), &boost::lambda::_1 == pEvent);
+	_ASSERTE(it != m_modelState.events.end());
+
+	Transaction transaction(*this);
+
+	Event* pE = pNewEvent.get();
+	m_modelState.BindCalendar(*pE);
+	m_eventsIndex.erase(pEvent->GetEventGUID());
+	m_eventsIndex[pE->GetEventGUID()] = pE;
+
+	// Listeners haven't seen an event added in this transaction, the new one is added instead.
+	const bool pendingAdd = DropPendingEvent(pEvent);
+
+	ModelState::EventsContainer::auto_type pReleasedEvent = m_modelState.events.replace(it, pNewEvent.release());
+
+	if (pendingAdd)
+	{
+		m_pendingAddedEvents.push_back(pE);
+		m_pendingAddedEventsSet.insert(pE);
+	}
+	else
+		m_eventReplacedSignal(pReleasedEvent.get(), pE);
+
+	m_modelChangedPending = true;
+}
+
+void PrefPageModel::ConnectEventReplacedSlot(const EventReplacedSignal::Slot& slot)
+{
+	m_eventReplacedSignal.Connect(slot);
 }
 
 void PrefPageModel::AddActionList(std::unique_ptr<ActionList>&& pActionList)
 {
+	Transaction transaction(*this);
+
 	ActionList* pAL = pActionList.get();
+	m_actionListsIndex[pAL->GetGUID()] = pAL;
 	m_modelState.actionLists.push_back(std::move(pActionList));
 	
 	m_actionListAddedSignal(pAL);
-	m_modelChangedSignal();
+	m_modelChangedPending = true;
 }
 
-boost::signals2::connection PrefPageModel::ConnectActionListAddedSlot(
-	const ActionListAddedSignal::slot_type& slot)
+void PrefPageModel::ConnectActionListAddedSlot(const ActionListAddedSignal::Slot& slot)
 {
-	return m_actionListAddedSignal.connect(slot);
+	m_actionListAddedSignal.Connect(slot);
 }
 
 void PrefPageModel::RemoveActionList(ActionList* pActionList)
@@ -85,43 +252,67 @@ void PrefPageModel::RemoveActionList(ActionList* pActionList)
 	auto it = std::find_if(m_modelState.actionLists.begin(), m_modelState.actionLists.end(), &boost::lambda::_1 == pActionList);
 	_ASSERTE(it != m_modelState.actionLists.end());
 
+	Transaction transaction(*this);
+
 	for (std::size_t i = 0; i < m_modelState.events.size(); ++i)
 		if (m_modelState.events[i].GetActionListGUID() == pActionList->GetGUID())
 		{
 			m_modelState.events[i].SetActionListGUID(pfc::guid_null);
-			m_eventUpdatedSignal(&m_modelState.events[i]);
+			QueueEventUpdate(&m_modelState.events[i]);
 		}
 
+	m_actionListsIndex.erase(pActionList->GetGUID());
+
 	ModelState::ActionListsContainer::auto_type pReleasedActionList = m_modelState.actionLists.release(it);
 	m_actionListRemovedSignal(pReleasedActionList.get());
 
-	m_modelChangedSignal();
+	m_modelChangedPending = true;
 }
 
-boost::signals2::connection PrefPageModel::ConnectActionListRemovedSlot(const ActionListRemovedSignal::slot_type& slot)
+void PrefPageModel::ConnectActionListRemovedSlot(const ActionListRemovedSignal::Slot& slot)
 {
-	return m_actionListRemovedSignal.connect(slot);
+	m_actionListRemovedSignal.Connect(slot);
 }
 
 void PrefPageModel::UpdateActionList(ActionList* pActionList)
 {
-	for (std::size_t i = 0; i < m_modelState.events.size(); ++i)
-		if (m_modelState.events[i].GetActionListGUID() == pActionList->GetGUID()) {
-			m_eventUpdatedSignal(&m_modelState.events[i]);
-		}
+	Transaction transaction(*this);
+
+	QueueLinkedEventsUpdate(pActionList->GetGUID());
 
 	m_actionListUpdatedSignal(pActionList);
-	m_modelChangedSignal();
+	m_modelChangedPending = true;
 }
 
-boost::signals2::connection PrefPageModel::ConnectActionListUpdatedSlot(const ActionListUpdatedSignal::slot_type& slot)
+void PrefPageModel::ReplaceActionList(ActionList* pActionList, std::unique_ptr<ActionList>&& pNewActionList)
 {
-	return m_actionListUpdatedSignal.connect(slot);
+	auto it = std::find_if(m_modelState.actionLists.begin(), m_modelState.actionLists.end(), &boost::lambda::_1 == pActionList);
+	_ASSERTE(it != m_modelState.actionLists.end());
+
+	Transaction transaction(*this);
+
+	ActionList* pAL = pNewActionList.get();
+	m_actionListsIndex.erase(pActionList->GetGUID());
+	m_actionListsIndex[pAL->GetGUID()] = pAL;
+
+	ModelState::ActionListsContainer::auto_type pReleasedActionList =
+		m_modelState.actionLists.replace(it, pNewActionList.release());
+
+	m_actionListRemovedSignal(pReleasedActionList.get());
+	m_actionListAddedSignal(pAL);
+
+	// Task names are shown in the event list.
+	QueueLinkedEventsUpdate(pAL->GetGUID());
 }
 
-boost::signals2::connection PrefPageModel::ConnectModelChangedSlot(const ModelChangedSignal::slot_type& slot)
+void PrefPageModel::ConnectActionListUpdatedSlot(const ActionListUpdatedSignal::Slot& slot)
 {
-	return m_modelChangedSignal.connect(slot);
+	m_actionListUpdatedSignal.Connect(slot);
+}
+
+void PrefPageModel::ConnectModelChangedSlot(const ModelChangedSignal::Slot& slot)
+{
+	m_modelChangedSignal.Connect(slot);
 }
 
 const ModelState& PrefPageModel::GetState() const
@@ -131,62 +322,91 @@ const ModelState& PrefPageModel::GetState() const
 
 void PrefPageModel::AddActionToActionList(ActionList* pActionList, std::unique_ptr<IAction> pAction)
 {
+	Transaction transaction(*this);
+
 	IAction* pA = pAction.get();
 	pActionList->AddAction(std::move(pAction));
 
 	m_actionAddedSignal(pActionList, pA);
-	m_modelChangedSignal();
+	m_modelChangedPending = true;
 }
 
-boost::signals2::connection PrefPageModel::ConnectActionAddedSlot(const ActionAddedSignal::slot_type& slot)
+void PrefPageModel::ConnectActionAddedSlot(const ActionAddedSignal::Slot& slot)
 {
-	return m_actionAddedSignal.connect(slot);
+	m_actionAddedSignal.Connect(slot);
 }
 
 void PrefPageModel::UpdateAction(ActionList* pActionList, IAction* pAction)
 {
+	Transaction transaction(*this);
+
 	m_actionUpdatedSignal(pActionList, pAction);
-	m_modelChangedSignal();
+	m_modelChangedPending = true;
 }
 
-boost::signals2::connection PrefPageModel::ConnectActionUpdatedSlot(const ActionUpdatedSignal::slot_type& slot)
+void PrefPageModel::ConnectActionUpdatedSlot(const ActionUpdatedSignal::Slot& slot)
 {
-	return m_actionUpdatedSignal.connect(slot);
+	m_actionUpdatedSignal.Connect(slot);
 }
 
 void PrefPageModel::RemoveAction(ActionList* pActionList, IAction* pAction)
 {
+	Transaction transaction(*this);
+
 	ActionList::ActionsContainer::auto_type pReleasedAction = pActionList->RemoveAction(pAction);
 	m_actionRemovedSignal(pActionList, pReleasedAction.get());
-	m_modelChangedSignal();
+	m_modelChangedPending = true;
 }
 
-boost::signals2::connection PrefPageModel::ConnectActionRemovedSlot(const ActionRemovedSignal::slot_type& slot)
+void PrefPageModel::ConnectActionRemovedSlot(const ActionRemovedSignal::Slot& slot)
 {
-	return m_actionRemovedSignal.connect(slot);
+	m_actionRemovedSignal.Connect(slot);
 }
 
-ActionList* PrefPageModel::GetActionListByGUID(const GUID& guid)
+const ModelState::CalendarsContainer& PrefPageModel::GetCalendars() const
+{
+	return m_modelState.calendars;
+}
+
+void PrefPageModel::SetCalendars(const ModelState::CalendarsContainer& calendars)
 {
-	auto it = std::find_if(m_modelState.actionLists.begin(), m_modelState.actionLists.end(),
-		boost::bind(&ActionList::GetGUID, _1) == guid);
+	Transaction transaction(*this);
+
+	m_modelState.calendars = calendars;
+
+	// Calendar names are shown in the event list.
+	const std::vector<Event*> events = m_modelState.BindCalendars();
 
-	if (it == m_modelState.actionLists.end())
-		return 0;
+	for (std::size_t i = 0; i < events.size(); ++i)
+		QueueEventUpdate(events[i]);
 
-	return &(*it);
+	m_modelChangedPending = true;
+}
+
+ActionList* PrefPageModel::GetActionListByGUID(const GUID& guid)
+{
+	auto it = m_actionListsIndex.find(guid);
+	return it != m_actionListsIndex.end() ? it->second : 0;
 }
 
 void PrefPageModel::Reset()
 {
 	m_modelState.Reset();
+	RebuildIndexes();
+
+	// The events of pending changes are gone.
+	m_pendingAddedEvents.clear();
+	m_pendingAddedEventsSet.clear();
+	m_pendingUpdatedEvents.clear();
+	m_pendingUpdatedEventsSet.clear();
+	m_pendingUpdatedActionLists.clear();
 
 	m_modelResetSignal();
 }
 
-boost::signals2::connection PrefPageModel::ConnectModelResetSlot(const ModelResetSignal::slot_type& slot)
+void PrefPageModel::ConnectModelResetSlot(const ModelResetSignal::Slot& slot)
 {
-	return m_modelResetSignal.connect(slot);
+	m_modelResetSignal.Connect(slot);
 }
 
 bool PrefPageModel::CanMoveEventUp(const Event* pEvent) const
@@ -225,7 +445,8 @@ void PrefPageModel::SwapEvent(const Event* pEvent, const size_t left, const size
 	boost::ptr_vector<Event>::iterator rit = std::begin(m_modelState.events) + right;	
 	boost::swap(lit, rit);
 
-	m_modelChangedSignal();
+	Transaction transaction(*this);
+	m_modelChangedPending = true;
 }
 
 void PrefPageModel::MoveEvent(const Event* pEvent, bool up)
@@ -237,7 +458,8 @@ void PrefPageModel::MoveEvent(const Event* pEvent, bool up)
 	ModelState::EventsContainer::auto_type pE = m_modelState.events.release(it);
 	m_modelState.events.insert(m_modelState.events.begin() + pos, pE.release());
 
-	m_modelChangedSignal();
+	Transaction transaction(*this);
+	m_modelChangedPending = true;
 }
 
 bool PrefPageModel::IsSchedulerEnabled() const
@@ -247,6 +469,8 @@ bool PrefPageModel::IsSchedulerEnabled() const
 
 void PrefPageModel::SetSchedulerEnabled(bool enabled)
 {
+	Transaction transaction(*this);
+
 	m_modelState.schedulerEnabled = enabled;
-	m_modelChangedSignal();
+	m_modelChangedPending = true;
 }
@@ -4,7 +4,11 @@
 #include "event.h"
 #include "action.h"
 #include "action_list.h"
+#include "delegate_list.h"
 
+// All notifications are raised in the main thread, so they are dispatched through
+// DelegateList instead of boost::signals2. Slots can't be disconnected, subscribers
+// must outlive the model, see PreferencesPage.
 class PrefPageModel : boost::noncopyable
 {
 public:
@@ -12,13 +16,26 @@ public:
 
 	const ModelState& GetState() const;
 
-	typedef boost::signals2::signal<void ()> ModelResetSignal;
-	boost::signals2::connection ConnectModelResetSlot(const ModelResetSignal::slot_type& slot);
+	typedef DelegateList<void ()> ModelResetSignal;
+	void ConnectModelResetSlot(const ModelResetSignal::Slot& slot);
 
 	void Reset();
 
-	typedef boost::signals2::signal<void ()> ModelChangedSignal;
-	boost::signals2::connection ConnectModelChangedSlot(const ModelChangedSignal::slot_type& slot);
+	typedef DelegateList<void ()> ModelChangedSignal;
+	void ConnectModelChangedSlot(const ModelChangedSignal::Slot& slot);
+
+	// Defers added and updated events and the model changed notification until the outermost transaction ends.
+	// Repeated updates of an event are merged, so listeners get a single batch and redraw once.
+	// Removed events and all action list changes are still reported immediately.
+	class Transaction : boost::noncopyable
+	{
+	public:
+		explicit Transaction(PrefPageModel& model);
+		~Transaction();
+
+	private:
+		PrefPageModel& m_model;
+	};
 
 	//////////////////////////////////////////////////////////////////////////
 	// Scheduler status
@@ -29,20 +46,27 @@ public:
 	//////////////////////////////////////////////////////////////////////////
 	// Events
 
-	typedef boost::signals2::signal<void (Event*)> EventAddedSignal;
-	typedef boost::signals2::signal<void (Event*)> EventUpdatedSignal;
-	typedef boost::signals2::signal<void (Event*)> EventRemovedSignal;
+	typedef DelegateList<void (const std::vector<Event*>&)> EventsAddedSignal;
+	typedef DelegateList<void (const std::vector<Event*>&)> EventsUpdatedSignal;
+	typedef DelegateList<void (Event*)> EventRemovedSignal;
+	typedef DelegateList<void (Event* pOldEvent, Event* pNewEvent)> EventReplacedSignal;
 
-	boost::signals2::connection ConnectEventAddedSlot(const EventAddedSignal::slot_type& slot);
-	boost::signals2::connection ConnectEventUpdatedSlot(const EventUpdatedSignal::slot_type& slot);
-	boost::signals2::connection ConnectEventRemovedSlot(const EventRemovedSignal::slot_type& slot);
+	void ConnectEventsAddedSlot(const EventsAddedSignal::Slot& slot);
+	void ConnectEventsUpdatedSlot(const EventsUpdatedSignal::Slot& slot);
+	void ConnectEventRemovedSlot(const EventRemovedSignal::Slot& slot);
+	void ConnectEventReplacedSlot(const EventReplacedSignal::Slot& slot);
 
 	std::vector<Event*> GetEvents();
+	Event* GetEventByGUID(const GUID& guid);
 
 	void AddEvent(std::unique_ptr<Event>&& pEvent);
 	void UpdateEvent(Event* pEvent);
 	void RemoveEvent(Event* pEvent);
 
+	// The new event takes the place of the old one, e.g. when an import changes the type of the event.
+	// Reported immediately, unless the old event was added in the current transaction.
+	void ReplaceEvent(Event* pEvent, std::unique_ptr<Event>&& pNewEvent);
+
 	bool CanMoveEventUp(const Event* pEvent) const;
 	bool CanMoveEventDown(const Event* pEvent) const;
 
@@ -53,9 +77,9 @@ public:
 	//////////////////////////////////////////////////////////////////////////
 	// Actions
 
-	typedef boost::signals2::signal<void (ActionList*)> ActionListAddedSignal;
-	typedef boost::signals2::signal<void (ActionList*)> ActionListRemovedSignal;
-	typedef boost::signals2::signal<void (ActionList*)> ActionListUpdatedSignal;
+	typedef DelegateList<void (ActionList*)> ActionListAddedSignal;
+	typedef DelegateList<void (ActionList*)> ActionListRemovedSignal;
+	typedef DelegateList<void (ActionList*)> ActionListUpdatedSignal;
 
 	std::vector<ActionList*> GetActionLists();
 
@@ -65,31 +89,69 @@ public:
 	void RemoveActionList(ActionList* pActionList);
 	void UpdateActionList(ActionList* pActionList);
 
-	boost::signals2::connection ConnectActionListAddedSlot(const ActionListAddedSignal::slot_type& slot);
-	boost::signals2::connection ConnectActionListRemovedSlot(const ActionListRemovedSignal::slot_type& slot);
-	boost::signals2::connection ConnectActionListUpdatedSlot(const ActionListUpdatedSignal::slot_type& slot);
+	// The new action list takes the place of the old one, events linked to it stay linked by GUID.
+	void ReplaceActionList(ActionList* pActionList, std::unique_ptr<ActionList>&& pNewActionList);
 
-	typedef boost::signals2::signal<void (ActionList*, IAction*)> ActionAddedSignal;
-	typedef boost::signals2::signal<void (ActionList*, IAction*)> ActionUpdatedSignal;
-	typedef boost::signals2::signal<void (ActionList*, IAction*)> ActionRemovedSignal;
+	void ConnectActionListAddedSlot(const ActionListAddedSignal::Slot& slot);
+	void ConnectActionListRemovedSlot(const ActionListRemovedSignal::Slot& slot);
+	void ConnectActionListUpdatedSlot(const ActionListUpdatedSignal::Slot& slot);
+
+	typedef DelegateList<void (ActionList*, IAction*)> ActionAddedSignal;
+	typedef DelegateList<void (ActionList*, IAction*)> ActionUpdatedSignal;
+	typedef DelegateList<void (ActionList*, IAction*)> ActionRemovedSignal;
 
 	void AddActionToActionList(ActionList* pActionList, std::unique_ptr<IAction> pAction);
 	void UpdateAction(ActionList* pActionList, IAction* pAction);
 	void RemoveAction(ActionList* pActionList, IAction* pAction);
 
-	boost::signals2::connection ConnectActionAddedSlot(const ActionAddedSignal::slot_type& slot);
-	boost::signals2::connection ConnectActionUpdatedSlot(const ActionUpdatedSignal::slot_type& slot);
-	boost::signals2::connection ConnectActionRemovedSlot(const ActionRemovedSignal::slot_type& slot);
+	void ConnectActionAddedSlot(const ActionAddedSignal::Slot& slot);
+	void ConnectActionUpdatedSlot(const ActionUpdatedSignal::Slot& slot);
+	void ConnectActionRemovedSlot(const ActionRemovedSignal::Slot& slot);
+
+	//////////////////////////////////////////////////////////////////////////
+	// Exception calendars
+
+	const ModelState::CalendarsContainer& GetCalendars() const;
+
+	// Replaces all calendars. Events of a removed calendar stop using it, events using a calendar are reported updated.
+	void SetCalendars(const ModelState::CalendarsContainer& calendars);
 
 private:
 	void MoveEvent(const Event* pEvent, bool up);
+	void RebuildIndexes();
+
+	void BeginTransaction();
+	void CommitTransaction();
+
+	void QueueEventUpdate(Event* pEvent);
+
+	// Events linked to the action list are reported updated when the transaction ends,
+	// so replacing many action lists scans the events once.
+	void QueueLinkedEventsUpdate(const GUID& actionListGUID);
+
+	// Returns true, if the event was added in the current transaction.
+	bool DropPendingEvent(Event* pEvent);
 
 private:
 	ModelState m_modelState;
 
-	EventAddedSignal m_eventAddedSignal;
-	EventUpdatedSignal m_eventUpdatedSignal;
+	// Kept in sync by the add and remove methods.
+	GUIDHelpers::Index<Event>::Type m_eventsIndex;
+	GUIDHelpers::Index<ActionList>::Type m_actionListsIndex;
+
+	// Changes collected by the open transactions.
+	int m_transactionDepth;
+	std::vector<Event*> m_pendingAddedEvents;
+	std::unordered_set<Event*> m_pendingAddedEventsSet;
+	std::vector<Event*> m_pendingUpdatedEvents;
+	std::unordered_set<Event*> m_pendingUpdatedEventsSet;
+	std::unordered_set<GUID, GUIDHelpers::Hash> m_pendingUpdatedActionLists;
+	bool m_modelChangedPending;
+
+	EventsAddedSignal m_eventsAddedSignal;
+	EventsUpdatedSignal m_eventsUpdatedSignal;
 	EventRemovedSignal m_eventRemovedSignal;
+	EventReplacedSignal m_eventReplacedSignal;
 
 	ActionListAddedSignal m_actionListAddedSignal;
 	ActionListRemovedSignal m_actionListRemovedSignal;
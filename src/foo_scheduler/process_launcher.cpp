@@ -0,0 +1,215 @@
+#include "pch.h"
+#include "process_launcher.h"
+
+namespace
+{
+	// Anonymous pipes can't be waited on, the output is polled while the process runs.
+	const DWORD outputPollIntervalMs = 50;
+
+	std::wstring GetLastErrorMessage()
+	{
+		const DWORD errorCode = GetLastError();
+
+		wchar_t* buffer = 0;
+		FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+			NULL, errorCode, 0, reinterpret_cast<LPWSTR>(&buffer), 0, NULL);
+
+		std::wstring result = buffer ? boost::trim_copy(std::wstring(buffer)) :
+			boost::str(boost::wformat(L"Error %1%") % errorCode);
+
+		LocalFree(buffer);
+		return result;
+	}
+}
+
+ProcessLauncher::ProcessLauncher() :
+	m_process(NULL), m_outputRead(NULL), m_stopEvent(CreateEvent(NULL, TRUE, FALSE, NULL))
+{
+}
+
+ProcessLauncher::~ProcessLauncher()
+{
+	SetEvent(m_stopEvent);
+
+	if (m_thread.joinable())
+		m_thread.join();
+
+	CloseHandles();
+	CloseHandle(m_stopEvent);
+}
+
+bool ProcessLauncher::Start(const std::wstring& commandLine, DWORD timeoutMs, bool captureOutput,
+	const CompletionFunc& onCompletion, std::wstring& error)
+{
+	_ASSERTE(!m_thread.joinable());
+
+	STARTUPINFOEXW si = {};
+	si.StartupInfo.cb = sizeof(si);
+
+	HANDLE outputWrite = NULL;
+	std::vector<BYTE> attributeListBuffer;
+
+	if (captureOutput)
+	{
+		SECURITY_ATTRIBUTES sa = { sizeof(sa), NULL, TRUE };
+
+		if (!CreatePipe(&m_outputRead, &outputWrite, &sa, 0))
+		{
+			error = GetLastErrorMessage();
+			return false;
+		}
+
+		SetHandleInformation(m_outputRead, HANDLE_FLAG_INHERIT, 0);
+
+		// Inheriting handles would pass the child every inheritable handle of the player,
+		// the handle list limits it to the write end of the pipe.
+		SIZE_T attributeListSize = 0;
+		InitializeProcThreadAttributeList(NULL, 1, 0, &attributeListSize);
+		attributeListBuffer.resize(attributeListSize);
+
+		si.lpAttributeList = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(&attributeListBuffer[0]);
+
+		if (!InitializeProcThreadAttributeList(si.lpAttributeList, 1, 0, &attributeListSize))
+		{
+			error = GetLastErrorMessage();
+			CloseHandle(outputWrite);
+			CloseHandles();
+			return false;
+		}
+
+		if (!UpdateProcThreadAttribute(si.lpAttributeList, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST,
+			&outputWrite, sizeof(outputWrite), NULL, NULL))
+		{
+			error = GetLastErrorMessage();
+			DeleteProcThreadAttributeList(si.lpAttributeList);
+			CloseHandle(outputWrite);
+			CloseHandles();
+			return false;
+		}
+
+		// Standard handles have to be in the list, the child gets no input.
+		si.StartupInfo.dwFlags |= STARTF_USESTDHANDLES;
+		si.StartupInfo.hStdInput = NULL;
+		si.StartupInfo.hStdOutput = outputWrite;
+		si.StartupInfo.hStdError = outputWrite;
+	}
+
+	// CreateProcess may modify the command line.
+	std::vector<wchar_t> cmdLine(commandLine.begin(), commandLine.end());
+	cmdLine.push_back(L'\0');
+
+	PROCESS_INFORMATION pi = {};
+
+	const BOOL created = CreateProcessW(NULL, &cmdLine[0], NULL, NULL, captureOutput ? TRUE : FALSE,
+		captureOutput ? CREATE_NO_WINDOW | EXTENDED_STARTUPINFO_PRESENT : 0, NULL, NULL, &si.StartupInfo, &pi);
+
+	if (!created)
+		error = GetLastErrorMessage();
+
+	if (si.lpAttributeList)
+		DeleteProcThreadAttributeList(si.lpAttributeList);
+
+	// The child has its own copy, the pipe is closed when the child exits.
+	if (outputWrite)
+		CloseHandle(outputWrite);
+
+	if (!created)
+	{
+		CloseHandles();
+		return false;
+	}
+
+	CloseHandle(pi.hThread);
+	m_process = pi.hProcess;
+	m_onCompletion = onCompletion;
+
+	m_thread = std::thread(&ProcessLauncher::Monitor, this, timeoutMs);
+	return true;
+}
+
+void ProcessLauncher::Monitor(DWORD timeoutMs)
+{
+	Result result;
+
+	const ULONGLONG startTime = GetTickCount64();
+	const HANDLE handles[] = { m_stopEvent, m_process };
+
+	for (;;)
+	{
+		DWORD waitMs = INFINITE;
+
+		if (timeoutMs != 0)
+		{
+			const ULONGLONG elapsed = GetTickCount64() - startTime;
+			waitMs = elapsed < timeoutMs ? static_cast<DWORD>(timeoutMs - elapsed) : 0;
+		}
+
+		if (m_outputRead)
+			waitMs = std::min(waitMs, outputPollIntervalMs);
+
+		const DWORD waitResult = WaitForMultipleObjects(_countof(handles), handles, FALSE, waitMs);
+
+		if (m_outputRead)
+			ReadAvailableOutput(result.output);
+
+		if (waitResult == WAIT_OBJECT_0)
+			return; // Stopped, no completion.
+
+		if (waitResult == WAIT_OBJECT_0 + 1)
+		{
+			GetExitCodeProcess(m_process, &result.exitCode);
+			break;
+		}
+
+		if (waitResult == WAIT_TIMEOUT && timeoutMs != 0 && GetTickCount64() - startTime >= timeoutMs)
+		{
+			result.timedOut = true;
+			break;
+		}
+
+		if (waitResult == WAIT_FAILED)
+		{
+			result.error = GetLastErrorMessage();
+			break;
+		}
+	}
+
+	m_onCompletion(result);
+}
+
+void ProcessLauncher::ReadAvailableOutput(std::string& output)
+{
+	char buffer[4096];
+
+	for (;;)
+	{
+		DWORD available = 0;
+
+		if (!PeekNamedPipe(m_outputRead, NULL, 0, NULL, &available, NULL) || available == 0)
+			return;
+
+		DWORD read = 0;
+
+		if (!ReadFile(m_outputRead, buffer, std::min<DWORD>(available, sizeof(buffer)), &read, NULL) || read == 0)
+			return;
+
+		// The rest is read and dropped, so that the process doesn't block on a full pipe.
+		if (output.size() < maxOutputSize)
+			output.append(buffer, std::min<std::size_t>(read, maxOutputSize - output.size()));
+	}
+}
+
+void ProcessLauncher::CloseHandles()
+{
+	if (m_process)
+	{
+		CloseHandle(m_process);
+		m_process = NULL;
+	}
+
+	if (m_outputRead)
+	{
+		CloseHandle(m_outputRead);
+		m_outputRead = NULL;
+	}
+}
\ No newline at end of file
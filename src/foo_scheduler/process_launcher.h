@@ -0,0 +1,44 @@
+#pragma once
+
+// Starts a process directly (without the shell) and waits for it to exit on a worker thread,
+// optionally reading its standard output.
+class ProcessLauncher : private boost::noncopyable
+{
+public:
+	struct Result
+	{
+		Result() : timedOut(false), exitCode(0) {}
+
+		bool timedOut;    // The process was still running, it's left running.
+		std::wstring error; // Waiting for the process failed, it's left running.
+		DWORD exitCode;
+		std::string output; // Raw bytes in the OEM code page, truncated to maxOutputSize.
+	};
+
+	static const std::size_t maxOutputSize = 64 * 1024;
+
+	// Called on the worker thread.
+	typedef boost::function<void (const Result&)> CompletionFunc;
+
+	ProcessLauncher();
+
+	// Stops waiting and joins the worker thread, the process keeps running.
+	~ProcessLauncher();
+
+	// timeoutMs of 0 means no timeout. Returns false and the system error message if the process
+	// couldn't be started.
+	bool Start(const std::wstring& commandLine, DWORD timeoutMs, bool captureOutput,
+		const CompletionFunc& onCompletion, std::wstring& error);
+
+private:
+	void Monitor(DWORD timeoutMs);
+	void ReadAvailableOutput(std::string& output);
+	void CloseHandles();
+
+private:
+	HANDLE m_process;
+	HANDLE m_outputRead;
+	HANDLE m_stopEvent;
+	std::thread m_thread;
+	CompletionFunc m_onCompletion;
+};
\ No newline at end of file
@@ -17,6 +17,12 @@
 #define IDD_ACTION_LAUNCH_APP_CONFIG    116
 #define IDD_ACTION_WAIT_N_TRACKS        117
 #define IDD_ACTION_WAIT_N_TRACKS_CONFIG 117
+#define IDD_ACTION_SHARED_VARIABLE_CONFIG 129
+#define IDD_CONDITION_CONFIG            130
+#define IDD_ACTION_CONDITION_CONFIG     131
+#define IDD_POSITION_EVENT_CONFIG       132
+#define IDD_ACTION_CALL_TASK_CONFIG     133
+#define IDD_EXCEPTION_CALENDARS         134
 #define IDC_STATIC_GLOBAL_OPTIONS       1001
 #define IDC_BTN_ADD_ACTION_LIST         1003
 #define IDC_BTN_ADD_EVENT               1004
@@ -78,15 +84,51 @@
 #define IDC_STATUS_EVENTS_HEADER        1084
 #define IDC_EVENTS_LIST_HEADER          1084
 #define IDC_CHECK_NTRACKS_EOF           1085
+#define IDC_COMBO_FADE_CURVE            1086
+#define IDC_COMBO_FADE_RESOLUTION       1087
+#define IDC_STATIC_FADE_CURVE           1088
+#define IDC_STATIC_FADE_RESOLUTION      1089
+#define IDC_EDIT_VARIABLE_NAME          1090
+#define IDC_RADIO_VARIABLE_SET          1091
+#define IDC_EDIT_VARIABLE_VALUE         1092
+#define IDC_RADIO_VARIABLE_CLEAR        1093
+#define IDC_RADIO_VARIABLE_STORE_STATE  1094
+#define IDC_RADIO_VARIABLE_RESTORE_STATE 1095
+#define IDC_CHECK_VARIABLE_PERSISTENT   1096
+#define IDC_EDIT_CONDITION              1097
+#define IDC_EDIT_THEN_COUNT             1098
+#define IDC_EDIT_ELSE_COUNT             1099
+#define IDC_EDIT_POSITION               1100
+#define IDC_COMBO_POSITION_ANCHOR       1101
+#define IDC_STATIC_TRACK_QUERY          1102
+#define IDC_EDIT_TRACK_QUERY            1103
+#define IDC_COMBO_CATCH_UP              1104
+#define IDC_CHECK_WAIT_FOR_EXIT         1105
+#define IDC_EDIT_LAUNCH_TIMEOUT         1106
+#define IDC_CHECK_CAPTURE_OUTPUT        1107
+#define IDC_BTN_IMPORT_EXPORT           1108
+#define IDC_COMBO_CONCURRENCY_POLICY    1109
+#define IDC_EDIT_MAX_QUEUE_DEPTH        1110
+#define IDC_SPIN_MAX_QUEUE_DEPTH        1111
+#define IDC_COMBO_TASK_PRIORITY         1112
+#define IDC_COMBO_CALL_TASK             1113
+#define IDC_COMBO_CALENDAR_MODE         1114
+#define IDC_COMBO_CALENDAR              1115
+#define IDC_BTN_EDIT_CALENDARS          1116
+#define IDC_LIST_CALENDARS              1117
+#define IDC_BTN_ADD_CALENDAR            1118
+#define IDC_BTN_REMOVE_CALENDAR         1119
+#define IDC_EDIT_CALENDAR_NAME          1120
+#define IDC_EDIT_CALENDAR_DATES         1121
 
 // Next default values for new objects
 // 
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NO_MFC                     1
-#define _APS_NEXT_RESOURCE_VALUE        129
+#define _APS_NEXT_RESOURCE_VALUE        135
 #define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1086
+#define _APS_NEXT_CONTROL_VALUE         1122
 #define _APS_NEXT_SYMED_VALUE           110
 #endif
 #endif
@@ -3,6 +3,8 @@
 #include "service_manager.h"
 #include "pref_page.h"
 #include "status_window.h"
+#include "metrics.h"
+#include "tracer.h"
 
 RootController::RootController() : m_pStatusWindow(0)
 {
@@ -17,6 +19,7 @@ void RootController::Init()
 	ServiceManager::Instance().GetPlayerEventsManager().Reset();
 	ServiceManager::Instance().GetMenuItemEventsManager().Reset();
 	ServiceManager::Instance().GetDateTimeEventsManager().Reset();
+	ServiceManager::Instance().GetPlaybackPositionEventsManager().Reset();
 }
 
 void RootController::Shutdown()
@@ -24,9 +27,11 @@ void RootController::Shutdown()
 	ServiceManager::Instance().GetPlayerEventsManager().Shutdown();
 	ServiceManager::Instance().GetMenuItemEventsManager().Shutdown();
 	ServiceManager::Instance().GetDateTimeEventsManager().Shutdown();
+	ServiceManager::Instance().GetPlaybackPositionEventsManager().Shutdown();
 
 	StopExecutionSessions();
 
+	ServiceManager::Instance().GetMainThreadExecutor().Shutdown();
 	ServiceManager::Instance().GetTimersManager().Shutdown();
 }
 
@@ -38,20 +43,76 @@ void RootController::ShowPreferencesPage()
 
 void RootController::ProcessEvent(Event* pEvent)
 {
+	Tracer::ScopedSpan span("event", "Process event");
+
 	ActionList* pActionList = ServiceManager::Instance().GetModel().GetActionListByGUID(
 		pEvent->GetActionListGUID());
 
 	std::wstring eventDescription = pEvent->GetDescription();
 
+	// Evaluated before OnSignal, which may change the event. OnSignal is called anyway,
+	// so that the event is rescheduled as if the task has run.
+	const bool conditionMet = !pActionList || pEvent->GetCondition().Evaluate();
+
 	// After calling Event::OnSignal don't call Event's functions, cause it might have been deleted
 	// in OnSignal.
 	pEvent->OnSignal();
+
+	Metrics::Increment(Metrics::counterEventsFired);
 	
 	if (!pActionList)
 		return;
 
-	ActionListExecSessionPtr pSession(new ActionListExecSession(pActionList, eventDescription));
+	if (!conditionMet)
+	{
+		Metrics::Increment(Metrics::counterEventsSkipped);
+		Tracer::RecordInstant("event", "Condition is false");
+		return;
+	}
+
+	ActionListRuns& runs = m_actionListRuns[pActionList->GetGUID()];
+
+	if (runs.running > 0)
+	{
+		switch (pActionList->GetConcurrencyPolicy())
+		{
+		case ConcurrencyPolicy::parallel:
+			break;
+
+		case ConcurrencyPolicy::skipIfRunning:
+			Metrics::Increment(Metrics::counterRunsSkipped);
+			Tracer::RecordInstant("event", "Task is running, run skipped");
+			return;
+
+		case ConcurrencyPolicy::restart:
+			Metrics::Increment(Metrics::counterRunsReplaced);
+			RemoveExecSessionsOfActionList(pActionList->GetGUID());
+			break;
+
+		case ConcurrencyPolicy::queue:
+			if (static_cast<int>(runs.queued.size()) >= pActionList->GetMaxQueueDepth())
+			{
+				Metrics::Increment(Metrics::counterRunsSkipped);
+				Tracer::RecordInstant("event", "Task queue is full, run skipped");
+				return;
+			}
+
+			runs.queued.push_back(eventDescription);
+			Metrics::Increment(Metrics::counterRunsQueued);
+			return;
+		}
+	}
+
+	StartExecSession(pActionList, eventDescription);
+}
+
+void RootController::StartExecSession(ActionList* pActionList, const std::wstring& eventDescription)
+{
+	ActionListExecSessionPtr pSession(new ActionListExecSession(
+		ServiceManager::Instance().GetModel().GetActionListSnapshot(pActionList->GetGUID()), eventDescription));
 	m_execSessions.push_back(pSession);
+	++m_actionListRuns[pActionList->GetGUID()].running;
+	Metrics::SetGauge(Metrics::gaugeExecSessions, m_execSessions.size());
 
 	m_actionListExecSessionAddedSignal(pSession.get());
 
@@ -65,12 +126,61 @@ void RootController::RemoveExecSession(ActionListExecSession* pSession)
 		{
 			ActionListExecSessionPtr pExecSession = m_execSessions[i];
 			m_execSessions.erase(m_execSessions.begin() + i);
+			Metrics::SetGauge(Metrics::gaugeExecSessions, m_execSessions.size());
 
 			m_actionListExecSessionRemovedSignal(pExecSession.get());
+			RetireExecSession(pExecSession);
+
+			StartQueuedRun(pExecSession->GetActionListGUID());
 			return;
 		}
 }
 
+void RootController::RemoveExecSessionsOfActionList(const GUID& actionListGUID)
+{
+	for (auto it = m_execSessions.begin(); it != m_execSessions.end();)
+	{
+		ActionListExecSessionPtr sessionPtr = *it;
+
+		if (sessionPtr->GetActionListGUID() != actionListGUID)
+		{
+			++it;
+			continue;
+		}
+
+		it = m_execSessions.erase(it);
+		m_actionListExecSessionRemovedSignal(sessionPtr.get());
+		RetireExecSession(sessionPtr);
+	}
+
+	Metrics::SetGauge(Metrics::gaugeExecSessions, m_execSessions.size());
+}
+
+void RootController::StartQueuedRun(const GUID& actionListGUID)
+{
+	auto it = m_actionListRuns.find(actionListGUID);
+
+	if (it == m_actionListRuns.end())
+		return;
+
+	ActionListRuns& runs = it->second;
+
+	if (runs.running == 0 && !runs.queued.empty())
+	{
+		const std::wstring eventDescription = runs.queued.front();
+		runs.queued.pop_front();
+
+		// The action list might have been removed since the run was queued.
+		if (ActionList* pActionList = ServiceManager::Instance().GetModel().GetActionListByGUID(actionListGUID))
+			StartExecSession(pActionList, eventDescription);
+		else
+			runs.queued.clear();
+	}
+
+	if (runs.running == 0 && runs.queued.empty())
+		m_actionListRuns.erase(it);
+}
+
 void RootController::RemoveAllExecSessions()
 {
 	RemoveAllExecSessionsBut(nullptr);
@@ -78,6 +188,10 @@ void RootController::RemoveAllExecSessions()
 
 void RootController::RemoveAllExecSessionsBut(ActionListExecSession *session)
 {
+	// Queued runs are stopped as well.
+	for (auto it = m_actionListRuns.begin(); it != m_actionListRuns.end(); ++it)
+		it->second.queued.clear();
+
 	for (auto it = m_execSessions.begin(); it != m_execSessions.end();)
 	{
 		ActionListExecSessionPtr sessionPtr = *it;
@@ -92,13 +206,58 @@ void RootController::RemoveAllExecSessionsBut(ActionListExecSession *session)
 			// Remove session.
 			it = m_execSessions.erase(it);
 			m_actionListExecSessionRemovedSignal(sessionPtr.get());
+			RetireExecSession(sessionPtr);
 		}
 	}
+
+	for (auto it = m_actionListRuns.begin(); it != m_actionListRuns.end();)
+	{
+		if (it->second.running == 0)
+			it = m_actionListRuns.erase(it);
+		else
+			++it;
+	}
+
+	Metrics::SetGauge(Metrics::gaugeExecSessions, m_execSessions.size());
 }
 
 void RootController::StopExecutionSessions()
 {
+	for (std::size_t i = 0; i < m_execSessions.size(); ++i)
+		m_execSessions[i]->Cancel();
+
 	m_execSessions.clear();
+	m_actionListRuns.clear();
+	m_retiredExecSessions.clear();
+	Metrics::SetGauge(Metrics::gaugeExecSessions, 0);
+}
+
+void RootController::RetireExecSession(const ActionListExecSessionPtr& pSession)
+{
+	// Cancelling only closes timers and signals workers, the rest of the teardown
+	// (the sessions' destructors) is left for a later main thread call.
+	pSession->Cancel();
+
+	auto it = m_actionListRuns.find(pSession->GetActionListGUID());
+	_ASSERTE(it != m_actionListRuns.end() && it->second.running > 0);
+
+	if (it != m_actionListRuns.end())
+		--it->second.running;
+
+	if (m_retiredExecSessions.empty())
+	{
+		AsyncCall::AsyncRunInMainThread(AsyncCall::MakeCallback(
+			boost::bind(&RootController::ReleaseRetiredExecSessions, this)));
+	}
+
+	m_retiredExecSessions.push_back(pSession);
+}
+
+void RootController::ReleaseRetiredExecSessions()
+{
+	// Sessions retired while these are destroyed get the next call.
+	std::vector<ActionListExecSessionPtr> sessions;
+	sessions.swap(m_retiredExecSessions);
 }
 
 void RootController::ShowStatusWindow()
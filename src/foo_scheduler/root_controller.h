@@ -2,6 +2,7 @@
 
 #include "event.h"
 #include "action_list_exec_session.h"
+#include "guid_helpers.h"
 
 class DateTimeEvent;
 class MenuItemEvent;
@@ -23,6 +24,7 @@ public:
 
 	void UpdateExecSession(const ActionListExecSessionPtr& pSession);
 	void RemoveExecSession(ActionListExecSession* pSession);
+	// Sessions are cancelled and removed at once, they are destroyed later in the main thread.
 	void RemoveAllExecSessions();
 	void RemoveAllExecSessionsBut(ActionListExecSession* session);
 	std::vector<ActionListExecSession*> GetActionListExecSessions();
@@ -42,10 +44,32 @@ public:
 
 private:
 	void StopExecutionSessions();
+	void StartExecSession(ActionList* pActionList, const std::wstring& eventDescription);
+	void RemoveExecSessionsOfActionList(const GUID& actionListGUID);
+	void StartQueuedRun(const GUID& actionListGUID);
+	void RetireExecSession(const ActionListExecSessionPtr& pSession);
+	void ReleaseRetiredExecSessions();
 	void ClearStatusWindowPtr();
 
 private:
 	std::vector<ActionListExecSessionPtr> m_execSessions;
+
+	// Runs of an action list, used by its concurrency policy.
+	struct ActionListRuns
+	{
+		ActionListRuns() : running(0) {}
+
+		int running;
+
+		// Event descriptions of the runs waiting with the queue policy.
+		std::deque<std::wstring> queued;
+	};
+
+	// Only action lists with running or queued runs.
+	std::unordered_map<GUID, ActionListRuns, GUIDHelpers::Hash> m_actionListRuns;
+
+	// Cancelled sessions waiting to be destroyed.
+	std::vector<ActionListExecSessionPtr> m_retiredExecSessions;
 	StatusWindow* m_pStatusWindow;
 
 	ActionListExecSessionAdded m_actionListExecSessionAddedSignal;
@@ -23,11 +23,460 @@ S11nBlocks::Exception Exception::RequiredFieldNotSet(int fieldID)
 	return Exception(boost::str(boost::wformat(L"Required field with id = %1% doesn't exist") % fieldID));
 }
 
+S11nBlocks::Exception Exception::LimitExceeded()
+{
+	return Exception(L"Data exceeds parse limits");
+}
+
+S11nBlocks::Exception Exception::EncodingMismatch()
+{
+	return Exception(L"Serialized block is in another encoding");
+}
+
 std::wstring Exception::GetMessage() const
 {
 	return m_msg;
 }
 
+namespace
+{
+	// Parsing is done from the main thread only.
+	ParseLimits s_parseLimits;
+
+	// Upper bound of bytes left in the stream being parsed. Fields are parsed from buffers
+	// of known size, so it gets tighter with each nested block.
+	t_size s_bytesBound = ParseLimits().maxStreamSize;
+
+	class BytesBoundScope : boost::noncopyable
+	{
+	public:
+		explicit BytesBoundScope(t_size bound) : m_previousBound(s_bytesBound)
+		{
+			s_bytesBound = std::min(bound, s_bytesBound);
+		}
+
+		~BytesBoundScope()
+		{
+			s_bytesBound = m_previousBound;
+		}
+
+	private:
+		t_size m_previousBound;
+	};
+
+	// Reads a block written as a length followed by the bytes.
+	void ReadSizedByteBlock(foobar_stream_reader& input, t_uint32 size, ByteBuffer& buffer)
+	{
+		if (size > s_bytesBound)
+			throw Exception::LimitExceeded();
+
+		buffer.set_size(size);
+
+		try
+		{
+			input.read_raw(buffer.get_ptr(), size);
+		}
+		catch (exception_io&)
+		{
+			throw Exception::StreamReadError();
+		}
+	}
+
+	void ReadCompactByteBlock(foobar_stream_reader& input, ByteBuffer& buffer)
+	{
+		ReadSizedByteBlock(input, ReadVarUInt(input), buffer);
+	}
+}
+
+//------------------------------------------------------------------------------
+// ParseLimitsScope
+//------------------------------------------------------------------------------
+
+ParseLimitsScope::ParseLimitsScope(const ParseLimits& limits, t_size streamSize) :
+	m_previousLimits(s_parseLimits), m_previousBytesBound(s_bytesBound)
+{
+	s_parseLimits = limits;
+	s_bytesBound = streamSize != 0 ? std::min(streamSize, limits.maxStreamSize) : limits.maxStreamSize;
+}
+
+ParseLimitsScope::~ParseLimitsScope()
+{
+	s_parseLimits = m_previousLimits;
+	s_bytesBound = m_previousBytesBound;
+}
+
+//------------------------------------------------------------------------------
+// EncodingContext
+//------------------------------------------------------------------------------
+
+// Serialization is done from the main thread only.
+EncodingContext* EncodingContext::s_pCurrent = 0;
+
+void EncodingContext::Clear()
+{
+	m_strings.clear();
+	m_stringIndices.clear();
+	m_guids.clear();
+	m_guidIndices.clear();
+}
+
+t_uint32 EncodingContext::InternString(const pfc::string8& str)
+{
+	auto result = m_stringIndices.insert(std::make_pair(
+		std::string(str.get_ptr(), str.length()), static_cast<t_uint32>(m_strings.size())));
+
+	if (result.second)
+		m_strings.push_back(str);
+
+	return result.first->second;
+}
+
+t_uint32 EncodingContext::InternGUID(const GUID& guid)
+{
+	auto result = m_guidIndices.insert(std::make_pair(guid, static_cast<t_uint32>(m_guids.size())));
+
+	if (result.second)
+		m_guids.push_back(guid);
+
+	return result.first->second;
+}
+
+const pfc::string8& EncodingContext::GetString(t_uint32 index) const
+{
+	if (index >= m_strings.size())
+		throw Exception::StreamReadError();
+
+	return m_strings[index];
+}
+
+const GUID& EncodingContext::GetGUID(t_uint32 index) const
+{
+	if (index >= m_guids.size())
+		throw Exception::StreamReadError();
+
+	return m_guids[index];
+}
+
+void EncodingContext::ReadTables(foobar_stream_reader& input)
+{
+	Clear();
+
+	const t_uint32 numStrings = ReadVarUInt(input);
+	CheckElementCount(numStrings);
+
+	for (t_uint32 i = 0; i < numStrings; ++i)
+	{
+		ByteBuffer buffer;
+		ReadCompactByteBlock(input, buffer);
+
+		pfc::string8 str;
+		str.set_string(reinterpret_cast<const char*>(buffer.get_ptr()), buffer.get_size());
+		InternString(str);
+	}
+
+	const t_uint32 numGUIDs = ReadVarUInt(input);
+	CheckElementCount(numGUIDs);
+
+	for (t_uint32 i = 0; i < numGUIDs; ++i)
+	{
+		GUID guid = pfc::guid_null;
+
+		try
+		{
+			input >> guid;
+		}
+		catch (exception_io&)
+		{
+			throw Exception::StreamReadError();
+		}
+
+		InternGUID(guid);
+	}
+
+	// Duplicates would shift the indices of the following entries.
+	if (m_strings.size() != numStrings || m_guids.size() != numGUIDs)
+		throw Exception::StreamReadError();
+}
+
+void EncodingContext::WriteTables(foobar_stream_writer& output) const
+{
+	WriteVarUInt(output, static_cast<t_uint32>(m_strings.size()));
+
+	for (std::size_t i = 0; i < m_strings.size(); ++i)
+	{
+		WriteVarUInt(output, static_cast<t_uint32>(m_strings[i].length()));
+		output.write_raw(m_strings[i].get_ptr(), m_strings[i].length());
+	}
+
+	WriteVarUInt(output, static_cast<t_uint32>(m_guids.size()));
+
+	for (std::size_t i = 0; i < m_guids.size(); ++i)
+		output << m_guids[i];
+}
+
+EncodingContext* EncodingContext::GetCurrent()
+{
+	return s_pCurrent;
+}
+
+//------------------------------------------------------------------------------
+// EncodingScope
+//------------------------------------------------------------------------------
+
+EncodingScope::EncodingScope(EncodingContext* pContext) : m_pPrevious(EncodingContext::s_pCurrent)
+{
+	EncodingContext::s_pCurrent = pContext;
+}
+
+EncodingScope::~EncodingScope()
+{
+	EncodingContext::s_pCurrent = m_pPrevious;
+}
+
+//------------------------------------------------------------------------------
+// Encoding primitives
+//------------------------------------------------------------------------------
+
+void WriteVarUInt(foobar_stream_writer& output, t_uint32 value)
+{
+	while (value >= 0x80)
+	{
+		output << static_cast<t_uint8>(value | 0x80);
+		value >>= 7;
+	}
+
+	output << static_cast<t_uint8>(value);
+}
+
+t_uint32 ReadVarUInt(foobar_stream_reader& input)
+{
+	t_uint32 value = 0;
+
+	try
+	{
+		for (int shift = 0; shift < 35; shift += 7)
+		{
+			t_uint8 byte = 0;
+			input >> byte;
+
+			// The 5th byte may only hold the 4 highest bits.
+			if (shift == 28 && byte > 0x0F)
+				break;
+
+			value |= static_cast<t_uint32>(byte & 0x7F) << shift;
+
+			if ((byte & 0x80) == 0)
+				return value;
+		}
+	}
+	catch (exception_io&)
+	{
+	}
+
+	throw Exception::StreamReadError();
+}
+
+void WriteCount(foobar_stream_writer& output, t_uint32 count)
+{
+	if (EncodingContext::GetCurrent())
+		WriteVarUInt(output, count);
+	else
+		output << count;
+}
+
+t_uint32 ReadCount(foobar_stream_reader& input)
+{
+	if (EncodingContext::GetCurrent())
+		return ReadVarUInt(input);
+
+	t_uint32 count = 0;
+
+	try
+	{
+		input >> count;
+	}
+	catch (exception_io&)
+	{
+		throw Exception::StreamReadError();
+	}
+
+	return count;
+}
+
+void WriteByteBlock(foobar_stream_writer& output, const ByteBuffer& buffer)
+{
+	if (EncodingContext::GetCurrent())
+	{
+		WriteVarUInt(output, static_cast<t_uint32>(buffer.get_size()));
+		output.write_raw(buffer.get_ptr(), buffer.get_size());
+	}
+	else
+	{
+		output.write_byte_block(buffer);
+	}
+}
+
+void ReadByteBlock(foobar_stream_reader& input, ByteBuffer& buffer)
+{
+	if (EncodingContext::GetCurrent())
+	{
+		ReadCompactByteBlock(input, buffer);
+		return;
+	}
+
+	t_uint32 size = 0;
+
+	try
+	{
+		input >> size;
+	}
+	catch (exception_io&)
+	{
+		throw Exception::StreamReadError();
+	}
+
+	ReadSizedByteBlock(input, size, buffer);
+}
+
+void CheckElementCount(t_uint32 count)
+{
+	// Any element takes at least one byte in either encoding.
+	if (count > s_parseLimits.maxElements || count > s_bytesBound)
+		throw Exception::LimitExceeded();
+}
+
+//------------------------------------------------------------------------------
+// SerializeOperations
+//------------------------------------------------------------------------------
+
+void SerializeOperations<pfc::string8, false>::ParseFromStream(foobar_stream_reader& input, pfc::string8& value)
+{
+	if (EncodingContext* pContext = EncodingContext::GetCurrent())
+	{
+		value = pContext->GetString(ReadVarUInt(input));
+		return;
+	}
+
+	try
+	{
+		input >> value;
+	}
+	catch (exception_io&)
+	{
+		throw Exception::StreamReadError();
+	}
+}
+
+void SerializeOperations<pfc::string8, false>::SerializeToStream(foobar_stream_writer& output, const pfc::string8& value)
+{
+	if (EncodingContext* pContext = EncodingContext::GetCurrent())
+		WriteVarUInt(output, pContext->InternString(value));
+	else
+		output << value;
+}
+
+void SerializeOperations<GUID, false>::ParseFromStream(foobar_stream_reader& input, GUID& value)
+{
+	if (EncodingContext* pContext = EncodingContext::GetCurrent())
+	{
+		value = pContext->GetGUID(ReadVarUInt(input));
+		return;
+	}
+
+	try
+	{
+		input >> value;
+	}
+	catch (exception_io&)
+	{
+		throw Exception::StreamReadError();
+	}
+}
+
+void SerializeOperations<GUID, false>::SerializeToStream(foobar_stream_writer& output, const GUID& value)
+{
+	if (EncodingContext* pContext = EncodingContext::GetCurrent())
+		WriteVarUInt(output, pContext->InternGUID(value));
+	else
+		output << value;
+}
+
+//------------------------------------------------------------------------------
+// SerializedBlock
+//------------------------------------------------------------------------------
+
+namespace
+{
+	boost::shared_ptr<EncodingContext> GetCurrentContextRef()
+	{
+		EncodingContext* pContext = EncodingContext::GetCurrent();
+		return pContext ? pContext->shared_from_this() : boost::shared_ptr<EncodingContext>();
+	}
+}
+
+SerializedBlock::SerializedBlock()
+{
+
+}
+
+SerializedBlock::SerializedBlock(const ByteBuffer& data) :
+	m_pData(new ByteBuffer(data)), m_pContext(GetCurrentContextRef())
+{
+
+}
+
+bool SerializedBlock::IsEmpty() const
+{
+	return !m_pData;
+}
+
+bool SerializedBlock::IsInCurrentEncoding() const
+{
+	return m_pContext.get() == EncodingContext::GetCurrent();
+}
+
+bool SerializedBlock::IsSameAs(const SerializedBlock& rhs) const
+{
+	if (IsEmpty() || rhs.IsEmpty())
+		return IsEmpty() && rhs.IsEmpty();
+
+	return m_pContext == rhs.m_pContext && m_pData->get_size() == rhs.m_pData->get_size() &&
+		memcmp(m_pData->get_ptr(), rhs.m_pData->get_ptr(), m_pData->get_size()) == 0;
+}
+
+void SerializedBlock::ParseFromStream(foobar_stream_reader& input)
+{
+	// A block has no length prefix, so its fields are walked to find where it ends.
+	foobar_stream_buffer_writer bufferStream;
+
+	const t_uint32 numFields = ReadCount(input);
+	CheckElementCount(numFields);
+	WriteCount(bufferStream, numFields);
+
+	for (t_uint32 i = 0; i < numFields; ++i)
+	{
+		WriteCount(bufferStream, ReadCount(input));
+
+		ByteBuffer buffer;
+		ReadByteBlock(input, buffer);
+		WriteByteBlock(bufferStream, buffer);
+	}
+
+	m_pData.reset(new ByteBuffer(bufferStream.m_buffer));
+	m_pContext = GetCurrentContextRef();
+}
+
+void SerializedBlock::SerializeToStream(foobar_stream_writer& output) const
+{
+	_ASSERTE(!IsEmpty());
+
+	// Its strings and GUIDs would be read from the wrong tables.
+	if (!IsInCurrentEncoding())
+		throw Exception::EncodingMismatch();
+
+	output.write_raw(m_pData->get_ptr(), m_pData->get_size());
+}
+
 //------------------------------------------------------------------------------
 // ArchiveImpl
 //------------------------------------------------------------------------------
@@ -64,7 +513,7 @@ void ArchiveImpl::SaveToStream(foobar_stream_writer& output)
 			throw Exception::RequiredFieldNotSet(m_fields[i]->GetID());
 	}
 
-	output << numFields;
+	WriteCount(output, numFields);
 
 	for (std::size_t i = 0; i < m_fields.size(); ++i)
 	{
@@ -73,81 +522,55 @@ void ArchiveImpl::SaveToStream(foobar_stream_writer& output)
 		if (!pField->Exists())
 			continue;
 
-		output << pField->GetID();
+		WriteCount(output, static_cast<t_uint32>(pField->GetID()));
 
 		// Writing to byte buffer instead of writing directly to stream, to allow reading fields without
 		// parsing them.
 		foobar_stream_buffer_writer bufferStream;
 		pField->SerializeToStream(bufferStream);
 
-		output.write_byte_block(bufferStream.m_buffer);
+		WriteByteBlock(output, bufferStream.m_buffer);
 	}
 }
 
 void ArchiveImpl::LoadFromStream(foobar_stream_reader& input)
 {
-	unsigned int numFields = 0;
+	const unsigned int numFields = ReadCount(input);
+	CheckElementCount(numFields);
 
-	try
-	{
-		input >> numFields;
-	}
-	catch (exception_io&)
-	{
-		throw Exception::StreamReadError();
-	}
-
-	// Creating map of all existing fields.
-	std::map<int, ByteBuffer> fieldsMap;
+	// Fields are parsed as they are read, each from its own buffer, so only one is held at a time.
+	std::vector<int> parsedIDs;
 
 	for (unsigned int i = 0; i < numFields; ++i)
 	{
-		int fieldID = -1;
-
-		try
-		{
-			input >> fieldID;
-		}
-		catch (exception_io&)
-		{
-			throw Exception::StreamReadError();
-		}		
+		const int fieldID = static_cast<int>(ReadCount(input));
 
 		// Reading field without parsing its structure.
 		ByteBuffer buffer;
+		ReadByteBlock(input, buffer);
 
-		try
-		{
-			input.read_byte_block(buffer);
-		}
-		catch (exception_io&)
-		{
-			throw Exception::StreamReadError();
-		}	
+		IField* pField = FindFieldWithID(fieldID);
+
+		// Found unknown id or a repeated one, ignore.
+		if (pField == 0 || std::find(parsedIDs.begin(), parsedIDs.end(), fieldID) != parsedIDs.end())
+			continue;
 
-		fieldsMap.insert(std::make_pair(fieldID, buffer));
+		BytesBoundScope bound(buffer.get_size());
+
+		foobar_stream_buffer_reader bufferStream(buffer);
+		pField->ParseFromStream(bufferStream);
+
+		parsedIDs.push_back(fieldID);
 	}
 
 	// Check whether all required fields are read.
 	for (std::size_t i = 0; i < m_fields.size(); ++i)
 	{
-		auto it = fieldsMap.find(m_fields[i]->GetID());
-
-		// If a field is required but not found, exit.
-		if (m_fields[i]->Required() && it == fieldsMap.end())
+		if (m_fields[i]->Required() &&
+			std::find(parsedIDs.begin(), parsedIDs.end(), m_fields[i]->GetID()) == parsedIDs.end())
+		{
 			throw Exception::RequiredFieldNotSet(m_fields[i]->GetID());
-	}
-
-	for (auto it = fieldsMap.begin(); it != fieldsMap.end(); ++it)
-	{
-		IField* pField = FindFieldWithID(it->first);
-
-		// Found unknown id, ignore.
-		if (pField == 0)
-			continue;
-
-		foobar_stream_buffer_reader bufferStream(it->second);
-		pField->ParseFromStream(bufferStream);
+		}
 	}
 }
 
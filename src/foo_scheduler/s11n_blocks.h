@@ -1,6 +1,7 @@
 #pragma once
 
 #include "foobar_stream.h"
+#include "guid_helpers.h"
 
 namespace S11nBlocks
 {
@@ -16,6 +17,8 @@ class Exception
 public:
 	static Exception StreamReadError();
 	static Exception RequiredFieldNotSet(int fieldID);
+	static Exception LimitExceeded();
+	static Exception EncodingMismatch();
 	std::wstring GetMessage() const;
 
 private:
@@ -25,6 +28,102 @@ private:
 	std::wstring m_msg;
 };
 
+//------------------------------------------------------------------------------
+// ParseLimits
+//------------------------------------------------------------------------------
+
+// Bounds checked while parsing, so that a corrupted stream is rejected before it allocates memory.
+struct ParseLimits
+{
+	ParseLimits() : maxStreamSize(64 * 1024 * 1024), maxElements(1024 * 1024) {}
+
+	// Upper bound of the top-level stream size.
+	t_size maxStreamSize;
+
+	// Upper bound of elements in one RepeatedField.
+	t_uint32 maxElements;
+};
+
+// Applies the limits to parsing during its lifetime.
+// streamSize is the size of the top-level stream or 0 if it is unknown.
+class ParseLimitsScope : boost::noncopyable
+{
+public:
+	ParseLimitsScope(const ParseLimits& limits, t_size streamSize);
+	~ParseLimitsScope();
+
+private:
+	ParseLimits m_previousLimits;
+	t_size m_previousBytesBound;
+};
+
+//------------------------------------------------------------------------------
+// EncodingContext
+//------------------------------------------------------------------------------
+
+// String table and GUID dictionary of the compact encoding.
+// While an EncodingScope with a context is active, field ids, lengths and counts are written as varints,
+// strings and GUIDs as indices into the tables. The tables are stored ahead of the blocks using them.
+// Owned by a boost::shared_ptr, blocks serialized with the context keep it alive.
+class EncodingContext : public boost::enable_shared_from_this<EncodingContext>
+{
+public:
+	void Clear();
+
+	t_uint32 InternString(const pfc::string8& str);
+	t_uint32 InternGUID(const GUID& guid);
+
+	// Throw Exception if the index is out of range.
+	const pfc::string8& GetString(t_uint32 index) const;
+	const GUID& GetGUID(t_uint32 index) const;
+
+	// Throws Exception.
+	void ReadTables(foobar_stream_reader& input);
+	void WriteTables(foobar_stream_writer& output) const;
+
+	// Returns 0 if the original encoding is used.
+	static EncodingContext* GetCurrent();
+
+private:
+	friend class EncodingScope;
+	static EncodingContext* s_pCurrent;
+
+	std::vector<pfc::string8> m_strings;
+	std::map<std::string, t_uint32> m_stringIndices;
+
+	std::vector<GUID> m_guids;
+	std::map<GUID, t_uint32, GUIDHelpers::Less> m_guidIndices;
+};
+
+class EncodingScope : boost::noncopyable
+{
+public:
+	// pContext == 0 selects the original encoding.
+	explicit EncodingScope(EncodingContext* pContext);
+	~EncodingScope();
+
+private:
+	EncodingContext* m_pPrevious;
+};
+
+//------------------------------------------------------------------------------
+// Encoding primitives
+//------------------------------------------------------------------------------
+
+// Read functions throw Exception.
+void WriteVarUInt(foobar_stream_writer& output, t_uint32 value);
+t_uint32 ReadVarUInt(foobar_stream_reader& input);
+
+// Field counts, field ids and element counts.
+void WriteCount(foobar_stream_writer& output, t_uint32 count);
+t_uint32 ReadCount(foobar_stream_reader& input);
+
+// Throws Exception if count elements can't be stored in the data left to parse.
+void CheckElementCount(t_uint32 count);
+
+void WriteByteBlock(foobar_stream_writer& output, const ByteBuffer& buffer);
+void ReadByteBlock(foobar_stream_reader& input, ByteBuffer& buffer);
+
 //------------------------------------------------------------------------------
 // IStreamSerializable
 //------------------------------------------------------------------------------
@@ -39,6 +138,61 @@ protected:
 	~IStreamSerializable() {}
 };
 
+//------------------------------------------------------------------------------
+// SerializedBlock
+//------------------------------------------------------------------------------
+
+// Keeps a block in its serialized form. Writing it back to a stream is a plain copy of bytes,
+// so unchanged blocks don't have to be serialized again. Copies share the same data.
+// The bytes are in the encoding that was current when the block was created,
+// the block holds a reference to its encoding context, so it can be parsed after the owner has replaced the context.
+class SerializedBlock : public IStreamSerializable
+{
+public:
+	SerializedBlock();
+
+	template<class T>
+	static SerializedBlock FromBlock(const T& block)
+	{
+		foobar_stream_buffer_writer bufferStream;
+		block.SerializeToStream(bufferStream);
+
+		return SerializedBlock(bufferStream.m_buffer);
+	}
+
+	bool IsEmpty() const;
+
+	// Returns true, if the block can be copied as-is into a stream of the current encoding.
+	bool IsInCurrentEncoding() const;
+
+	// Returns true, if both blocks hold the same bytes in the same encoding.
+	bool IsSameAs(const SerializedBlock& rhs) const;
+
+	// Throws Exception.
+	template<class T>
+	void ParseBlock(T& block) const
+	{
+		_ASSERTE(!IsEmpty());
+
+		EncodingScope scope(m_pContext.get());
+		foobar_stream_buffer_reader bufferStream(*m_pData);
+		block.ParseFromStream(bufferStream);
+	}
+
+public:
+	virtual void ParseFromStream(foobar_stream_reader& input);
+
+	// Throws Exception if the block isn't in the current encoding.
+	virtual void SerializeToStream(foobar_stream_writer& output) const;
+
+private:
+	explicit SerializedBlock(const ByteBuffer& data);
+
+private:
+	boost::shared_ptr<const ByteBuffer> m_pData;
+	boost::shared_ptr<EncodingContext> m_pContext; // Null in the original encoding.
+};
+
 //------------------------------------------------------------------------------
 // IField
 //------------------------------------------------------------------------------
@@ -90,6 +244,21 @@ struct SerializeOperations<T, true>
 	}
 };
 
+// Strings and GUIDs are written as table indices in the compact encoding.
+template<>
+struct SerializeOperations<pfc::string8, false>
+{
+	static void ParseFromStream(foobar_stream_reader& input, pfc::string8& value);
+	static void SerializeToStream(foobar_stream_writer& output, const pfc::string8& value);
+};
+
+template<>
+struct SerializeOperations<GUID, false>
+{
+	static void ParseFromStream(foobar_stream_reader& input, GUID& value);
+	static void SerializeToStream(foobar_stream_writer& output, const GUID& value);
+};
+
 //------------------------------------------------------------------------------
 // Field
 //------------------------------------------------------------------------------
@@ -202,23 +371,18 @@ public:
 
 	virtual void ParseFromStream(foobar_stream_reader& input)
 	{
-		int size = 0;
-		
-		try
-		{
-			input >> size;
-		}
-		catch (exception_io&)
-		{
-			throw Exception::StreamReadError();
-		}		
+		const t_uint32 size = ReadCount(input);
+		CheckElementCount(size);
 
-		m_container.resize(size);
+		// Growing with each parsed element, a truncated stream fails before the declared size is allocated.
+		m_container.clear();
 
-		for (std::size_t i = 0; i < m_container.size(); ++i)
+		for (t_uint32 i = 0; i < size; ++i)
 		{
+			m_container.resize(m_container.size() + 1);
+
 			SerializeOperations<T, boost::is_base_of<IStreamSerializable, T>::value>::
-				ParseFromStream(input, m_container[i]);
+				ParseFromStream(input, m_container.back());
 		}
 
 		m_exists = true;
@@ -226,7 +390,7 @@ public:
 
 	virtual void SerializeToStream(foobar_stream_writer& output) const
 	{
-		output << static_cast<int>(m_container.size());
+		WriteCount(output, static_cast<t_uint32>(m_container.size()));
 
 		for (std::size_t i = 0; i < m_container.size(); ++i)
 		{
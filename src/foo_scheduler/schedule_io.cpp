@@ -0,0 +1,865 @@
+#include "pch.h"
+#include "schedule_io.h"
+#include "pref_page_model.h"
+#include "service_manager.h"
+#include "event_s11n_block.h"
+#include "action_list_s11n_block.h"
+#include "generate_duplicate_name.h"
+
+namespace ScheduleIO
+{
+
+namespace
+{
+	const t_size fileBufferSize = 64 * 1024;
+
+	//------------------------------------------------------------------------------
+	// Line streams
+	//------------------------------------------------------------------------------
+
+	class LineWriter : boost::noncopyable
+	{
+	public:
+		explicit LineWriter(const file::ptr& pFile) : m_pFile(pFile)
+		{
+			m_buffer.reserve(fileBufferSize * 2);
+		}
+
+		void WriteLine(const std::string& line)
+		{
+			m_buffer += line;
+			m_buffer += '\n';
+
+			if (m_buffer.size() >= fileBufferSize)
+				Flush();
+		}
+
+		void Flush()
+		{
+			m_pFile->write(m_buffer.data(), m_buffer.size(), fb2k::noAbort);
+			m_buffer.clear();
+		}
+
+	private:
+		file::ptr m_pFile;
+		std::string m_buffer;
+	};
+
+	class LineReader : boost::noncopyable
+	{
+	public:
+		explicit LineReader(const file::ptr& pFile) : m_pFile(pFile), m_buffer(fileBufferSize), m_pos(0), m_size(0),
+			m_firstLine(true)
+		{
+		}
+
+		// Returns false at the end of the file. Line breaks are not included.
+		bool ReadLine(std::string& line)
+		{
+			line.clear();
+
+			for (;;)
+			{
+				if (m_pos == m_size)
+				{
+					m_size = m_pFile->read(&m_buffer[0], m_buffer.size(), fb2k::noAbort);
+					m_pos = 0;
+
+					if (m_size == 0)
+						return Finish(line, !line.empty());
+				}
+
+				const char* pBegin = &m_buffer[0] + m_pos;
+				const char* pEnd = &m_buffer[0] + m_size;
+				const char* pNewLine = std::find(pBegin, pEnd, '\n');
+
+				line.append(pBegin, pNewLine);
+				m_pos = pNewLine - &m_buffer[0];
+
+				if (pNewLine != pEnd)
+				{
+					++m_pos;
+					return Finish(line, true);
+				}
+			}
+		}
+
+	private:
+		bool Finish(std::string& line, bool result)
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			// UTF-8 byte order mark.
+			if (m_firstLine && line.compare(0, 3, "\xEF\xBB\xBF") == 0)
+				line.erase(0, 3);
+
+			m_firstLine = false;
+			return result;
+		}
+
+	private:
+		file::ptr m_pFile;
+		std::vector<char> m_buffer;
+		t_size m_pos;
+		t_size m_size;
+		bool m_firstLine;
+	};
+
+	//------------------------------------------------------------------------------
+	// JSON
+	//------------------------------------------------------------------------------
+
+	void AppendJsonString(std::string& out, const char* str)
+	{
+		out += '"';
+
+		for (const char* p = str; *p != 0; ++p)
+		{
+			const unsigned char c = static_cast<unsigned char>(*p);
+
+			switch (c)
+			{
+			case '"':
+				out += "\\\"";
+				break;
+
+			case '\\':
+				out += "\\\\";
+				break;
+
+			case '\n':
+				out += "\\n";
+				break;
+
+			case '\r':
+				out += "\\r";
+				break;
+
+			case '\t':
+				out += "\\t";
+				break;
+
+			default:
+				if (c < 0x20)
+					out += boost::str(boost::format("\\u%04x") % static_cast<int>(c));
+				else
+					out += *p;
+			}
+		}
+
+		out += '"';
+	}
+
+	void AppendUtf8(std::string& out, unsigned int codePoint)
+	{
+		if (codePoint < 0x80)
+		{
+			out += static_cast<char>(codePoint);
+		}
+		else if (codePoint < 0x800)
+		{
+			out += static_cast<char>(0xC0 | (codePoint >> 6));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			out += static_cast<char>(0xE0 | (codePoint >> 12));
+			out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			out += static_cast<char>(0xF0 | (codePoint >> 18));
+			out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	struct JsonValue
+	{
+		enum EType
+		{
+			typeString,
+			typeBool,
+			typeNumber,
+			typeNull
+		};
+
+		EType type;
+		std::string text; // String or number.
+		bool boolean;
+	};
+
+	// A JSON object with string, boolean, number and null members, which is all the format uses.
+	class JsonObjectParser : boost::noncopyable
+	{
+	public:
+		explicit JsonObjectParser(const std::string& text) : m_p(text.c_str()), m_end(text.c_str() + text.size())
+		{
+		}
+
+		// Calls onMember(key, value) for every member. Returns false on a syntax error.
+		template<class Func>
+		bool Parse(const Func& onMember)
+		{
+			SkipSpace();
+
+			if (!Consume('{'))
+				return false;
+
+			SkipSpace();
+
+			if (Consume('}'))
+				return AtEnd();
+
+			std::string key;
+			JsonValue value;
+
+			for (;;)
+			{
+				SkipSpace();
+
+				if (!Consume('"') || !ParseString(key))
+					return false;
+
+				SkipSpace();
+
+				if (!Consume(':'))
+					return false;
+
+				SkipSpace();
+
+				if (!ParseValue(value))
+					return false;
+
+				onMember(key, value);
+
+				SkipSpace();
+
+				if (Consume(','))
+					continue;
+
+				return Consume('}') && AtEnd();
+			}
+		}
+
+	private:
+		void SkipSpace()
+		{
+			while (m_p != m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\r' || *m_p == '\n'))
+				++m_p;
+		}
+
+		bool Consume(char c)
+		{
+			if (m_p == m_end || *m_p != c)
+				return false;
+
+			++m_p;
+			return true;
+		}
+
+		bool ConsumeWord(const char* word)
+		{
+			const std::size_t length = strlen(word);
+
+			if (static_cast<std::size_t>(m_end - m_p) < length || strncmp(m_p, word, length) != 0)
+				return false;
+
+			m_p += length;
+			return true;
+		}
+
+		bool AtEnd()
+		{
+			SkipSpace();
+			return m_p == m_end;
+		}
+
+		bool ParseHex4(unsigned int& value)
+		{
+			if (m_end - m_p < 4)
+				return false;
+
+			value = 0;
+
+			for (int i = 0; i < 4; ++i, ++m_p)
+			{
+				const char c = *m_p;
+				value <<= 4;
+
+				if (c >= '0' && c <= '9')
+					value |= c - '0';
+				else if (c >= 'a' && c <= 'f')
+					value |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F')
+					value |= c - 'A' + 10;
+				else
+					return false;
+			}
+
+			return true;
+		}
+
+		// The opening quote has been consumed.
+		bool ParseString(std::string& out)
+		{
+			out.clear();
+
+			while (m_p != m_end)
+			{
+				const char c = *m_p++;
+
+				if (c == '"')
+					return true;
+
+				if (c != '\\')
+				{
+					out += c;
+					continue;
+				}
+
+				if (m_p == m_end)
+					return false;
+
+				switch (*m_p++)
+				{
+				case '"':  out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '/':  out += '/'; break;
+				case 'b':  out += '\b'; break;
+				case 'f':  out += '\f'; break;
+				case 'n':  out += '\n'; break;
+				case 'r':  out += '\r'; break;
+				case 't':  out += '\t'; break;
+
+				case 'u':
+					{
+						unsigned int codePoint;
+
+						if (!ParseHex4(codePoint))
+							return false;
+
+						// Surrogate pair.
+						if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+						{
+							unsigned int low;
+
+							if (!ConsumeWord("\\u") || !ParseHex4(low) || low < 0xDC00 || low > 0xDFFF)
+								return false;
+
+							codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						}
+
+						AppendUtf8(out, codePoint);
+					}
+					break;
+
+				default:
+					return false;
+				}
+			}
+
+			return false;
+		}
+
+		bool ParseValue(JsonValue& value)
+		{
+			value.text.clear();
+			value.boolean = false;
+
+			if (m_p == m_end)
+				return false;
+
+			if (Consume('"'))
+			{
+				value.type = JsonValue::typeString;
+				return ParseString(value.text);
+			}
+
+			if (ConsumeWord("true"))
+			{
+				value.type = JsonValue::typeBool;
+				value.boolean = true;
+				return true;
+			}
+
+			if (ConsumeWord("false"))
+			{
+				value.type = JsonValue::typeBool;
+				return true;
+			}
+
+			if (ConsumeWord("null"))
+			{
+				value.type = JsonValue::typeNull;
+				return true;
+			}
+
+			value.type = JsonValue::typeNumber;
+
+			while (m_p != m_end && strchr("+-.0123456789eE", *m_p) != 0)
+				value.text += *m_p++;
+
+			return !value.text.empty();
+		}
+
+	private:
+		const char* m_p;
+		const char* m_end;
+	};
+
+	//------------------------------------------------------------------------------
+	// Fields
+	//------------------------------------------------------------------------------
+
+	// Accepts the registry format with or without braces.
+	bool ParseGUID(const std::string& text, GUID& guid)
+	{
+		std::string s = text;
+
+		if (s.size() == 38 && s.front() == '{' && s.back() == '}')
+			s = s.substr(1, 36);
+
+		if (s.size() != 36)
+			return false;
+
+		for (std::size_t i = 0; i < s.size(); ++i)
+		{
+			const bool dash = i == 8 || i == 13 || i == 18 || i == 23;
+
+			if (dash ? s[i] != '-' : !isxdigit(static_cast<unsigned char>(s[i])))
+				return false;
+		}
+
+		guid = pfc::GUID_from_text(s.c_str());
+		return true;
+	}
+
+	template<class T>
+	std::string EncodeBlock(const T& block)
+	{
+		foobar_stream_buffer_writer bufferStream;
+		block.SerializeToStream(bufferStream);
+
+		pfc::string8 result;
+		pfc::base64_encode(result, bufferStream.m_buffer.get_ptr(), bufferStream.m_buffer.get_size());
+
+		return result.get_ptr();
+	}
+
+	template<class T>
+	bool DecodeBlock(const std::string& text, T& block)
+	{
+		S11nBlocks::ByteBuffer data;
+		pfc::base64_decode_array(data, text.c_str());
+
+		try
+		{
+			S11nBlocks::ParseLimitsScope limits(S11nBlocks::ParseLimits(), data.get_size());
+			foobar_stream_buffer_reader bufferStream(data.get_ptr(), data.get_size());
+			block.ParseFromStream(bufferStream);
+		}
+		catch (S11nBlocks::Exception&)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	std::wstring ToWide(const std::string& str)
+	{
+		return pfc::stringcvt::string_wide_from_utf8(str.c_str()).get_ptr();
+	}
+
+	pfc::string8 ToUtf8(const std::wstring& str)
+	{
+		return pfc::stringcvt::string_utf8_from_wide(str.c_str()).get_ptr();
+	}
+
+	//------------------------------------------------------------------------------
+	// Importer
+	//------------------------------------------------------------------------------
+
+	struct Record
+	{
+		Record() : guid(pfc::guid_null), taskGUID(pfc::guid_null), hasName(false), hasEnabled(false),
+			hasTask(false), enabled(false), badField(false)
+		{
+		}
+
+		std::string type;
+		GUID guid;
+		std::string name;
+		std::string data;
+		GUID taskGUID;
+
+		bool hasName;
+		bool hasEnabled;
+		bool hasTask;
+		bool enabled;
+		bool badField;
+	};
+
+	class Importer : boost::noncopyable
+	{
+	public:
+		Importer(PrefPageModel& model, ImportResult& result) : m_model(model), m_result(result),
+			m_actionListNames(model.GetActionLists(), [](ActionList* al) { return al->GetName(); })
+		{
+		}
+
+		bool ImportLine(const std::string& line, std::wstring& error)
+		{
+			Record record;
+
+			JsonObjectParser parser(line);
+
+			if (!parser.Parse(boost::bind(&Importer::OnMember, boost::ref(record), _1, _2)))
+			{
+				error = L"not a JSON object";
+				return false;
+			}
+
+			if (record.badField)
+			{
+				error = L"a field has a wrong value";
+				return false;
+			}
+
+			if (record.guid == pfc::guid_null)
+			{
+				error = L"missing guid";
+				return false;
+			}
+
+			if (record.type == "task")
+				return ImportActionList(record, error);
+
+			if (record.type == "event")
+				return ImportEvent(record, error);
+
+			error = L"unknown type";
+			return false;
+		}
+
+	private:
+		static void OnMember(Record& record, const std::string& key, const JsonValue& value)
+		{
+			const bool isString = value.type == JsonValue::typeString;
+
+			if (key == "type")
+			{
+				record.type = value.text;
+			}
+			else if (key == "guid")
+			{
+				record.badField |= !isString || !ParseGUID(value.text, record.guid);
+			}
+			else if (key == "name")
+			{
+				record.name = value.text;
+				record.hasName = true;
+				record.badField |= !isString;
+			}
+			else if (key == "enabled")
+			{
+				record.enabled = value.boolean;
+				record.hasEnabled = true;
+				record.badField |= value.type != JsonValue::typeBool;
+			}
+			else if (key == "task")
+			{
+				// null or "" unlinks the event.
+				record.hasTask = true;
+
+				if (value.type != JsonValue::typeNull && !(isString && value.text.empty()))
+					record.badField |= !isString || !ParseGUID(value.text, record.taskGUID);
+			}
+			else if (key == "data")
+			{
+				record.data = value.text;
+				record.badField |= !isString;
+			}
+		}
+
+		bool ImportActionList(const Record& record, std::wstring& error)
+		{
+			ActionList* pExisting = m_model.GetActionListByGUID(record.guid);
+			ActionListS11nBlock block;
+
+			if (!record.data.empty())
+			{
+				if (!DecodeBlock(record.data, block))
+				{
+					error = L"damaged data";
+					return false;
+				}
+			}
+			else if (pExisting)
+			{
+				pExisting->SaveToS11nBlock(block);
+			}
+			else
+			{
+				error = L"a new task requires data";
+				return false;
+			}
+
+			block.guid.SetValue(record.guid);
+
+			if (record.hasName)
+				block.name.SetValue(record.name.c_str());
+
+			const std::wstring name = block.name.Exists() ? ToWide(block.name.GetValue().get_ptr()) : std::wstring();
+
+			if (name.empty())
+			{
+				error = L"missing task name";
+				return false;
+			}
+
+			if (pExisting)
+				m_actionListNames.Remove(pExisting->GetName());
+
+			const std::wstring uniqueName = m_actionListNames.MakeUnique(name);
+
+			if (uniqueName != name)
+			{
+				block.name.SetValue(ToUtf8(uniqueName));
+				++m_result.renamed;
+			}
+
+			std::unique_ptr<ActionList> pActionList(new ActionList);
+			pActionList->LoadFromS11nBlock(block);
+
+			if (pExisting)
+			{
+				m_model.ReplaceActionList(pExisting, std::move(pActionList));
+				++m_result.updated;
+			}
+			else
+			{
+				m_model.AddActionList(std::move(pActionList));
+				++m_result.added;
+			}
+
+			return true;
+		}
+
+		bool ImportEvent(const Record& record, std::wstring& error)
+		{
+			// Tasks are imported ahead of the events referring to them.
+			if (record.hasTask && record.taskGUID != pfc::guid_null && !m_model.GetActionListByGUID(record.taskGUID))
+			{
+				error = L"unknown task";
+				return false;
+			}
+
+			Event* pEvent = m_model.GetEventByGUID(record.guid);
+			std::unique_ptr<Event> pNewEvent;
+
+			if (!record.data.empty())
+			{
+				EventS11nBlock block;
+
+				if (!DecodeBlock(record.data, block))
+				{
+					error = L"damaged data";
+					return false;
+				}
+
+				// protoGUID is a required field, unnecessary to check if it exists.
+				Event* pPrototype = ServiceManager::Instance().GetEventPrototypesManager().
+					GetPrototypeByGUID(block.protoGUID.GetValue());
+
+				if (!pPrototype)
+				{
+					error = L"unknown event type";
+					return false;
+				}
+
+				block.eventGUID.SetValue(record.guid);
+
+				if (pEvent && pEvent->GetPrototypeGUID() == block.protoGUID.GetValue())
+				{
+					pEvent->Load(block);
+				}
+				else
+				{
+					pNewEvent = pPrototype->Clone();
+					pNewEvent->Load(block);
+				}
+			}
+			else if (!pEvent)
+			{
+				error = L"a new event requires data";
+				return false;
+			}
+
+			Event* pTarget = pNewEvent ? pNewEvent.get() : pEvent;
+
+			if (record.hasEnabled)
+				pTarget->Enable(record.enabled);
+
+			if (record.hasTask)
+				pTarget->SetActionListGUID(record.taskGUID);
+
+			if (!pNewEvent)
+			{
+				m_model.UpdateEvent(pEvent);
+				++m_result.updated;
+				return true;
+			}
+
+			// The type of the event has changed, it keeps its place in the list.
+			if (pEvent)
+			{
+				m_model.ReplaceEvent(pEvent, std::move(pNewEvent));
+				++m_result.updated;
+			}
+			else
+			{
+				m_model.AddEvent(std::move(pNewEvent));
+				++m_result.added;
+			}
+
+			return true;
+		}
+
+	private:
+		PrefPageModel& m_model;
+		ImportResult& m_result;
+		DuplicateNameSet m_actionListNames;
+	};
+
+} // namespace
+
+void Export(PrefPageModel& model, const char* path)
+{
+	file::ptr pFile;
+	filesystem::g_open_write_new(pFile, path, fb2k::noAbort);
+
+	// The file must not depend on the string tables of the configuration.
+	S11nBlocks::EncodingScope scope(0);
+
+	LineWriter writer(pFile);
+	std::string line;
+
+	// Tasks first, so that events refer to tasks written above them.
+	const std::vector<ActionList*> actionLists = model.GetActionLists();
+
+	for (std::size_t i = 0; i < actionLists.size(); ++i)
+	{
+		const ActionList* pActionList = actionLists[i];
+		ActionListS11nBlock block;
+		std::string data;
+
+		try
+		{
+			pActionList->SaveToS11nBlock(block);
+			data = EncodeBlock(block);
+		}
+		catch (S11nBlocks::Exception&)
+		{
+			continue;
+		}
+
+		line = "{\"type\": \"task\", \"guid\": ";
+		AppendJsonString(line, pfc::print_guid(pActionList->GetGUID()));
+		line += ", \"name\": ";
+		AppendJsonString(line, ToUtf8(pActionList->GetName()));
+		line += ", \"data\": ";
+		AppendJsonString(line, data.c_str());
+		line += "}";
+
+		writer.WriteLine(line);
+	}
+
+	const std::vector<Event*> events = model.GetEvents();
+
+	for (std::size_t i = 0; i < events.size(); ++i)
+	{
+		const Event* pEvent = events[i];
+		EventS11nBlock block;
+		std::string data;
+
+		try
+		{
+			block.protoGUID.SetValue(pEvent->GetPrototypeGUID());
+			pEvent->Save(block);
+			data = EncodeBlock(block);
+		}
+		catch (S11nBlocks::Exception&)
+		{
+			continue;
+		}
+
+		line = "{\"type\": \"event\", \"guid\": ";
+		AppendJsonString(line, pfc::print_guid(pEvent->GetEventGUID()));
+		line += pEvent->IsEnabled() ? ", \"enabled\": true" : ", \"enabled\": false";
+		line += ", \"task\": ";
+
+		if (pEvent->GetActionListGUID() != pfc::guid_null)
+			AppendJsonString(line, pfc::print_guid(pEvent->GetActionListGUID()));
+		else
+			line += "null";
+
+		line += ", \"description\": ";
+		AppendJsonString(line, ToUtf8(pEvent->GetDescription()));
+		line += ", \"data\": ";
+		AppendJsonString(line, data.c_str());
+		line += "}";
+
+		writer.WriteLine(line);
+	}
+
+	writer.Flush();
+}
+
+ImportResult Import(PrefPageModel& model, const char* path)
+{
+	file::ptr pFile;
+	filesystem::g_open_read(pFile, path, fb2k::noAbort);
+
+	ImportResult result;
+
+	PrefPageModel::Transaction transaction(model);
+	S11nBlocks::EncodingScope scope(0);
+
+	Importer importer(model, result);
+	LineReader reader(pFile);
+
+	std::string line;
+	std::wstring error;
+
+	for (int lineNumber = 1; reader.ReadLine(line); ++lineNumber)
+	{
+		if (line.find_first_not_of(" \t") == std::string::npos)
+			continue;
+
+		if (importer.ImportLine(line, error))
+			continue;
+
+		if (result.failed++ == 0)
+			result.firstError = boost::str(boost::wformat(L"line %1%: %2%") % lineNumber % error);
+	}
+
+	return result;
+}
+
+std::wstring FormatImportResult(const ImportResult& result)
+{
+	std::wstring text = boost::str(boost::wformat(L"Added: %1%, updated: %2%, renamed tasks: %3%, skipped lines: %4%.") %
+		result.added % result.updated % result.renamed % result.failed);
+
+	if (!result.firstError.empty())
+		text += L"\nFirst error at " + result.firstError + L".";
+
+	return text;
+}
+
+} // namespace ScheduleIO
\ No newline at end of file
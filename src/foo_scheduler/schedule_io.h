@@ -0,0 +1,36 @@
+#pragma once
+
+class PrefPageModel;
+
+// Import and export of events and tasks as JSON lines, one item per line:
+//   {"type": "task", "guid": "...", "name": "...", "data": "..."}
+//   {"type": "event", "guid": "...", "enabled": true, "task": "...", "description": "...", "data": "..."}
+// "data" is the item's S11n block in the original encoding as base64, it carries all settings.
+// Items are matched by GUID. An existing item is updated from "data" if it is present and then
+// from the other fields, a new item requires "data". "description" is written for reading only.
+// Files are processed line by line, so their size is not limited by memory.
+namespace ScheduleIO
+{
+	struct ImportResult
+	{
+		ImportResult() : added(0), updated(0), renamed(0), failed(0) {}
+
+		int added;
+		int updated;
+		int renamed; // Tasks renamed, because the name was taken.
+		int failed;  // Lines skipped.
+
+		std::wstring firstError;
+	};
+
+	// Throws exception_io.
+	void Export(PrefPageModel& model, const char* path);
+
+	// All changes are made in one model transaction.
+	// Task names are kept unique, a taken name gets a " (n)" suffix.
+	// Throws exception_io, lines read before the error stay imported.
+	ImportResult Import(PrefPageModel& model, const char* path);
+
+	std::wstring FormatImportResult(const ImportResult& result);
+
+} // namespace ScheduleIO
\ No newline at end of file
@@ -14,7 +14,10 @@ ServiceManager::ServiceManager()
 	, m_menuItemEventsManager(m_model)
 	, m_playerEventsManager(m_model)
 	, m_dateTimeEventsManager(m_model)
+	, m_playbackPositionEventsManager(m_model)
 	, m_timersManager()
+	, m_mainThreadExecutor()
+	, m_sharedVariables()
 	, m_eventPrototypesManager()
 	, m_actionPrototypesManager()
 {
@@ -45,11 +48,26 @@ DateTimeEventsManager& ServiceManager::GetDateTimeEventsManager()
 	return m_dateTimeEventsManager;
 }
 
+PlaybackPositionEventsManager& ServiceManager::GetPlaybackPositionEventsManager()
+{
+	return m_playbackPositionEventsManager;
+}
+
 TimersManager& ServiceManager::GetTimersManager()
 {
 	return m_timersManager;
 }
 
+MainThreadExecutor& ServiceManager::GetMainThreadExecutor()
+{
+	return m_mainThreadExecutor;
+}
+
+SharedVariables& ServiceManager::GetSharedVariables()
+{
+	return m_sharedVariables;
+}
+
 PrototypesManager<Event>& ServiceManager::GetEventPrototypesManager()
 {
 	return m_eventPrototypesManager;
@@ -5,8 +5,11 @@
 #include "menu_item_events_manager.h"
 #include "player_events_manager.h"
 #include "date_time_events_manager.h"
+#include "playback_position_events_manager.h"
 #include "timers_manager.h"
+#include "main_thread_executor.h"
 #include "prototypes_manager.h"
+#include "shared_variables.h"
 #include "event_list_window.h"
 
 class ServiceManager : boost::noncopyable
@@ -19,7 +22,10 @@ public:
 	MenuItemEventsManager& GetMenuItemEventsManager();
 	PlayerEventsManager& GetPlayerEventsManager();
 	DateTimeEventsManager& GetDateTimeEventsManager();
+	PlaybackPositionEventsManager& GetPlaybackPositionEventsManager();
 	TimersManager& GetTimersManager();
+	MainThreadExecutor& GetMainThreadExecutor();
+	SharedVariables& GetSharedVariables();
 	PrototypesManager<Event>& GetEventPrototypesManager();
 	PrototypesManager<IAction>& GetActionPrototypesManager();
 	EventListWindow* GetEventListWindow();
@@ -34,7 +40,10 @@ private:
 	MenuItemEventsManager m_menuItemEventsManager;
 	PlayerEventsManager m_playerEventsManager;
 	DateTimeEventsManager m_dateTimeEventsManager;
+	PlaybackPositionEventsManager m_playbackPositionEventsManager;
 	TimersManager m_timersManager;
+	MainThreadExecutor m_mainThreadExecutor;
+	SharedVariables m_sharedVariables;
 	PrototypesManager<Event> m_eventPrototypesManager;
 	PrototypesManager<IAction> m_actionPrototypesManager;
 	EventListWindow* m_eventListWindow = NULL;
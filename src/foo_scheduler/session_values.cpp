@@ -0,0 +1,61 @@
+#include "pch.h"
+#include "session_values.h"
+#include "session_values_s11n_block.h"
+
+namespace SessionValues
+{
+
+const Value& Store::Get(Key key) const
+{
+	_ASSERTE(key >= 0 && key < numKeys);
+	return m_values[key];
+}
+
+void Store::Set(Key key, const Value& value)
+{
+	_ASSERTE(key >= 0 && key < numKeys);
+	m_values[key] = value;
+}
+
+void Store::Clear()
+{
+	for (int i = 0; i < numKeys; ++i)
+		m_values[i] = boost::blank();
+}
+
+void Store::LoadFromS11nBlock(const SessionValuesS11nBlock& block)
+{
+	Clear();
+
+	if (!block.values.Exists())
+		return;
+
+	for (int i = 0; i < block.values.GetSize(); ++i)
+	{
+		const SessionValueS11nBlock& b = block.values.GetAt(i);
+
+		// Skip keys of newer versions.
+		const int key = b.key.GetValue();
+		if (key < 0 || key >= numKeys)
+			continue;
+
+		m_values[key] = LoadValueFromS11nBlock(b);
+	}
+}
+
+void Store::SaveToS11nBlock(SessionValuesS11nBlock& block) const
+{
+	for (int i = 0; i < numKeys; ++i)
+	{
+		if (m_values[i].which() == 0)
+			continue;
+
+		SessionValueS11nBlock b;
+		b.key.SetValue(i);
+		SaveValueToS11nBlock(m_values[i], b);
+
+		block.values.Add(b);
+	}
+}
+
+} // namespace SessionValues
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+struct SessionValuesS11nBlock;
+
+namespace SessionValues
+{
+	// Keys of the values shared between actions of one action list execution session.
+	// The numbers are stored in the configuration, append new keys before numKeys only.
+	enum Key
+	{
+		keySavedPlaylist = 0,
+		keySavedTrack,
+		keySavedPosition,
+		keyLaunchExitCode,   // Exit code of the application waited for by 'Launch application'.
+		keyLaunchOutput,     // Its captured standard output.
+
+		numKeys
+	};
+
+	// boost::blank means that there is no value.
+	typedef boost::variant<boost::blank, t_size, double, std::wstring, GUID> Value;
+
+	// Keys are dense, so the store is a flat array indexed by the key.
+	// Setting a number doesn't allocate and a lookup is a single index operation.
+	class Store
+	{
+	public:
+		const Value& Get(Key key) const;
+
+		// Returns nullptr if there's no value or it has another type.
+		template<typename T>
+		const T* GetIf(Key key) const
+		{
+			return boost::get<T>(&Get(key));
+		}
+
+		// Setting boost::blank erases the value.
+		void Set(Key key, const Value& value);
+		void Clear();
+
+		void LoadFromS11nBlock(const SessionValuesS11nBlock& block);
+		void SaveToS11nBlock(SessionValuesS11nBlock& block) const;
+
+	private:
+		Value m_values[numKeys];
+	};
+
+} // namespace SessionValues
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "s11n_blocks.h"
+#include "session_values.h"
+
+// Exactly one of the value fields exists, depending on the type of the value.
+struct SessionValueS11nBlock : public S11nBlocks::Block<SessionValueS11nBlock>
+{
+	S11nBlocks::Field<int, 1, true> key;
+	S11nBlocks::Field<t_uint64, 2> sizeValue;
+	S11nBlocks::Field<double, 3> doubleValue;
+	S11nBlocks::Field<pfc::string8, 4> stringValue;
+	S11nBlocks::Field<GUID, 5> guidValue;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(key)(sizeValue)(doubleValue)(stringValue)(guidValue);
+	}
+};
+
+struct SessionValuesS11nBlock : public S11nBlocks::Block<SessionValuesS11nBlock>
+{
+	S11nBlocks::RepeatedField<SessionValueS11nBlock, 1> values;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(values);
+	}
+};
+
+namespace SessionValues
+{
+	// Conversion of a value to and from a block with the sizeValue, doubleValue,
+	// stringValue and guidValue fields.
+
+	template<class TBlock>
+	class SaveValueVisitor : public boost::static_visitor<>
+	{
+	public:
+		explicit SaveValueVisitor(TBlock& block) : m_block(block) {}
+
+		void operator () (const boost::blank&) const {}
+
+		void operator () (t_size value) const
+		{
+			m_block.sizeValue.SetValue(value);
+		}
+
+		void operator () (double value) const
+		{
+			m_block.doubleValue.SetValue(value);
+		}
+
+		void operator () (const std::wstring& value) const
+		{
+			m_block.stringValue.SetValue(pfc::stringcvt::string_utf8_from_wide(value.c_str()).get_ptr());
+		}
+
+		void operator () (const GUID& value) const
+		{
+			m_block.guidValue.SetValue(value);
+		}
+
+	private:
+		TBlock& m_block;
+	};
+
+	template<class TBlock>
+	void SaveValueToS11nBlock(const Value& value, TBlock& block)
+	{
+		boost::apply_visitor(SaveValueVisitor<TBlock>(block), value);
+	}
+
+	template<class TBlock>
+	Value LoadValueFromS11nBlock(const TBlock& block)
+	{
+		if (block.sizeValue.Exists())
+			return static_cast<t_size>(block.sizeValue.GetValue());
+
+		if (block.doubleValue.Exists())
+			return block.doubleValue.GetValue();
+
+		if (block.stringValue.Exists())
+			return std::wstring(pfc::stringcvt::string_wide_from_utf8(block.stringValue.GetValue()).get_ptr());
+
+		if (block.guidValue.Exists())
+			return block.guidValue.GetValue();
+
+		return boost::blank();
+	}
+
+} // namespace SessionValues
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "shared_variables.h"
+#include "shared_variables_s11n_block.h"
+#include "session_values_s11n_block.h"
+
+const SessionValues::Value& SharedVariables::Snapshot::GetValue(const std::wstring& name) const
+{
+	static const SessionValues::Value noValue;
+
+	auto it = variables.find(name);
+	return it != variables.end() ? it->second.value : noValue;
+}
+
+SharedVariables::SharedVariables() : m_pSnapshot(new Snapshot)
+{
+}
+
+SharedVariables::SnapshotPtr SharedVariables::GetSnapshot() const
+{
+	return boost::atomic_load(&m_pSnapshot);
+}
+
+void SharedVariables::Set(const std::wstring& name, const SessionValues::Value& value, bool persistent)
+{
+	Variables changes;
+
+	Variable& var = changes[name];
+	var.value = value;
+	var.persistent = persistent;
+
+	Set(changes);
+}
+
+void SharedVariables::Set(const Variables& changes)
+{
+	_ASSERTE(core_api::is_main_thread());
+
+	// Writers are serialized by the main thread, so the current snapshot can't change meanwhile.
+	boost::shared_ptr<Snapshot> pSnapshot(new Snapshot(*m_pSnapshot));
+
+	for (auto it = changes.begin(); it != changes.end(); ++it)
+	{
+		if (it->second.value.which() == 0)
+			pSnapshot->variables.erase(it->first);
+		else
+			pSnapshot->variables[it->first] = it->second;
+	}
+
+	Publish(pSnapshot);
+}
+
+void SharedVariables::LoadFromS11nBlock(const SharedVariablesS11nBlock& block)
+{
+	boost::shared_ptr<Snapshot> pSnapshot(new Snapshot(*m_pSnapshot));
+
+	for (auto it = pSnapshot->variables.begin(); it != pSnapshot->variables.end();)
+	{
+		if (it->second.persistent)
+			it = pSnapshot->variables.erase(it);
+		else
+			++it;
+	}
+
+	if (block.variables.Exists())
+	{
+		for (int i = 0; i < block.variables.GetSize(); ++i)
+		{
+			const SharedVariableS11nBlock& b = block.variables.GetAt(i);
+
+			Variable var;
+			var.value = SessionValues::LoadValueFromS11nBlock(b);
+			var.persistent = true;
+
+			if (var.value.which() == 0)
+				continue;
+
+			pSnapshot->variables[pfc::stringcvt::string_wide_from_utf8(b.name.GetValue()).get_ptr()] = var;
+		}
+	}
+
+	Publish(pSnapshot);
+}
+
+void SharedVariables::SaveToS11nBlock(SharedVariablesS11nBlock& block) const
+{
+	SnapshotPtr pSnapshot = GetSnapshot();
+
+	for (auto it = pSnapshot->variables.begin(); it != pSnapshot->variables.end(); ++it)
+	{
+		if (!it->second.persistent)
+			continue;
+
+		SharedVariableS11nBlock b;
+		b.name.SetValue(pfc::stringcvt::string_utf8_from_wide(it->first.c_str()).get_ptr());
+		SessionValues::SaveValueToS11nBlock(it->second.value, b);
+
+		block.variables.Add(b);
+	}
+}
+
+void SharedVariables::Publish(const boost::shared_ptr<Snapshot>& pSnapshot)
+{
+	pSnapshot->version = m_pSnapshot->version + 1;
+	boost::atomic_store(&m_pSnapshot, SnapshotPtr(pSnapshot));
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "session_values.h"
+
+struct SharedVariablesS11nBlock;
+
+// Named variables visible to all action lists.
+// A reader takes a snapshot, which never changes once it has been published. Changes are made
+// in the main thread and publish a new snapshot, so readers in other threads neither wait
+// for a writer nor see a partially applied change.
+class SharedVariables : boost::noncopyable
+{
+public:
+	struct Variable
+	{
+		Variable() : persistent(false) {}
+
+		SessionValues::Value value;
+
+		// Persistent variables are saved with the configuration.
+		bool persistent;
+	};
+
+	typedef std::map<std::wstring, Variable> Variables;
+
+	struct Snapshot
+	{
+		Snapshot() : version(0) {}
+
+		// Returns boost::blank if there's no such variable.
+		const SessionValues::Value& GetValue(const std::wstring& name) const;
+
+		// Incremented by every change.
+		unsigned __int64 version;
+		Variables variables;
+	};
+
+	typedef boost::shared_ptr<const Snapshot> SnapshotPtr;
+
+	SharedVariables();
+
+	// Can be called from any thread.
+	SnapshotPtr GetSnapshot() const;
+
+	// Main thread only. Setting boost::blank removes the variable.
+	void Set(const std::wstring& name, const SessionValues::Value& value, bool persistent);
+
+	// Main thread only. Applies all changes as one snapshot.
+	void Set(const Variables& changes);
+
+	// Replaces persistent variables, keeps the others.
+	void LoadFromS11nBlock(const SharedVariablesS11nBlock& block);
+
+	// Saves persistent variables only.
+	void SaveToS11nBlock(SharedVariablesS11nBlock& block) const;
+
+private:
+	void Publish(const boost::shared_ptr<Snapshot>& pSnapshot);
+
+private:
+	// Accessed with boost::atomic_load and boost::atomic_store only.
+	SnapshotPtr m_pSnapshot;
+};
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "s11n_blocks.h"
+
+// Value fields are the same as in SessionValueS11nBlock.
+struct SharedVariableS11nBlock : public S11nBlocks::Block<SharedVariableS11nBlock>
+{
+	S11nBlocks::Field<pfc::string8, 1, true> name;
+	S11nBlocks::Field<t_uint64, 2> sizeValue;
+	S11nBlocks::Field<double, 3> doubleValue;
+	S11nBlocks::Field<pfc::string8, 4> stringValue;
+	S11nBlocks::Field<GUID, 5> guidValue;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(name)(sizeValue)(doubleValue)(stringValue)(guidValue);
+	}
+};
+
+struct SharedVariablesS11nBlock : public S11nBlocks::Block<SharedVariablesS11nBlock>
+{
+	S11nBlocks::RepeatedField<SharedVariableS11nBlock, 1> variables;
+
+	template<class Archive>
+	void RegisterFields(Archive& ar)
+	{
+		ar.RegisterFields(variables);
+	}
+};
\ No newline at end of file
@@ -10,6 +10,13 @@
 static const GUID guid_cfg_dialog_position_status_dlg = { 0x3f43374c, 0x66a, 0x4ac9, { 0xb5, 0xa5, 0xee, 0x71, 0xb2, 0x3a, 0x73, 0x81 } };
 static cfgDialogPosition cfg_dialog_position_status_dlg(guid_cfg_dialog_position_status_dlg);
 
+namespace
+{
+	// Firings shown in the date/time events list.
+	const int forecastDays = 7;
+	const std::size_t forecastMaxCount = 100;
+}
+
 StatusWindow::StatusWindow(HWND parent, const boost::function<void ()>& onDestroyCallback) :
 	m_onDestroyCallback(onDestroyCallback)
 {
@@ -109,7 +116,9 @@ bool StatusWindow::pretranslate_message(MSG* p_msg)
 
 void StatusWindow::UpdatePendingEvents()
 {
-	m_pendingEventsModel = ServiceManager::Instance().GetDateTimeEventsManager().GetPendingEvents();
+	m_pendingEventsModel = ServiceManager::Instance().GetDateTimeEventsManager().GetForecast(
+		boost::gregorian::days(forecastDays), forecastMaxCount);
+
 	bool bfix_refresh = m_dateTimeEvents.GetItemCount() && m_dateTimeEvents.GetItemCount() == m_pendingEventsModel.size();
 	m_dateTimeEvents.SetItemCountEx(static_cast<int>(m_pendingEventsModel.size()), LVSICF_NOSCROLL);
 	if (bfix_refresh) {
@@ -174,12 +183,34 @@ LRESULT StatusWindow::OnPendingEventsGetDispInfo(LPNMHDR pnmh)
 
 	if (pInfo->item.mask & LVIF_TEXT)
 	{
-		swprintf_s(pInfo->item.pszText, pInfo->item.cchTextMax, L"%s", m_pendingEventsModel[pInfo->item.iItem]->GetDescription().c_str());
+		const DateTimeForecast::Firing& firing = m_pendingEventsModel[pInfo->item.iItem];
+
+		swprintf_s(pInfo->item.pszText, pInfo->item.cchTextMax, L"%s  %s",
+			FormatFiringTime(firing.time).c_str(), firing.pEvent->GetDescription().c_str());
 	}
 
 	return TRUE;
 }
 
+std::wstring StatusWindow::FormatFiringTime(const boost::posix_time::ptime& time)
+{
+	SYSTEMTIME st = {0};
+
+	st.wYear   = time.date().year();
+	st.wMonth  = time.date().month();
+	st.wDay    = time.date().day();
+	st.wHour   = static_cast<WORD>(time.time_of_day().hours());
+	st.wMinute = static_cast<WORD>(time.time_of_day().minutes());
+	st.wSecond = static_cast<WORD>(time.time_of_day().seconds());
+
+	WCHAR dateBuf[64];
+	WCHAR timeBuf[64];
+	GetDateFormat(LOCALE_USER_DEFAULT, DATE_SHORTDATE, &st, NULL, dateBuf, 64);
+	GetTimeFormat(LOCALE_USER_DEFAULT, 0, &st, NULL, timeBuf, 64);
+
+	return std::wstring(dateBuf) + L" " + timeBuf;
+}
+
 void StatusWindow::OnStopAllActionLists(UINT uNotifyCode, int nID, CWindow wndCtl)
 {
 	ServiceManager::Instance().GetRootController().RemoveAllExecSessions();
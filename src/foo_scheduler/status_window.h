@@ -2,6 +2,7 @@
 
 #include "resource.h"
 #include "header_static.h"
+#include "date_time_forecast.h"
 
 class ActionListExecSession;
 class DateTimeEvent;
@@ -42,6 +43,7 @@ private:
 	~StatusWindow();
 
 	void UpdatePendingEvents();
+	static std::wstring FormatFiringTime(const boost::posix_time::ptime& time);
 	void UpdateActiveSessions();
 
 	void OnActionListExecSessionAdded(ActionListExecSession* pSession);
@@ -104,5 +106,5 @@ private:
 	ListViewWithResizableColumn m_activeSessions;
 
 	std::vector<ActionListExecSession*> m_activeSessionsModel;
-	std::vector<DateTimeEvent*> m_pendingEventsModel;
+	std::vector<DateTimeForecast::Firing> m_pendingEventsModel;
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+// Order in which steps of running tasks get the main thread.
+namespace TaskPriority
+{
+	enum Type
+	{
+		low = 0,
+		normal,
+		high,
+
+		numTypes
+	};
+
+	inline std::wstring Label(Type type)
+	{
+		switch (type)
+		{
+		case low:
+			return L"low";
+
+		case normal:
+			return L"normal";
+
+		case high:
+			return L"high";
+		}
+
+		_ASSERTE(false);
+		return std::wstring();
+	}
+
+} // namespace TaskPriority
\ No newline at end of file
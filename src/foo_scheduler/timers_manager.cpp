@@ -1,8 +1,9 @@
 #include "pch.h"
 #include "timers_manager.h"
 #include "async_call.h"
+#include "tracer.h"
 
-TimersManager::TimersManager() : m_nextTimerID(0)
+TimersManager::TimersManager() : m_nextTimerID(0), m_pendingReleases(0)
 {
 }
 
@@ -14,16 +15,35 @@ void TimersManager::Shutdown()
 {
 	_ASSERTE(m_timerID2TimerHandle.empty());
 	_ASSERTE(m_timerID2Descr.empty());
+
+	// Timer callbacks reference the plugin code, so wait until all closed timers are released.
+	while (m_pendingReleases.load() != 0)
+		Sleep(1);
 }
 
 TimersManager::TimerID TimersManager::CreateTimer(
 	const boost::posix_time::ptime& startTime, const boost::posix_time::time_duration& period, bool wakeup)
 {
-	LARGE_INTEGER startTimeUTC = PTime2LARGE_INTEGER(startTime);
+	return CreateTimerWithDueTime(PTime2LARGE_INTEGER(startTime), period, wakeup);
+}
+
+TimersManager::TimerID TimersManager::CreateTimer(
+	const boost::posix_time::time_duration& dueTime, const boost::posix_time::time_duration& period, bool wakeup)
+{
+	// A relative due time counts elapsed time, a local one would go through the time zone table
+	// and be off by an hour when it is set during a repeated hour.
+	LARGE_INTEGER relativeDueTime;
+	relativeDueTime.QuadPart = -std::max<LONGLONG>(dueTime.total_microseconds() * 10, 0);
+
+	return CreateTimerWithDueTime(relativeDueTime, period, wakeup);
+}
 
+TimersManager::TimerID TimersManager::CreateTimerWithDueTime(
+	const LARGE_INTEGER& dueTime, const boost::posix_time::time_duration& period, bool wakeup)
+{
 	HANDLE hTimerEvent = CreateWaitableTimer(NULL, FALSE, NULL);
 	
-	SetWaitableTimer(hTimerEvent, &startTimeUTC,
+	SetWaitableTimer(hTimerEvent, &dueTime,
 		period.is_not_a_date_time() ? 0 : static_cast<LONG>(period.total_milliseconds()),
 		NULL, NULL, wakeup);
 
@@ -55,31 +75,71 @@ void TimersManager::CloseTimer(TimerID timerID)
 	auto it = m_timerID2Descr.find(timerID);
 	_ASSERTE(it != m_timerID2Descr.end());
 
-	// UnregisterWaitEx with the parameter equal to INVALID_HANDLE_VALUE
-	// waits for all callback functions to complete before returning.
-	// So callback pointer will be always deleted, even if TimersManager::DoneWaiting is running.
-	UnregisterWaitEx(it->second.waitObjectHandle, INVALID_HANDLE_VALUE);
+	PendingRelease* pRelease = new PendingRelease;
+	pRelease->pManager = this;
+	pRelease->timerHandle = timerHandle;
+	pRelease->waitObjectHandle = it->second.waitObjectHandle;
+	pRelease->pCallback = it->second.pCallback;
 
 	m_timerID2Descr.erase(it);
 
-	CloseHandle(timerHandle);
+	// UnregisterWaitEx with INVALID_HANDLE_VALUE waits for a running DoneWaiting to complete,
+	// which may take a while, so it's called off the main thread.
+	++m_pendingReleases;
+
+	if (!QueueUserWorkItem(ReleaseTimer, pRelease, WT_EXECUTEDEFAULT))
+		ReleaseTimer(pRelease);
+}
+
+DWORD WINAPI TimersManager::ReleaseTimer(void* param)
+{
+	std::unique_ptr<PendingRelease> pRelease(static_cast<PendingRelease*>(param));
+
+	UnregisterWaitEx(pRelease->waitObjectHandle, INVALID_HANDLE_VALUE);
+	CloseHandle(pRelease->timerHandle);
+
+	// The callback pointer is released only after the wait has been unregistered.
+	pRelease->pCallback.reset();
+	--pRelease->pManager->m_pendingReleases;
+
+	return 0;
+}
+
+boost::posix_time::ptime TimersManager::LocalToUTC(const boost::posix_time::ptime& local)
+{
+	// LocalFileTimeToFileTime would apply the current daylight saving bias, not the one at the time.
+	const boost::posix_time::ptime utc = m_timeZone.LocalToUTC(local,
+		LocalTimeZone::skippedShiftForward, LocalTimeZone::repeatedEarlier);
+
+	// A timer set during the second pass of a repeated time.
+	if (utc < boost::posix_time::microsec_clock::universal_time())
+		return m_timeZone.LocalToUTC(local, LocalTimeZone::skippedShiftForward, LocalTimeZone::repeatedLater);
+
+	return utc;
+}
+
+boost::posix_time::ptime TimersManager::UTCToLocal(const boost::posix_time::ptime& utc)
+{
+	return m_timeZone.UTCToLocal(utc);
 }
 
 LARGE_INTEGER TimersManager::PTime2LARGE_INTEGER(const boost::posix_time::ptime& pt)
 {
+	const boost::posix_time::ptime utc = LocalToUTC(pt);
+
 	SYSTEMTIME st = {0};
 
-	st.wYear  = pt.date().year();
-	st.wMonth = pt.date().month();
-	st.wDay   = pt.date().day();
+	st.wYear  = utc.date().year();
+	st.wMonth = utc.date().month();
+	st.wDay   = utc.date().day();
 
-	st.wHour   = static_cast<WORD>(pt.time_of_day().hours());
-	st.wMinute = static_cast<WORD>(pt.time_of_day().minutes());
-	st.wSecond = static_cast<WORD>(pt.time_of_day().seconds());
+	st.wHour   = static_cast<WORD>(utc.time_of_day().hours());
+	st.wMinute = static_cast<WORD>(utc.time_of_day().minutes());
+	st.wSecond = static_cast<WORD>(utc.time_of_day().seconds());
+	st.wMilliseconds = static_cast<WORD>(utc.time_of_day().total_milliseconds() % 1000);
 
-	FILETIME ftLocal, ftUTC;
-	SystemTimeToFileTime(&st, &ftLocal);
-	LocalFileTimeToFileTime(&ftLocal, &ftUTC);
+	FILETIME ftUTC;
+	SystemTimeToFileTime(&st, &ftUTC);
 
 	LARGE_INTEGER liUTC;
 
@@ -94,8 +154,10 @@ void CALLBACK TimersManager::DoneWaiting(void* param, BOOLEAN timedOut)
 {
 	// At this point it's guaranteed that the callback pointer has valid reference count,
 	// cause when a timer is closed, UnregisterWaitEx waits for callback to complete. Only AFTER that
-	// reference count is decreased in CloseTimer. So the situation when CloseTimer has already destroyed
-	// the callback pointer but this callback is still running is impossible.
+	// reference count is decreased in ReleaseTimer. So the situation when the callback pointer
+	// has already been destroyed but this callback is still running is impossible.
+	Tracer::RecordInstant("timer", "Timer expired");
+
 	AsyncCall::CallbackPtr pCallback(static_cast<AsyncCall::ICallback*>(param));
 	AsyncCall::AsyncRunInMainThread(pCallback);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "async_call.h"
+#include "local_time_zone.h"
 
 //------------------------------------------------------------------------------
 // TimersManager
@@ -17,21 +18,49 @@ public:
 	typedef __int64 TimerID;
 	static const TimerID invalidTimerID = -1;
 
-	// If period is not_a_date_time, then it's a one shot timer.
+	// If period is not_a_date_time, then it's a one shot timer. The start time is local, see LocalToUTC,
+	// only wall clock schedules should use it.
 	TimerID CreateTimer(const boost::posix_time::ptime& startTime,
 		const boost::posix_time::time_duration& period, bool wakeup);
 
+	// Fires after the due time from now, regardless of clock and daylight saving time changes.
+	TimerID CreateTimer(const boost::posix_time::time_duration& dueTime,
+		const boost::posix_time::time_duration& period, bool wakeup);
+
 	void StartTimer(TimerID timerID, const AsyncCall::CallbackPtr& pCallback);
 
+	// Doesn't block, the wait is unregistered and the handles are closed on a thread pool thread.
+	// A timer callback that is already running may still post its call to the main thread.
 	void CloseTimer(TimerID timerID);
 
+	// When a timer created now for the local time fires. A time skipped by a daylight saving time change
+	// is moved forward by the change, a repeated time is its first pass, unless that is over.
+	boost::posix_time::ptime LocalToUTC(const boost::posix_time::ptime& local);
+
+	// With the offset in effect at the time.
+	boost::posix_time::ptime UTCToLocal(const boost::posix_time::ptime& utc);
+
 private:
+	// dueTime is in the SetWaitableTimer format: UTC FILETIME, or negative 100 ns intervals from now.
+	TimerID CreateTimerWithDueTime(const LARGE_INTEGER& dueTime, const boost::posix_time::time_duration& period, bool wakeup);
+
 	LARGE_INTEGER PTime2LARGE_INTEGER(const boost::posix_time::ptime& pt);
 	HANDLE CancelTimerWithID(TimerID timerID);
 
 	// Called on a background thread when done waiting.
 	static void CALLBACK DoneWaiting(void* param, BOOLEAN timedOut);
 
+	struct PendingRelease
+	{
+		TimersManager* pManager;
+		HANDLE timerHandle;
+		HANDLE waitObjectHandle;
+		AsyncCall::CallbackPtr pCallback;
+	};
+
+	// Called on a thread pool thread, takes ownership of PendingRelease.
+	static DWORD WINAPI ReleaseTimer(void* param);
+
 private:
 	TimerID m_nextTimerID;
 
@@ -47,4 +76,9 @@ private:
 	};
 
 	std::map<TimerID, TimerDescr> m_timerID2Descr;
+
+	// Number of closed timers whose resources haven't been released yet.
+	std::atomic<long> m_pendingReleases;
+
+	LocalTimeZone m_timeZone;
 };
\ No newline at end of file
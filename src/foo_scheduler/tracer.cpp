@@ -0,0 +1,130 @@
+#include "pch.h"
+#include "tracer.h"
+
+namespace Tracer
+{
+
+namespace
+{
+	const unsigned int capacity = 16384;
+	const std::size_t maxNameLength = 47;
+
+	struct Record
+	{
+		__int64 startTime;
+		__int64 duration; // -1 for an instant.
+		unsigned __int64 track;
+		const char* category;
+		char name[maxNameLength + 1];
+	};
+
+	std::atomic<bool> s_enabled(false);
+
+	// Index of the next record to write, grows monotonically. Records are overwritten in place,
+	// an export running concurrently with recording may see a partially written record.
+	std::atomic<unsigned int> s_next(0);
+	Record s_records[capacity];
+
+	void Write(const char* category, const char* name, __int64 startTime, __int64 duration, unsigned __int64 track)
+	{
+		Record& record = s_records[s_next.fetch_add(1, std::memory_order_relaxed) % capacity];
+
+		record.startTime = startTime;
+		record.duration = duration;
+		record.track = track != 0 ? track : ::GetCurrentThreadId();
+		record.category = category;
+
+		strncpy_s(record.name, name, _TRUNCATE);
+	}
+
+	void AppendJsonString(std::string& out, const char* str)
+	{
+		out += '"';
+
+		for (const char* p = str; *p; ++p)
+		{
+			const unsigned char c = static_cast<unsigned char>(*p);
+
+			if (c == '"' || c == '\\')
+			{
+				out += '\\';
+				out += *p;
+			}
+			else if (c < 0x20)
+			{
+				out += boost::str(boost::format("\\u%04x") % static_cast<int>(c));
+			}
+			else
+			{
+				out += *p;
+			}
+		}
+
+		out += '"';
+	}
+
+} // namespace
+
+bool IsEnabled()
+{
+	return s_enabled.load(std::memory_order_relaxed);
+}
+
+void Enable(bool enable)
+{
+	// A new recording doesn't mix with the previous one.
+	if (enable && !IsEnabled())
+		Clear();
+
+	s_enabled.store(enable, std::memory_order_relaxed);
+}
+
+void RecordSpan(const char* category, const char* name, __int64 startTime, __int64 endTime, unsigned __int64 track)
+{
+	if (IsEnabled())
+		Write(category, name, startTime, std::max<__int64>(endTime - startTime, 0), track);
+}
+
+void RecordInstant(const char* category, const char* name, unsigned __int64 track)
+{
+	if (IsEnabled())
+		Write(category, name, Metrics::NowMicroseconds(), -1, track);
+}
+
+std::string ExportChromeJson()
+{
+	const unsigned int next = s_next.load(std::memory_order_relaxed);
+	const unsigned int count = std::min(next, capacity);
+
+	std::string result = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	for (unsigned int i = next - count; i != next; ++i)
+	{
+		const Record& record = s_records[i % capacity];
+
+		if (i != next - count)
+			result += ',';
+
+		result += "\n{\"name\":";
+		AppendJsonString(result, record.name);
+		result += ",\"cat\":";
+		AppendJsonString(result, record.category);
+
+		if (record.duration < 0)
+			result += boost::str(boost::format(",\"ph\":\"i\",\"s\":\"t\",\"ts\":%1%") % record.startTime);
+		else
+			result += boost::str(boost::format(",\"ph\":\"X\",\"ts\":%1%,\"dur\":%2%") % record.startTime % record.duration);
+
+		result += boost::str(boost::format(",\"pid\":1,\"tid\":%1%}") % record.track);
+	}
+
+	result += "\n]}\n";
+	return result;
+}
+
+void Clear()
+{
+	s_next.store(0, std::memory_order_relaxed);
+}
+
+} // namespace Tracer
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "metrics.h"
+
+// Execution tracer: a fixed-size ring buffer of timestamped spans which can be exported
+// in Chrome trace-event format (chrome://tracing, Perfetto). Disabled by default, then every call
+// costs a single atomic load. Recording doesn't allocate memory and may be done from any thread.
+namespace Tracer
+{
+	bool IsEnabled();
+
+	// Starting a recording clears the spans recorded before, stopping keeps them for export.
+	void Enable(bool enable);
+
+	// Times are Metrics::NowMicroseconds() values. Spans with equal track are displayed on the same row,
+	// track 0 means the calling thread. Names are truncated to a few dozen characters.
+	void RecordSpan(const char* category, const char* name, __int64 startTime, __int64 endTime,
+		unsigned __int64 track = 0);
+	void RecordInstant(const char* category, const char* name, unsigned __int64 track = 0);
+
+	// Records the lifetime of the object as a span.
+	class ScopedSpan : boost::noncopyable
+	{
+	public:
+		ScopedSpan(const char* category, const char* name, unsigned __int64 track = 0) :
+			m_category(category), m_name(name), m_track(track), m_startTime(IsEnabled() ? Metrics::NowMicroseconds() : -1)
+		{
+		}
+
+		~ScopedSpan()
+		{
+			if (m_startTime >= 0 && IsEnabled())
+				RecordSpan(m_category, m_name, m_startTime, Metrics::NowMicroseconds(), m_track);
+		}
+
+	private:
+		const char* m_category;
+		const char* m_name;
+		unsigned __int64 m_track;
+		__int64 m_startTime;
+	};
+
+	// Recorded spans, the oldest first, as a Chrome trace-event JSON document.
+	std::string ExportChromeJson();
+
+	// Drops all recorded spans.
+	void Clear();
+
+} // namespace Tracer
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "track_query_cache.h"
+
+namespace
+{
+	// Enough for the current track and going back and forth in a playlist.
+	const std::size_t maxCachedTracks = 16;
+}
+
+TrackQueryCache::TrackQueryCache()
+{
+}
+
+void TrackQueryCache::Clear()
+{
+	m_queryIDs.clear();
+	m_filters.clear();
+	m_tracks.clear();
+}
+
+TrackQueryCache::QueryID TrackQueryCache::AddQuery(const std::wstring& query)
+{
+	const std::wstring key = boost::trim_copy(query);
+
+	if (key.empty())
+		return anyTrack;
+
+	auto it = m_queryIDs.find(key);
+	if (it != m_queryIDs.end())
+		return it->second;
+
+	const QueryID id = m_filters.size();
+	m_filters.push_back(Compile(key));
+	m_queryIDs.insert(std::make_pair(key, id));
+
+	return id;
+}
+
+bool TrackQueryCache::Matches(QueryID id, const metadb_handle_ptr& track)
+{
+	if (id == anyTrack)
+		return true;
+
+	_ASSERTE(id < m_filters.size());
+
+	if (m_filters[id].is_empty() || track.is_empty())
+		return false;
+
+	TrackResults& trackResults = GetTrackResults(track);
+
+	if (trackResults.info.is_empty())
+		return false;
+
+	// Queries added after the track was cached.
+	if (trackResults.results.size() < m_filters.size())
+		trackResults.results.resize(m_filters.size(), resultUnknown);
+
+	char& result = trackResults.results[id];
+
+	if (result == resultUnknown)
+		result = m_filters[id]->test(track, trackResults.info->info()) ? resultTrue : resultFalse;
+
+	return result == resultTrue;
+}
+
+TrackQueryCache::TrackResults& TrackQueryCache::GetTrackResults(const metadb_handle_ptr& track)
+{
+	metadb_info_container::ptr info;
+	track->get_info_ref(info);
+
+	auto it = std::find_if(m_tracks.begin(), m_tracks.end(),
+		[&track] (const TrackResults& r) { return r.track == track; });
+
+	if (it != m_tracks.end())
+	{
+		if (it != m_tracks.begin())
+		{
+			TrackResults moved = *it;
+			m_tracks.erase(it);
+			m_tracks.push_front(moved);
+		}
+	}
+	else
+	{
+		m_tracks.push_front(TrackResults());
+		m_tracks.front().track = track;
+
+		if (m_tracks.size() > maxCachedTracks)
+			m_tracks.pop_back();
+	}
+
+	TrackResults& trackResults = m_tracks.front();
+
+	// Info containers are replaced, not modified, when tags are edited.
+	if (trackResults.info != info)
+	{
+		trackResults.info = info;
+		trackResults.results.assign(m_filters.size(), resultUnknown);
+	}
+
+	return trackResults;
+}
+
+search_filter::ptr TrackQueryCache::Compile(const std::wstring& query)
+{
+	try
+	{
+		return static_api_ptr_t<search_filter_manager>()->create(
+			pfc::stringcvt::string_utf8_from_wide(query.c_str()));
+	}
+	catch (const std::exception&)
+	{
+		return search_filter::ptr();
+	}
+}
+
+bool TrackQueryCache::Validate(const std::wstring& query, std::wstring& error)
+{
+	if (boost::trim_copy(query).empty())
+		return true;
+
+	try
+	{
+		static_api_ptr_t<search_filter_manager>()->create(
+			pfc::stringcvt::string_utf8_from_wide(query.c_str()));
+	}
+	catch (const std::exception& e)
+	{
+		error = pfc::stringcvt::string_wide_from_utf8(e.what()).get_ptr();
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+// Compiled track queries (the media library search syntax) shared by all events.
+// Identical queries are compiled once and evaluated at most once per track,
+// results are kept until the track's info changes.
+class TrackQueryCache : private boost::noncopyable
+{
+public:
+	typedef std::size_t QueryID;
+
+	// Matches all tracks.
+	static const QueryID anyTrack = static_cast<QueryID>(-1);
+
+	TrackQueryCache();
+
+	// Drops all queries and results.
+	void Clear();
+
+	// Returns the ID of an identical query if it was already added.
+	// An invalid query never matches.
+	QueryID AddQuery(const std::wstring& query);
+
+	bool Matches(QueryID id, const metadb_handle_ptr& track);
+
+	// Returns false and the reason if the query can't be compiled.
+	static bool Validate(const std::wstring& query, std::wstring& error);
+
+private:
+	static search_filter::ptr Compile(const std::wstring& query);
+
+	struct TrackResults
+	{
+		metadb_handle_ptr track;
+		metadb_info_container::ptr info;
+		std::vector<char> results; // resultUnknown, resultFalse or resultTrue.
+	};
+
+	enum { resultUnknown = 0, resultFalse, resultTrue };
+
+	TrackResults& GetTrackResults(const metadb_handle_ptr& track);
+
+private:
+	std::map<std::wstring, QueryID> m_queryIDs;
+	std::vector<search_filter::ptr> m_filters; // Null for invalid queries.
+
+	// Recently played tracks, the latest first.
+	std::deque<TrackResults> m_tracks;
+};
\ No newline at end of file
@@ -3,7 +3,7 @@
 #define PLUGIN_NAME "Scheduler mod"
 
 #define COMPONENT_VERSION_MAJOR 4
-#define COMPONENT_VERSION_MINOR 21
+#define COMPONENT_VERSION_MINOR 22
 #define COMPONENT_VERSION_PATCH 0
 #define COMPONENT_VERSION_SUB_PATCH 0
 
@@ -48,7 +48,11 @@
 // To support correct upgrade from the 3rd version of the plugin.
 #define PLUGIN_CFG_GLOBAL_V4_19 0x0040
 #define PLUGIN_CFG_GLOBAL_V4_19_FLDS 6
-#define PLUGIN_CFG_GLOBAL_VERSION 0x0041
+#define PLUGIN_CFG_GLOBAL_V4_21 0x0041
+#define PLUGIN_CFG_GLOBAL_V4_21_FLDS 7
+// Compact encoding: varint field ids, lengths and counts, string table and GUID dictionary.
+#define PLUGIN_CFG_GLOBAL_V4_22 0x0042
+#define PLUGIN_CFG_GLOBAL_VERSION PLUGIN_CFG_GLOBAL_V4_22
 #define PLUGIN_CFG_GLOBAL_VERSION_FLDS 7
 
 #define PLUGIN_ABOUT \
@@ -67,6 +71,27 @@
 "Thanks to Andrew Smolko for developing the foo_scheduler project (up to version 4.19).\n" \
 "\n" \
 "Changelog:\n" \
+  "\n" \
+  "= 4.22\n" \
+  "* Added fade curve and step options to 'Set volume' action.\n" \
+  "* Smaller configuration format, older configurations are converted on load.\n" \
+  "* Added 'Dump statistics', 'Save statistics' and 'Reset statistics' menu commands: event lateness, task and action timings.\n" \
+  "* Added execution tracing, the trace can be opened in chrome://tracing or Perfetto.\n" \
+  "* Added 'Shared variable' action: variables visible to all tasks, optionally kept after restart.\n" \
+  "* Added event conditions and 'If condition' action: time, weekday, playback state, volume, shared variables and track fields.\n" \
+  "* Added playback position events: fire at a position from the start or before the end of every track.\n" \
+  "* New track player events can be limited to tracks matching a query, e.g. genre IS jazz.\n" \
+  "* Date/time events can fire occurrences missed while the player was closed or the computer slept.\n" \
+  "* 'Launch application' can wait for the application to exit, with a timeout and output capture.\n" \
+  "* Assigning a task to many selected events redraws the event list once.\n" \
+  "* Added import and export of events and tasks as JSON lines on the preferences page.\n" \
+  "* Stopping tasks no longer blocks the player while running delays and fades are torn down.\n" \
+  "* Added a task option for a run triggered while the task is running: run in parallel, skip, restart or queue.\n" \
+  "* Added task priority. Steps of running tasks share the main thread in short slices, higher priority first.\n" \
+  "* Added 'Call task' action, which runs another task and then continues. Calls that would never end are refused.\n" \
+  "* Status window lists every upcoming date/time event firing of the next 7 days with its time.\n" \
+  "* Added exception calendars: named sets of dates, such as holidays, daily and weekly events can skip or be limited to.\n" \
+  "* Fixed date/time events scheduled across a daylight saving time change firing an hour off. Skipped times fire after the change, repeated times fire once.\n" \
   "\n" \
   "= 4.21\n" \
   "* 'Action list' renamed 'Task'.\n" \